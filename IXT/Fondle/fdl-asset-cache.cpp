@@ -0,0 +1,49 @@
+/*
+*/
+#include <IXT/asset-cache.hpp>
+#include <IXT/tempo.hpp>
+
+using namespace IXT;
+
+#define COUT_WIDTH std::setw( 32 )
+
+
+int main() {
+    AssetCache cache{ std::filesystem::temp_directory_path() / "ixt-fdl-asset-cache" };
+
+    std::cout << COUT_WIDTH << "Cache: " << cache.dir().string() << "\n\n";
+
+    Ticker tick{};
+
+    Endec::Image rammus = Endec::ImageDecoders::decode( std::filesystem::path{ ASSET_PNG_RAMMUS_PATH } );
+    double decode_ms = tick.lap< TICK_MILLIS >();
+
+    for( int pass = 0; pass < 2; ++pass ) {
+        tick.lap();
+        Endec::Image img = cache.image( ASSET_PNG_RAMMUS_PATH );
+        double ms = tick.lap< TICK_MILLIS >();
+
+        std::cout << COUT_WIDTH << ( pass ? "rammus.png, cached: " : "rammus.png, first: " ) << ms << "ms ( decode alone " << decode_ms << "ms"
+                  << ( img.pixels == rammus.pixels ? "" : ", MISMATCH" ) << " )\n";
+    }
+
+    tick.lap();
+    Endec::Wav< float > sax{ ASSET_WAV_SAX_PATH };
+    decode_ms = tick.lap< TICK_MILLIS >();
+
+    for( int pass = 0; pass < 2; ++pass ) {
+        Endec::Wav< float > wav;
+
+        tick.lap();
+        cache.wav( ASSET_WAV_SAX_PATH, wav );
+        double ms = tick.lap< TICK_MILLIS >();
+
+        bool same = wav.sample_count == sax.sample_count
+                    && std::memcmp( wav.stream.get(), sax.stream.get(), sax.sample_count * sax.tunnel_count * sizeof( float ) ) == 0;
+
+        std::cout << COUT_WIDTH << ( pass ? "sax.wav, cached: " : "sax.wav, first: " ) << ms << "ms ( decode alone " << decode_ms << "ms"
+                  << ( same ? "" : ", MISMATCH" ) << " )\n";
+    }
+
+    std::cout << '\n' << COUT_WIDTH << "Hits / misses: " << cache.hit_count() << " / " << cache.miss_count() << '\n';
+}
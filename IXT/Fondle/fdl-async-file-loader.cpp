@@ -0,0 +1,117 @@
+/*
+Scene load, serial through the loaders against batched through AsyncFileLoader. Every asset is pulled in a few
+times over, as a scene pulls in dozens of files. The first pass is only cold if the OS file cache is, for cold
+numbers flush it ( reboot, or empty the standby list ) and run with "serial" or "async" alone.
+*/
+#include <IXT/async-file-loader.hpp>
+#include <IXT/endec.hpp>
+#include <IXT/tempo.hpp>
+
+using namespace IXT;
+
+#define COUT_WIDTH std::setw( 32 )
+
+
+constexpr int COPIES = 4;
+constexpr int PASSES = 6;
+
+enum ASSET : int { ASSET_IMAGE, ASSET_WAV, ASSET_BLOB };
+
+struct Asset {
+    std::filesystem::path   path;
+    ASSET                   kind;
+};
+
+size_t decode_wav( std::span< const ubyte_t > bytes ) {
+    std::ispanstream in{ std::span< const char >{ ( const char* )bytes.data(), bytes.size() } };
+    Endec::WavFmt    fmt;
+
+    if( Endec::wav_riff_walk( in, fmt ) != 0 || fmt.data_ofs + fmt.data_size > bytes.size() ) return 0;
+
+    const size_t         count = fmt.frame_count() * fmt.tunnel_count;
+    std::vector< float > samples( count );
+
+    Endec::wav_decode< float >( ( const char* )bytes.data() + fmt.data_ofs, samples.data(), count, fmt );
+    return count;
+}
+
+size_t load_serial( const std::vector< Asset >& scene ) {
+    size_t units = 0;
+
+    for( auto& asset : scene ) {
+        switch( asset.kind ) {
+            case ASSET_IMAGE: units += Endec::ImageDecoders::decode( asset.path ).pixels.size(); break;
+            case ASSET_WAV: {
+                Endec::Wav< float > wav{ asset.path.string() };
+                units += wav.sample_count * wav.tunnel_count;
+            break; }
+            case ASSET_BLOB: units += File::Map{ asset.path }.size(); break;
+        }
+    }
+
+    return units;
+}
+
+size_t load_async( const std::vector< Asset >& scene, AsyncFileLoader& loader ) {
+    std::vector< std::future< size_t > > futures;
+    futures.reserve( scene.size() );
+
+    for( auto& asset : scene ) {
+        futures.emplace_back( loader.load( asset.path, [ kind = asset.kind ] ( AsyncFileLoader::Loaded& file ) -> size_t {
+            switch( kind ) {
+                case ASSET_IMAGE: return Endec::ImageDecoders::decode( file.span() ).pixels.size();
+                case ASSET_WAV:   return decode_wav( file.span() );
+                default:          return file.size;
+            }
+        } ) );
+    }
+
+    loader.submit();
+
+    size_t units = 0;
+    for( auto& future : futures ) units += future.get();
+
+    return units;
+}
+
+
+int main( int argc, char* argv[] ) {
+    const std::string_view only = argc > 1 ? argv[ 1 ] : "";
+
+    std::vector< Asset > scene;
+
+    for( int copy = 0; copy < COPIES; ++copy ) {
+        for( auto& entry : std::filesystem::directory_iterator{ ASSETS_DIR } ) {
+            auto ext = entry.path().extension().string();
+
+            ASSET kind = ext == ".png" || ext == ".bmp" ? ASSET_IMAGE
+                       : ext == ".wav" ? ASSET_WAV
+                       : ASSET_BLOB;
+
+            scene.push_back( { entry.path(), kind } );
+        }
+    }
+
+    std::cout << COUT_WIDTH << "Files per scene: " << scene.size() << "\n\n";
+
+    AsyncFileLoader loader{};
+    Ticker          tick{};
+
+    auto bench = [ & ] ( const char* name, auto&& load ) -> void {
+        double first = 0.0, warm = 0.0;
+        size_t units = 0;
+
+        for( int pass = 0; pass < PASSES; ++pass ) {
+            tick.lap();
+            units = load();
+            double ms = tick.lap< TICK_MILLIS >();
+
+            ( pass == 0 ? first : warm ) += ms;
+        }
+
+        std::cout << COUT_WIDTH << name << "first " << first << "ms | warm " << warm / ( PASSES - 1 ) << "ms | " << units << " units\n";
+    };
+
+    if( only != "async" ) bench( "serial: ", [ & ] () -> size_t { return load_serial( scene ); } );
+    if( only != "serial" ) bench( "async: ", [ & ] () -> size_t { return load_async( scene, loader ); } );
+}
@@ -0,0 +1,110 @@
+/*
+Block filters. First the legacy audio_filtering loop, a 50 tap FIR one output at a time, against FirFilter's direct
+path, then a long kernel direct against partitioned FFT, and an 8 stage biquad cascade, all over stereo noise. Then
+the sax through a low pass cascade, a synth through a peak, and the master bus through a long FIR, rendered offline.
+Run with a duration in seconds to change it.
+*/
+#include <IXT/audio.hpp>
+
+#include <random>
+
+using namespace IXT;
+
+#define COUT_WIDTH std::setw( 32 )
+
+
+constexpr uint32_t SAMPLE_RATE    = 48'000;
+constexpr WORD     TUNNELS        = 2;
+constexpr uint32_t BLOCK_FRAMES   = 256;
+
+
+int main( int argc, char* argv[] ) {
+    const double SECS = argc > 1 ? std::stod( argv[ 1 ] ) : 10.0;
+
+    const size_t frames = SECS * SAMPLE_RATE;
+
+    std::mt19937                               rng{ 7 };
+    std::uniform_real_distribution< double >   noise{ -1.0, 1.0 };
+
+    std::vector< double > source( frames * TUNNELS );
+    for( auto& s : source ) s = noise( rng );
+
+    std::cout << COUT_WIDTH << "Stereo noise: " << SECS << "s at " << SAMPLE_RATE << "Hz, in blocks of " << BLOCK_FRAMES << ".\n\n";
+
+    Ticker tick{};
+
+    auto bench = [ & ] ( const char* name, AudioFilter& filter ) -> void {
+        std::vector< double > block = source;
+
+        tick.lap();
+        for( size_t at = 0; at < frames; at += BLOCK_FRAMES )
+            filter.process( block.data() + at * TUNNELS, std::min< size_t >( BLOCK_FRAMES, frames - at ), TUNNELS );
+        double secs = tick.lap();
+
+        std::cout << COUT_WIDTH << name << SECS / secs << "x realtime | latency " << filter.latency() << " frames\n";
+    };
+
+    {
+        /* As in Legacy/audio_filtering.cpp, per tunnel, bounds checked at every tap. */
+        FirFilter             legacy = FirFilter::alternating( 50 );
+        const auto&           taps   = legacy.taps();
+        std::vector< double > out( source.size() );
+
+        tick.lap();
+        for( WORD tunnel = 0; tunnel < TUNNELS; ++tunnel )
+            for( size_t idx = 0; idx < frames; ++idx ) {
+                double sum = 0.0;
+
+                for( size_t k = 0; k < taps.size(); ++k ) {
+                    if( k > idx ) continue;
+                    sum += taps[ k ] * source[ ( idx - k ) * TUNNELS + tunnel ];
+                }
+
+                out[ idx * TUNNELS + tunnel ] = sum;
+            }
+        double secs = tick.lap();
+
+        std::cout << COUT_WIDTH << "legacy loop, 50 taps: " << SECS / secs << "x realtime\n";
+
+        bench( "direct, 50 taps: ", legacy );
+    }
+
+    {
+        FirFilter direct = FirFilter::low_pass( SAMPLE_RATE, 4'000.0, 4'096, FIR_FILTER_MODE_DIRECT );
+        FirFilter fft    = FirFilter::low_pass( SAMPLE_RATE, 4'000.0, 4'096, FIR_FILTER_MODE_FFT );
+
+        bench( "direct, 4096 taps: ", direct );
+        bench( "fft, 4096 taps: ", fft );
+    }
+
+    {
+        BiquadCascade cascade{};
+        for( int n = 0; n < 8; ++n ) cascade.push( Biquad::peak( SAMPLE_RATE, 100.0 * ( 2 << n ), 1.0, n % 2 ? 3.0 : -3.0 ) );
+
+        bench( "biquads, 8 stages: ", cascade );
+    }
+
+    std::cout << '\n';
+
+    {
+        auto audio = HVEC< Audio >::alloc( audio_offline_init_t{}, SAMPLE_RATE, TUNNELS, BLOCK_FRAMES );
+
+        auto sax = HVEC< Sound >::alloc( audio, ASSET_WAV_SAX_PATH );
+        sax->block_filter_with( std::make_shared< BiquadCascade >( std::vector< Biquad >{
+            Biquad::low_pass( SAMPLE_RATE, 1'200.0 ), Biquad::low_pass( SAMPLE_RATE, 1'200.0 )
+        } ) );
+
+        auto synth = HVEC< Synth >::alloc( audio, Synth::gen_sine( 0.2, 440.0 ), SECS );
+        synth->block_filter_with( std::make_shared< BiquadCascade >( std::vector< Biquad >{ Biquad::peak( SAMPLE_RATE, 440.0, 2.0, 6.0 ) } ) );
+
+        audio->block_filter_with( std::make_shared< FirFilter >( FirFilter::low_pass( SAMPLE_RATE, 8'000.0, 1'024 ) ) );
+
+        audio->play( sax );
+        audio->play( synth );
+
+        std::vector< int > pcm;
+        double ratio = audio->render_to( pcm, SECS ).realtime_ratio;
+
+        std::cout << COUT_WIDTH << "Filtered sax, synth and bus: " << ratio << "x realtime\n";
+    }
+}
@@ -0,0 +1,109 @@
+/*
+Voice churn through Audio's command queue. Producer threads play short synths out of their own pools at a set rate,
+10k plays per second in total by default, with stops and volume changes mixed in, while the mixer thread renders
+offline blocks paced to real time. The synths go over as owning handles, so each play comes back through the
+retire ring to be released on a producer. Run with a rate and a duration in seconds to change them.
+*/
+#include <IXT/audio.hpp>
+
+#include <random>
+
+using namespace IXT;
+
+#define COUT_WIDTH std::setw( 32 )
+
+
+constexpr int      PRODUCERS      = 4;
+constexpr uint32_t SAMPLE_RATE    = 48'000;
+constexpr uint32_t BLOCK_FRAMES   = 256;
+constexpr size_t   POOL           = 128;
+
+
+int main( int argc, char* argv[] ) {
+    const double RATE = argc > 1 ? std::stod( argv[ 1 ] ) : 10'000.0;
+    const double SECS = argc > 2 ? std::stod( argv[ 2 ] ) : 5.0;
+
+    auto audio = HVEC< Audio >::alloc( audio_offline_init_t{}, SAMPLE_RATE, 2, BLOCK_FRAMES );
+
+    std::atomic< bool >     powered   = true;
+    std::atomic< size_t >   posted    = 0;
+
+    std::cout << COUT_WIDTH << "Plays per second: " << RATE << ", over " << SECS << "s, from " << PRODUCERS << " threads.\n";
+    std::cout << COUT_WIDTH << "Voices: " << Audio::VOICE_CAPACITY << ", command queue: " << Audio::COMMAND_CAPACITY << "\n\n";
+
+    /* The mixer, a block per pacer tick. */
+    size_t late_count  = 0;
+    size_t block_count = 0;
+    double block_worst = 0.0;
+    double block_total = 0.0;
+
+    std::thread mixer{ [ & ] () -> void {
+        FramePacer   pacer{ ( double )SAMPLE_RATE / BLOCK_FRAMES, std::chrono::nanoseconds{ 0 } };
+        const double budget = ( double )BLOCK_FRAMES / SAMPLE_RATE;
+
+        while( powered.load( std::memory_order_relaxed ) ) {
+            double secs = audio->render( BLOCK_FRAMES, [] ( const int*, size_t ) -> void {} ).secs;
+
+            block_worst  = std::max( block_worst, secs );
+            block_total += secs;
+            late_count  += secs > budget;
+            ++block_count;
+
+            pacer.wait();
+        }
+    } };
+
+    /* Built up front, echoes are not meant for many threads at once. */
+    std::mt19937                                    rng{ 7 };
+    std::uniform_real_distribution< double >        freq{ 110.0, 880.0 };
+    std::vector< std::vector< HVEC< Synth > > >     pools( PRODUCERS );
+
+    for( auto& pool : pools )
+        for( size_t n = 0; n < POOL; ++n )
+            pool.push_back( HVEC< Synth >::alloc( audio, Synth::gen_sine( 0.01, freq( rng ) ), 0.02 ) );
+
+    std::vector< std::thread > producers;
+
+    for( int p = 0; p < PRODUCERS; ++p ) {
+        producers.emplace_back( [ &, p ] () -> void {
+            std::mt19937                              rng{ ( unsigned )p };
+            std::uniform_int_distribution< int >      action{ 0, 15 };
+
+            auto& pool = pools[ p ];
+
+            FramePacer   pacer{ 1'000.0, std::chrono::nanoseconds{ 0 } };
+            const double per_tick = RATE / 1'000.0 / PRODUCERS;
+            double       due      = 0.0;
+            size_t       at       = 0;
+
+            for( size_t tick = 0; tick < SECS * 1'000.0; ++tick ) {
+                for( due += per_tick; due >= 1.0; due -= 1.0 ) {
+                    HVEC< Wave > wave = pool[ at++ % POOL ];
+
+                    switch( action( rng ) ) {
+                        case 0: audio->stop( wave ); continue;
+                        case 1: audio->volume_at( wave, 0.5 ); break;
+                    }
+
+                    audio->play( wave );
+
+                    posted.fetch_add( 1, std::memory_order_relaxed );
+                }
+
+                pacer.wait();
+            }
+        } );
+    }
+
+    for( auto& producer : producers ) producer.join();
+
+    std::this_thread::sleep_for( std::chrono::milliseconds{ 100 } );
+    powered.store( false, std::memory_order_relaxed );
+    mixer.join();
+
+    std::cout << COUT_WIDTH << "Plays posted: " << posted.load() << " | commands dropped: " << audio->dropped_count()
+              << " | plays refused for lack of a voice: " << audio->refused_count() << '\n';
+    std::cout << COUT_WIDTH << "Blocks: " << block_count << " | late: " << late_count
+              << " | avg " << block_total * 1e3 / std::max< size_t >( block_count, 1 ) << "ms | worst " << block_worst * 1e3
+              << "ms, of " << 1e3 * BLOCK_FRAMES / SAMPLE_RATE << "ms\n";
+}
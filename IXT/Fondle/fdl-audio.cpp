@@ -26,6 +26,8 @@ int main() {
         { '2', HVEC< Sound >::alloc( audio, ASSET_WAV_GANGNAM_PATH ) },
         { '3', HVEC< Sound >::alloc( audio, ASSET_WAV_90S_PATH ) },
         { 't', HVEC< Sound >::alloc( audio, ASSET_WAV_NOAA_PATH ) },
+        { 's', HVEC< SoundStream >::alloc( audio, ASSET_WAV_90S_PATH, 0.5 ) },
+        { 'p', HVEC< Sound >::alloc( audio, ASSET_WAV_SAX_PATH, SOUND_FLAG_MAPPED ) },
         { 'q', HVEC< Synth >::alloc( audio, Synth::gen_sine( 0.5, 220 ), 3.0 ) },
         { 'w', HVEC< Synth >::alloc( audio, Synth::gen_sine( 0.5, 440 ), 3.0 ) },
         { 'e', HVEC< Synth >::alloc( audio, Synth::gen_sine( 0.5, 880 ), 3.0 ) },
@@ -35,12 +37,15 @@ int main() {
 
     std::string_view menu_str = 
     "[ 1, 2, 3, t ] - play waves.\n"
+    "[ s ]          - play streamed wave.\n"
+    "[ p ]          - play mapped wave.\n"
     "[ q, w, e, r ] /\n"
     "[ 4, 5 ]       - volume down/up.\n"
     "[ 6, 7 ]       - velocity down/up.\n"
     "[ m ]          - mute all.\n"
     "[ 8 ]          - loop all.\n"
     "[ 9 ]          - stop all.\n"
+    "[ b ]          - offline render bench.\n"
     "[ 0 ]          - exit.\n";
 
     auto crs = OS::console.crs();
@@ -73,6 +78,17 @@ int main() {
                 case '9':
                     audio->stop();
                     break;
+
+                case 'b': {
+                    auto offline = HVEC< Audio >::alloc( audio_offline_init_t{}, sample_wav.sample_rate, sample_wav.tunnel_count, 256 );
+
+                    offline->play( HVEC< Sound >::alloc( offline, ASSET_WAV_SAX_PATH ) );
+                    offline->play( HVEC< Synth >::alloc( offline, Synth::gen_sine( 0.5, 440 ), 10.0 ) );
+
+                    auto stats = offline->render_to( "fdl-audio-render.wav", 10.0 );
+                    
+                    std::cout << "\nRendered " << stats.frame_count * sample_wav.tunnel_count / stats.secs << " samples/sec.";
+                    break; }
             }
         }
 
@@ -0,0 +1,107 @@
+/*
+*/
+#include <IXT/bit-manip.hpp>
+#include <IXT/tempo.hpp>
+
+#include <numbers>
+#include <random>
+
+using namespace IXT;
+
+#define COUT_WIDTH std::setw( 32 )
+
+
+/* A smooth closed path, quantized to 1e-6, as .clst2 vertices would be. */
+std::vector< int64_t > make_path( size_t count ) {
+    std::vector< int64_t > coords( count * 2 );
+    std::mt19937           rng{ 7 };
+
+    for( size_t n = 0; n < count; ++n ) {
+        double t = 2.0 * std::numbers::pi * n / count;
+        double r = 0.5 + 0.05 * std::sin( 9 * t ) + 1e-4 * ( rng() % 100 );
+
+        coords[ n * 2 ]     = std::llround( r * std::cos( t ) * 1e6 );
+        coords[ n * 2 + 1 ] = std::llround( r * std::sin( t ) * 1e6 );
+    }
+
+    return coords;
+}
+
+
+int main() {
+    constexpr size_t COUNT = 1 << 22;
+
+    std::mt19937 rng{ 1 };
+
+    std::vector< uint64_t > fixed( COUNT );
+    for( auto& v : fixed ) v = rng() & 0x1FFF;
+
+    std::vector< uint64_t > small( COUNT );
+    for( auto& v : small ) v = rng() >> ( rng() % 32 );
+
+    std::vector< int64_t > path = make_path( COUNT / 2 );
+
+    std::cout << COUT_WIDTH << "Values per case: " << COUNT << "\n\n";
+
+    auto report = [] ( const char* name, double enc_ms, double dec_ms, size_t bytes, size_t raw_bytes, bool ok ) -> void {
+        std::cout << COUT_WIDTH << name
+                  << "enc " << raw_bytes / enc_ms / 1e3 << " MB/s | dec " << raw_bytes / dec_ms / 1e3 << " MB/s | "
+                  << bytes << " bytes, " << 100.0 * bytes / raw_bytes << "% of raw"
+                  << ( ok ? "" : " | MISMATCH" ) << '\n';
+    };
+
+    Ticker tick{};
+
+    {
+        BitWriter w{ COUNT * 2 };
+        tick.lap();
+        for( auto v : fixed ) w.write( v, 13 );
+        auto bytes = w.release();
+        double enc = tick.lap< TICK_MILLIS >();
+
+        BitReader r{ bytes };
+        bool ok = true;
+        for( auto v : fixed ) ok &= r.read( 13 ) == v;
+        double dec = tick.lap< TICK_MILLIS >();
+
+        report( "fixed 13 bits: ", enc, dec, bytes.size(), COUNT * 2, ok && !r.overrun() );
+    }
+
+    {
+        BitWriter w{ COUNT * 4 };
+        tick.lap();
+        for( auto v : small ) w.write_varint( v );
+        auto bytes = w.release();
+        double enc = tick.lap< TICK_MILLIS >();
+
+        BitReader r{ bytes };
+        bool ok = true;
+        for( auto v : small ) ok &= r.read_varint() == v;
+        double dec = tick.lap< TICK_MILLIS >();
+
+        report( "varint, skewed u32: ", enc, dec, bytes.size(), COUNT * 4, ok && !r.overrun() );
+    }
+
+    {
+        BitWriter w{ COUNT * 2 };
+        tick.lap();
+        int64_t prev[ 2 ] = {};
+        for( size_t n = 0; n < path.size(); ++n ) {
+            w.write_zigzag( path[ n ] - prev[ n & 1 ] );
+            prev[ n & 1 ] = path[ n ];
+        }
+        auto bytes = w.release();
+        double enc = tick.lap< TICK_MILLIS >();
+
+        BitReader r{ bytes };
+        bool    ok = true;
+        int64_t acc[ 2 ] = {};
+        for( size_t n = 0; n < path.size(); ++n ) {
+            acc[ n & 1 ] += r.read_zigzag();
+            ok &= acc[ n & 1 ] == path[ n ];
+        }
+        double dec = tick.lap< TICK_MILLIS >();
+
+        report( "zigzag vertex deltas: ", enc, dec, bytes.size(), path.size() * sizeof( float ), ok && !r.overrun() );
+    }
+}
@@ -10,4 +10,13 @@ int main() {
         std::cout << path << std::endl;
         return 0;
     } );
-}
\ No newline at end of file
+
+    std::cout << '\n';
+
+    std::mutex mtx;
+    File::scan( ASSETS_DIR, File::Pattern::glob( "*.wav" ), [ & ] ( const std::filesystem::path& path ) -> IXT::DWORD {
+        std::unique_lock< std::mutex > lock{ mtx };
+        std::cout << path.string() << std::endl;
+        return 0;
+    }, true );
+}
@@ -0,0 +1,50 @@
+/*
+*/
+#include <IXT/endec.hpp>
+#include <IXT/tempo.hpp>
+
+using namespace IXT;
+
+#define COUT_WIDTH std::setw( 32 )
+
+
+int main() {
+    constexpr int BATCH = 32;
+
+    std::vector< std::filesystem::path > paths;
+    for( int n = 0; n < BATCH; ++n )
+        paths.emplace_back( n % 2 ? ASSET_PNG_RAMMUS_PATH : ASSET_BMP_AHRI_PATH );
+
+    std::cout << COUT_WIDTH << "Batch: " << BATCH << " x { ahri.bmp, rammus.png }\n";
+    std::cout << COUT_WIDTH << "Workers: " << ThreadPool::shared().thread_count() << "\n\n";
+
+    Ticker tick{};
+
+    size_t pixel_count = 0;
+    for( auto& path : paths )
+        pixel_count += Endec::ImageDecoders::decode( path ).view().pixel_count();
+
+    double serial_ms = tick.lap< TICK_MILLIS >();
+
+    size_t async_pixel_count = 0;
+    for( auto& future : Endec::ImageDecoders::decode_async( paths ) )
+        async_pixel_count += future.get().view().pixel_count();
+
+    double async_ms = tick.lap< TICK_MILLIS >();
+
+    std::cout << COUT_WIDTH << "serial: " << serial_ms << "ms ( " << pixel_count / serial_ms / 1000.0 << " MP/s )\n";
+    std::cout << COUT_WIDTH << "decode_async: " << async_ms << "ms ( x" << serial_ms / async_ms << ( async_pixel_count == pixel_count ? "" : ", MISMATCH" ) << " )\n";
+
+    /* Every miss echoes an error from its worker, so the echoes race each other on four threads at once. */
+    std::vector< std::filesystem::path > missing;
+    for( int n = 0; n < 64; ++n )
+        missing.emplace_back( std::filesystem::temp_directory_path() / ( "ixt-fdl-missing-" + std::to_string( n ) + ".png" ) );
+
+    ThreadPool pool{ 4 };
+    size_t     failed = 0;
+
+    for( auto& future : Endec::ImageDecoders::decode_async( missing, Endec::PIXEL_ORDER_RGBA, pool ) )
+        failed += future.get().view().pixel_count() == 0;
+
+    std::cout << '\n' << COUT_WIDTH << "missing, 4 workers: " << failed << " of " << missing.size() << " failed, as they should\n";
+}
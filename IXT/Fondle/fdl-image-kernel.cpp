@@ -0,0 +1,91 @@
+/*
+*/
+#include <IXT/endec.hpp>
+#include <IXT/image-kernel.hpp>
+#include <IXT/tempo.hpp>
+
+using namespace IXT;
+
+#define COUT_WIDTH std::setw( 32 )
+
+
+/* Legacy/image_filtering.cpp's conv(), per tap, per channel, kept as the reference. */
+void legacy_conv( const ImageKernel& filter, const ImageView& src, const ImageView& dst ) {
+    const int32_t rx = filter.width() / 2, ry = filter.height() / 2;
+
+    for( int32_t y = 0; y < src.height; ++y ) {
+        for( int32_t x = 0; x < src.width; ++x ) {
+            float sum[ 4 ] = {};
+
+            for( int32_t dy = -ry; dy <= ry; ++dy )
+                for( int32_t dx = -rx; dx <= rx; ++dx ) {
+                    int32_t ny = y + dy, nx = x + dx;
+                    if( ny < 0 || ny >= src.height || nx < 0 || nx >= src.width ) continue;
+
+                    for( int32_t c = 0; c < src.channels; ++c )
+                        sum[ c ] += filter( dy, dx ) * src.at( nx, ny )[ c ];
+                }
+
+            for( int32_t c = 0; c < src.channels; ++c )
+                dst.at( x, y )[ c ] = ( ubyte_t )std::clamp( std::nearbyint( sum[ c ] ), 0.0f, 255.0f );
+        }
+    }
+}
+
+int max_diff( const ImageView& a, const ImageView& b ) {
+    int diff = 0;
+
+    for( int32_t y = 0; y < a.height; ++y )
+        for( size_t n = 0; n < a.row_size(); ++n )
+            diff = std::max( diff, std::abs( a.row( y )[ n ] - b.row( y )[ n ] ) );
+
+    return diff;
+}
+
+
+int main() {
+    Endec::Bmp bmp{ ASSET_BMP_AHRI_PATH };
+    ImageView  src = bmp.view();
+
+    std::vector< ubyte_t > ref_buf( src.row_size() * src.height );
+    std::vector< ubyte_t > out_buf( src.row_size() * src.height );
+
+    ImageView ref{ .base = ref_buf.data(), .stride = ( ptrdiff_t )src.row_size(), .width = src.width, .height = src.height, .channels = src.channels };
+    ImageView out{ .base = out_buf.data(), .stride = ( ptrdiff_t )src.row_size(), .width = src.width, .height = src.height, .channels = src.channels };
+
+    std::cout << COUT_WIDTH << "Image: " << src.width << "x" << src.height << "x" << src.channels << '\n';
+    std::cout << COUT_WIDTH << "Workers: " << ThreadPool::shared().thread_count() << "\n\n";
+
+    struct Case {
+        const char*   name;
+        ImageKernel   kernel;
+    } cases[] = {
+        { name: "gaussian_high( 13, 27 )", kernel: ImageKernel::gaussian_high( 13, 27 ) },
+        { name: "gaussian( 15, 3 )",       kernel: ImageKernel::gaussian( 15, 3 ) },
+        { name: "gaussian_high( 41, 27 )", kernel: ImageKernel::gaussian_high( 41, 27 ) }
+    };
+
+    for( auto& [ name, kernel ] : cases ) {
+        Ticker tick{};
+
+        legacy_conv( kernel, src, ref );
+        double legacy_ms = tick.lap< TICK_MILLIS >();
+
+        std::cout << name << ( kernel.is_separable() ? ", separable" : "" ) << '\n';
+        std::cout << COUT_WIDTH << "legacy: " << legacy_ms << "ms\n";
+
+        for( auto mode : { IMAGE_KERNEL_MODE_SEPARABLE, IMAGE_KERNEL_MODE_DIRECT, IMAGE_KERNEL_MODE_FFT } ) {
+            if( mode == IMAGE_KERNEL_MODE_SEPARABLE && !kernel.is_separable() ) continue;
+
+            tick.lap();
+            kernel.apply( src, out, mode );
+            double ms = tick.lap< TICK_MILLIS >();
+
+            static const char* mode_names[] = { "auto: ", "separable: ", "direct: ", "fft: " };
+
+            std::cout << COUT_WIDTH << mode_names[ mode ] << ms << "ms ( x" << legacy_ms / ms << ", max diff " << max_diff( ref, out ) << " )\n";
+        }
+
+        std::cout << '\n';
+    }
+}
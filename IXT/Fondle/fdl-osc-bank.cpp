@@ -0,0 +1,60 @@
+/*
+A thousand voices on one OscBank, sines, saws and squares under ADSR envelopes, against as many plain Synths played
+through Audio, both rendered offline on one thread. Half the bank is let go midway, so the release tails and the
+voice sweep are in the timing too. Run with a voice count and a duration in seconds to change them.
+*/
+#include <IXT/osc-bank.hpp>
+
+using namespace IXT;
+
+#define COUT_WIDTH std::setw( 32 )
+
+
+constexpr uint32_t SAMPLE_RATE    = 48'000;
+constexpr uint32_t BLOCK_FRAMES   = 256;
+
+
+int main( int argc, char* argv[] ) {
+    const size_t VOICES = argc > 1 ? std::stoull( argv[ 1 ] ) : 1'000;
+    const double SECS   = argc > 2 ? std::stod( argv[ 2 ] ) : 10.0;
+
+    std::cout << COUT_WIDTH << "Voices: " << VOICES << ", over " << SECS << "s at " << SAMPLE_RATE << "Hz.\n\n";
+
+    {
+        auto audio = HVEC< Audio >::alloc( audio_offline_init_t{}, SAMPLE_RATE, 2, BLOCK_FRAMES );
+        auto bank  = HVEC< OscBank >::alloc( audio, VOICES );
+
+        const OSC_SHAPE shapes[] = { OSC_SHAPE_SINE, OSC_SHAPE_SAW, OSC_SHAPE_SQUARE };
+
+        for( size_t n = 0; n < VOICES; ++n )
+            bank->note_on( n, shapes[ n % 3 ], 55.0 + n * 1.7, 0.5 / VOICES, OscEnvelope{ attack: 0.01, decay: 0.2, sustain: 0.6, release: 0.5 } );
+
+        audio->play( bank );
+
+        std::vector< int > pcm;
+        double ratio = audio->render_to( pcm, SECS / 2.0 ).realtime_ratio;
+
+        for( size_t n = 0; n < VOICES; n += 2 ) bank->note_off( n );
+        ratio = ( ratio + audio->render_to( pcm, SECS / 2.0 ).realtime_ratio ) / 2.0;
+
+        std::cout << COUT_WIDTH << "OscBank: " << ratio << "x realtime | " << ratio * VOICES << " voices per core | "
+                  << bank->active_count() << " still playing, " << bank->refused_count() << " refused\n";
+    }
+
+    {
+        auto audio = HVEC< Audio >::alloc( audio_offline_init_t{}, SAMPLE_RATE, 2, BLOCK_FRAMES );
+
+        std::vector< HVEC< Synth > > synths;
+
+        for( size_t n = 0; n < std::min< size_t >( VOICES, Audio::VOICE_CAPACITY ); ++n ) {
+            synths.push_back( HVEC< Synth >::alloc( audio, Synth::gen_sine( 0.5 / VOICES, 55.0 + n * 1.7 ), SECS ) );
+            audio->play( synths.back() );
+        }
+
+        std::vector< int > pcm;
+        double ratio = audio->render_to( pcm, SECS ).realtime_ratio;
+
+        std::cout << COUT_WIDTH << "Synth: " << ratio << "x realtime | " << ratio * synths.size() << " voices per core | "
+                  << synths.size() << " playing, as many as Audio takes\n";
+    }
+}
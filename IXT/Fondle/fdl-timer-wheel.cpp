@@ -0,0 +1,79 @@
+/*
+A million live timers on TimerWheel, against a std::multimap keyed on the due time, the ordered map being what a
+scheduler usually starts out as. Arming and canceling are timed on both, lateness on the wheel only. Run with a
+count to change how many.
+*/
+#include <IXT/timer-wheel.hpp>
+
+#include <random>
+
+using namespace IXT;
+
+#define COUT_WIDTH std::setw( 32 )
+
+
+int main( int argc, char* argv[] ) {
+    const size_t COUNT = argc > 1 ? std::stoull( argv[ 1 ] ) : 1'000'000;
+
+    std::mt19937                          rng{ 7 };
+    std::uniform_int_distribution< int >  delay_ms{ 10, 2'000 };
+
+    std::vector< std::chrono::milliseconds > delays( COUNT );
+    for( auto& d : delays ) d = std::chrono::milliseconds{ delay_ms( rng ) };
+
+    std::cout << COUT_WIDTH << "Timers: " << COUNT << ", due in 10ms to 2s, every 4th canceled.\n\n";
+
+    Ticker tick{};
+
+    {
+        std::multimap< TscClock::time_point, std::function< void() > > map;
+        std::vector< decltype( map )::iterator >                        ids;
+        ids.reserve( COUNT );
+
+        tick.lap();
+        for( auto d : delays ) ids.push_back( map.emplace( TscClock::now() + d, [] () -> void {} ) );
+        double arm = tick.lap< TICK_NANOS >() / COUNT;
+
+        for( size_t n = 0; n < COUNT; n += 4 ) map.erase( ids[ n ] );
+        double cancel = tick.lap< TICK_NANOS >() / ( COUNT / 4 );
+
+        std::cout << COUT_WIDTH << "multimap: " << "arm " << arm << "ns | cancel " << cancel << "ns\n";
+    }
+
+    {
+        TimerWheel wheel{};
+        wheel.reserve( COUNT );
+
+        std::vector< TimerId > ids;
+        ids.reserve( COUNT );
+
+        /* Callbacks run inline on the wheel thread, one at a time. */
+        size_t   fired      = 0;
+        int64_t  late_total = 0;
+        int64_t  late_worst = 0;
+
+        tick.lap();
+        for( auto d : delays ) {
+            ids.push_back( wheel.after( d, [ &, due = TscClock::now() + d ] () -> void {
+                int64_t late = ( TscClock::now() - due ).count();
+
+                late_total += late;
+                late_worst  = std::max( late_worst, late );
+                ++fired;
+            } ) );
+        }
+        double arm = tick.lap< TICK_NANOS >() / COUNT;
+
+        size_t canceled = 0;
+        for( size_t n = 0; n < COUNT; n += 4 ) canceled += wheel.cancel( ids[ n ] );
+        double cancel = tick.lap< TICK_NANOS >() / ( COUNT / 4 );
+
+        while( wheel.active_count() != 0 )
+            std::this_thread::sleep_for( std::chrono::milliseconds{ 50 } );
+        std::this_thread::sleep_for( std::chrono::milliseconds{ 50 } );
+
+        std::cout << COUT_WIDTH << "wheel: " << "arm " << arm << "ns | cancel " << cancel << "ns | "
+                  << fired << " fired, " << canceled << " canceled | late avg " << late_total / 1e3 / std::max< size_t >( fired, 1 )
+                  << "us, worst " << late_worst / 1e3 << "us\n";
+    }
+}
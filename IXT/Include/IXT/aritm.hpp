@@ -6,6 +6,7 @@
 #include <IXT/bit-manip.hpp>
 #include <IXT/comms.hpp>
 #include <IXT/concepts.hpp>
+#include <IXT/file-manip.hpp>
 
 namespace _ENGINE_NAMESPACE {
 
@@ -587,23 +588,25 @@ public:
     {}
 
     Clust2( std::string_view path, _ENGINE_COMMS_ECHO_ARG ) {
-        std::ifstream file{ path.data() };
+        File::Map map{ path, FILE_MAP_MODE_READ, FILE_MAP_HINT_SEQUENTIAL, echo };
 
-        if( !file ) {
-            echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.data() << "\".";
+        if( !map ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Could NOT map file: \"" << path.data() << "\".";
             return;
         }
 
+        constexpr size_t META_SIZE = sizeof( XtFdx ) + 1 + sizeof( dword_t );
+
         struct _Meta {
-            _Meta( std::ifstream& file, _ENGINE_COMMS_ECHO_ARG ) {
-                file.read( ( char* )&xtfdx, sizeof( xtfdx ) );
+            _Meta( const char* src ) {
+                std::memcpy( &xtfdx, src, sizeof( xtfdx ) );
 
-                ubyte_t src = file.get();
+                ubyte_t flags = src[ sizeof( xtfdx ) ];
 
-                mode = src & 0b11;
-                org = ( src >> 2 ) & 0b1;
+                mode = flags & 0b11;
+                org = ( flags >> 2 ) & 0b1;
 
-                file.read( ( char* )&count, sizeof( count ) );
+                std::memcpy( &count, src + sizeof( xtfdx ) + 1, sizeof( count ) );
             }
 
             XtFdx   xtfdx = 0;
@@ -611,7 +614,25 @@ public:
             ubyte_t mode:2;
             ubyte_t org:1; 
 
-        } meta{ file, echo };
+        };
+
+        /* Files written through text mode streams carry "\r\n" for every '\n', the binary header included. */
+        std::string_view text = map.view();
+        char             header[ META_SIZE ];
+
+        for( size_t n = 0; n < META_SIZE; ++n ) {
+            if( text.starts_with( "\r\n" ) ) text.remove_prefix( 1 );
+
+            if( text.empty() ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "File: \"" << path.data() << "\" is too short for a header.";
+                return;
+            }
+
+            header[ n ] = text.front();
+            text.remove_prefix( 1 );
+        }
+
+        _Meta meta{ header };
 
         if( meta.xtfdx != FDX_CLUST2 ) 
             echo( this, ECHO_LEVEL_WARNING ) << "XtFdx of file: \"" << path.data() << "\" does not match this structure's XtFdx.";
@@ -622,26 +643,19 @@ public:
             case 0b00: {
                 dword_t read_count = 0;
 
-                if( meta.org ) {
-                    if( file.eof() ) goto l_end;
-                    file >> _origin.x; ++read_count;
-                    if( file.eof() ) goto l_end;
-                    file >> _origin.y; ++read_count;
-                }
+                if( meta.org && !( _scan( text, _origin.x ) && _scan( text, _origin.y ) ) )
+                    echo( this, ECHO_LEVEL_WARNING ) << "Origin flagged but missing.";
 
-l_read_vrtx:
-                if( ( read_count >> 1 ) == meta.count || file.eof() ) goto l_end;
-                file >> _vrtx.emplace_back().second.x; 
-                _vrtx.back().first.x = _vrtx.back().second.x;
-                ++read_count;
+                for( Vec2 vec; ( read_count >> 1 ) < meta.count; ) {
+                    if( !_scan( text, vec.x ) ) break;
+                    ++read_count;
 
-                if( file.eof() ) goto l_end;
-                file >> _vrtx.back().second.y; 
-                _vrtx.back().first.y = _vrtx.back().second.y;
-                ++read_count;
+                    if( !_scan( text, vec.y ) ) break;
+                    ++read_count;
+
+                    _vrtx.emplace_back( vec, vec );
+                }
 
-                goto l_read_vrtx;
-l_end:
                 if( ( read_count >> 1 ) != meta.count )
                     echo( this, ECHO_LEVEL_WARNING ) << "Read vertex count ( " << ( read_count >> 1 ) << " ) is different from in-file reported vertex count ( " << meta.count << " ).";
 
@@ -652,8 +666,6 @@ l_end:
             break; }
         }
 
-        file.close();
-
         echo( this, ECHO_LEVEL_OK ) << "Created from: \"" << path.data() << "\".";
     }
 
@@ -1335,26 +1347,44 @@ public:
     }
 
 
+_ENGINE_PROTECTED:
+    /* The next whitespace separated number off the front of text, as operator >> would read it. */
+    template< typename T >
+    static bool _scan( std::string_view& text, T& value ) {
+        size_t at = text.find_first_not_of( " \t\r\n\v\f" );
+
+        if( at != std::string_view::npos && text[ at ] == '+' ) ++at;
+
+        if( at >= text.size() ) { text = {}; return false; }
+
+        auto [ end, ec ] = std::from_chars( text.data() + at, text.data() + text.size(), value );
+
+        if( ec != std::errc{} ) { text = {}; return false; }
+
+        text.remove_prefix( end - text.data() );
+        return true;
+    }
+
 public:
     static Clust2 from_file( std::string_view path ) {
-        std::ifstream file( path.data() );
+        File::Map map{ path, FILE_MAP_MODE_READ, FILE_MAP_HINT_SEQUENTIAL };
+
+        if( !map ) return {};
 
-        if( !file ) return {};
+        std::string_view text = map.view();
 
         Vec2 org = {};
 
         std::vector< Vec2 > vrtx = {};
 
         {
-            bool has_origin = false;
-
-            file >> has_origin;
+            int has_origin = 0;
 
-            if( has_origin )
-                file >> org.x >> org.y;
+            if( _scan( text, has_origin ) && has_origin )
+                _scan( text, org.x ) && _scan( text, org.y );
         }
 
-        for( Vec2 vec; file >> vec.x >> vec.y; )
+        for( Vec2 vec; _scan( text, vec.x ) && _scan( text, vec.y ); )
             vrtx.push_back( vec );
 
         return { org, vrtx };
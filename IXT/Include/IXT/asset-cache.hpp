@@ -0,0 +1,318 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/comms.hpp>
+#include <IXT/endec.hpp>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+enum ASSET_KIND : uint32_t {
+    ASSET_KIND_BLOB      = 0,
+    ASSET_KIND_IMAGE     = 1,
+    ASSET_KIND_PCM_F32   = 2,
+    ASSET_KIND_VERTICES  = 3,
+
+    _ASSET_KIND_FORCE_DWORD = 0x7F'FF'FF'FF
+};
+
+/*
+On-disk layout of one cache entry: this header, then the payload at payload_ofs, PAYLOAD_ALIGN aligned, so a
+mapped entry can be used in place. dims hold whatever the kind needs to rebuild its object ( width, height, ... ).
+*/
+struct AssetCacheHeader {
+    char       magic[ 4 ]        = { 'I', 'X', 'T', 'C' };
+    uint32_t   layout_version    = 1;
+    uint32_t   kind              = ASSET_KIND_BLOB;
+    uint32_t   decoder_version   = 0;
+    uint64_t   content_hash      = 0;
+    uint64_t   payload_size      = 0;
+    uint64_t   payload_ofs       = 0;
+    uint64_t   dims[ 4 ]         = {};
+};
+
+static_assert( sizeof( AssetCacheHeader ) == 72 );
+
+
+
+/*
+Decoded assets keyed by a hash of the source bytes, the kind and the decoder version. A hit costs hashing the source
+plus one read of the ready representation, no parsing. Bumping a decoder version orphans its old entries.
+*/
+class AssetCache : public Descriptor {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "AssetCache" );
+
+public:
+    inline static constexpr uint32_t   LAYOUT_VERSION    = 1;
+    inline static constexpr uint64_t   PAYLOAD_ALIGN     = 64;
+
+    inline static constexpr uint32_t   IMAGE_DECODER_VERSION   = 1;
+    inline static constexpr uint32_t   PCM_DECODER_VERSION     = 1;
+
+public:
+    AssetCache( std::filesystem::path dir = std::filesystem::temp_directory_path() / "ixt-asset-cache", _ENGINE_COMMS_ECHO_ARG )
+    : _dir{ std::move( dir ) }
+    {
+        std::error_code ec;
+        std::filesystem::create_directories( _dir, ec );
+
+        if( ec ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Could NOT create cache directory: \"" << _dir.string() << "\", " << ec.message() << ".";
+            _dir.clear();
+            return;
+        }
+
+        echo( this, ECHO_LEVEL_OK ) << "Created at: \"" << _dir.string() << "\".";
+    }
+
+_ENGINE_PROTECTED:
+    std::filesystem::path   _dir            = {};
+    std::atomic< size_t >   _hit_count      = { 0 };
+    std::atomic< size_t >   _miss_count     = { 0 };
+
+public:
+    /* XXH64, seed 0. */
+    static uint64_t hash( std::span< const ubyte_t > bytes ) {
+        constexpr uint64_t P1 = 11400714785074694791ull, P2 = 14029467366897019727ull, P3 = 1609587929392839161ull;
+        constexpr uint64_t P4 = 9650029242287828579ull,  P5 = 2870177450012600261ull;
+
+        auto rotl  = [] ( uint64_t x, int r ) -> uint64_t { return ( x << r ) | ( x >> ( 64 - r ) ); };
+        auto round = [ & ] ( uint64_t acc, uint64_t lane ) -> uint64_t { return rotl( acc + lane * P2, 31 ) * P1; };
+        auto merge = [ & ] ( uint64_t acc, uint64_t v ) -> uint64_t { return ( acc ^ round( 0, v ) ) * P1 + P4; };
+        auto load8 = [] ( const ubyte_t* p ) -> uint64_t { uint64_t v; std::memcpy( &v, p, 8 ); return v; };
+        auto load4 = [] ( const ubyte_t* p ) -> uint64_t { uint32_t v; std::memcpy( &v, p, 4 ); return v; };
+
+        const ubyte_t* p   = bytes.data();
+        const ubyte_t* end = p + bytes.size();
+        uint64_t       h;
+
+        if( bytes.size() >= 32 ) {
+            uint64_t v1 = P1 + P2, v2 = P2, v3 = 0, v4 = 0 - P1;
+
+            for( ; p + 32 <= end; p += 32 ) {
+                v1 = round( v1, load8( p ) );
+                v2 = round( v2, load8( p + 8 ) );
+                v3 = round( v3, load8( p + 16 ) );
+                v4 = round( v4, load8( p + 24 ) );
+            }
+
+            h = rotl( v1, 1 ) + rotl( v2, 7 ) + rotl( v3, 12 ) + rotl( v4, 18 );
+            h = merge( h, v1 ); h = merge( h, v2 ); h = merge( h, v3 ); h = merge( h, v4 );
+        } else {
+            h = P5;
+        }
+
+        h += bytes.size();
+
+        for( ; p + 8 <= end; p += 8 ) h = rotl( h ^ round( 0, load8( p ) ), 27 ) * P1 + P4;
+        if( p + 4 <= end ) { h = rotl( h ^ ( load4( p ) * P1 ), 23 ) * P2 + P3; p += 4; }
+        for( ; p < end; ++p ) h = rotl( h ^ ( *p * P5 ), 11 ) * P1;
+
+        h ^= h >> 33; h *= P2;
+        h ^= h >> 29; h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+    static std::vector< ubyte_t > read_all( const std::filesystem::path& path ) {
+        File::Map map{ path, FILE_MAP_MODE_READ, FILE_MAP_HINT_SEQUENTIAL };
+        if( !map ) return {};
+
+        return { map.data(), map.data() + map.size() };
+    }
+
+public:
+    explicit operator bool () const { return !_dir.empty(); }
+
+    const std::filesystem::path& dir() const { return _dir; }
+
+    size_t hit_count() const { return _hit_count.load( std::memory_order_relaxed ); }
+    size_t miss_count() const { return _miss_count.load( std::memory_order_relaxed ); }
+
+    std::filesystem::path entry_path( uint64_t content_hash, uint32_t kind, uint32_t decoder_version ) const {
+        char name[ 48 ];
+        std::snprintf( name, sizeof( name ), "%016llx-%x-%x.ixtc", ( unsigned long long )content_hash, kind, decoder_version );
+        return _dir / name;
+    }
+
+public:
+    /* Fills header and payload on a valid entry. Anything stale, truncated or foreign is a miss. */
+    bool load( uint64_t content_hash, uint32_t kind, uint32_t decoder_version, AssetCacheHeader& header, std::vector< ubyte_t >& payload ) {
+        if( !*this ) return false;
+
+        std::ifstream file{ this->entry_path( content_hash, kind, decoder_version ), std::ios_base::binary };
+
+        bool valid = file
+                     && file.read( ( char* )&header, sizeof( header ) )
+                     && std::memcmp( header.magic, "IXTC", 4 ) == 0
+                     && header.layout_version == LAYOUT_VERSION
+                     && header.kind == kind
+                     && header.decoder_version == decoder_version
+                     && header.content_hash == content_hash
+                     && header.payload_ofs >= sizeof( header );
+
+        if( valid ) {
+            payload.resize( header.payload_size );
+            file.seekg( header.payload_ofs );
+            valid = ( bool )file.read( ( char* )payload.data(), header.payload_size );
+        }
+
+        ( valid ? _hit_count : _miss_count ).fetch_add( 1, std::memory_order_relaxed );
+        return valid;
+    }
+
+    /* Written to a temporary then renamed over, so concurrent readers never see half an entry. */
+    bool store( AssetCacheHeader header, std::span< const ubyte_t > payload, _ENGINE_COMMS_ECHO_ARG ) {
+        if( !*this ) return false;
+
+        header.layout_version = LAYOUT_VERSION;
+        header.payload_size   = payload.size();
+        header.payload_ofs    = ( ( sizeof( header ) + PAYLOAD_ALIGN - 1 ) / PAYLOAD_ALIGN ) * PAYLOAD_ALIGN;
+
+        const auto path = this->entry_path( header.content_hash, header.kind, header.decoder_version );
+        auto       temp = path;
+        temp += "." + std::to_string( std::hash< std::thread::id >{}( std::this_thread::get_id() ) ) + ".tmp";
+
+        {
+            std::ofstream file{ temp, std::ios_base::binary | std::ios_base::trunc };
+
+            const char zeros[ PAYLOAD_ALIGN ] = {};
+
+            file.write( ( const char* )&header, sizeof( header ) );
+            file.write( zeros, header.payload_ofs - sizeof( header ) );
+            file.write( ( const char* )payload.data(), payload.size() );
+
+            if( !file ) {
+                echo( this, ECHO_LEVEL_WARNING ) << "Could NOT write entry: \"" << temp.string() << "\".";
+                file.close();
+                std::filesystem::remove( temp );
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename( temp, path, ec );
+
+        if( ec ) {
+            echo( this, ECHO_LEVEL_WARNING ) << "Could NOT commit entry: \"" << path.string() << "\", " << ec.message() << ".";
+            std::filesystem::remove( temp, ec );
+            return false;
+        }
+
+        return true;
+    }
+
+    /*
+    Generic path for any decoded form. decode( std::span< const ubyte_t > source, AssetCacheHeader& header ) -> std::vector< ubyte_t >
+    fills header.dims and returns the payload, empty on failure. On a hit it is never called.
+    */
+    template< typename Decode >
+    std::vector< ubyte_t > fetch(
+        const std::filesystem::path& path,
+        uint32_t                     kind,
+        uint32_t                     decoder_version,
+        Decode&&                     decode,
+        AssetCacheHeader&            header,
+        _ENGINE_COMMS_ECHO_ARG
+    ) {
+        File::Map source{ path, FILE_MAP_MODE_READ, FILE_MAP_HINT_SEQUENTIAL, echo };
+
+        if( !source ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Could NOT read: \"" << path.string() << "\".";
+            return {};
+        }
+
+        const uint64_t content_hash = hash( source.bytes() );
+
+        std::vector< ubyte_t > payload;
+        if( this->load( content_hash, kind, decoder_version, header, payload ) )
+            return payload;
+
+        header                 = AssetCacheHeader{};
+        header.kind            = kind;
+        header.decoder_version = decoder_version;
+        header.content_hash    = content_hash;
+
+        payload = std::invoke( decode, source.bytes(), header );
+
+        if( !payload.empty() )
+            this->store( header, payload, echo );
+
+        return payload;
+    }
+
+public:
+    /* dims: width, height, pixel order. */
+    Endec::Image image( const std::filesystem::path& path, Endec::PIXEL_ORDER order = Endec::PIXEL_ORDER_RGBA, _ENGINE_COMMS_ECHO_ARG ) {
+        AssetCacheHeader header;
+
+        auto pixels = this->fetch( path, ASSET_KIND_IMAGE, IMAGE_DECODER_VERSION, [ & ] ( std::span< const ubyte_t > source, AssetCacheHeader& hdr ) -> std::vector< ubyte_t > {
+            Endec::Image img = Endec::ImageDecoders::decode( source, order, echo );
+
+            hdr.dims[ 0 ] = img.width;
+            hdr.dims[ 1 ] = img.height;
+            hdr.dims[ 2 ] = img.order;
+            return std::move( img.pixels );
+        }, header, echo );
+
+        Endec::Image img;
+        if( pixels.empty() ) return img;
+
+        img.width  = ( int32_t )header.dims[ 0 ];
+        img.height = ( int32_t )header.dims[ 1 ];
+        img.order  = ( Endec::PIXEL_ORDER )header.dims[ 2 ];
+        img.pixels = std::move( pixels );
+
+        return img.reorder( order );
+    }
+
+    /* dims: sample rate, tunnel count, frame count, source bits per sample. Samples as interleaved floats. */
+    bool wav( const std::filesystem::path& path, Endec::Wav< float >& wav, _ENGINE_COMMS_ECHO_ARG ) {
+        AssetCacheHeader header;
+
+        /* Off the very bytes that were hashed, the file is not read again. */
+        auto samples = this->fetch( path, ASSET_KIND_PCM_F32, PCM_DECODER_VERSION, [ & ] ( std::span< const ubyte_t > source, AssetCacheHeader& hdr ) -> std::vector< ubyte_t > {
+            std::ispanstream in{ std::span< const char >{ ( const char* )source.data(), source.size() } };
+            Endec::WavFmt    fmt;
+
+            if( Endec::wav_riff_walk( in, fmt, echo ) != 0 ) return {};
+
+            if( fmt.data_ofs + fmt.data_size > source.size() ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Truncated data chunk in: \"" << path.string() << "\".";
+                return {};
+            }
+
+            hdr.dims[ 0 ] = fmt.sample_rate;
+            hdr.dims[ 1 ] = fmt.tunnel_count;
+            hdr.dims[ 2 ] = fmt.frame_count();
+            hdr.dims[ 3 ] = fmt.bits_per_sample;
+
+            const size_t           count = fmt.frame_count() * fmt.tunnel_count;
+            std::vector< ubyte_t > raw( count * sizeof( float ) );
+
+            Endec::wav_decode< float >( ( const char* )source.data() + fmt.data_ofs, ( float* )raw.data(), count, fmt );
+            return raw;
+        }, header, echo );
+
+        if( samples.empty() ) return false;
+
+        wav.sample_rate     = ( DWORD )header.dims[ 0 ];
+        wav.tunnel_count    = ( WORD )header.dims[ 1 ];
+        wav.sample_count    = header.dims[ 2 ];
+        wav.bits_per_sample = ( uint16_t )header.dims[ 3 ];
+
+        wav.stream.vector( ( float* )malloc( samples.size() ) );
+        std::memcpy( wav.stream.get(), samples.data(), samples.size() );
+
+        return true;
+    }
+
+};
+
+
+
+};
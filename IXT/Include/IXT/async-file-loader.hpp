@@ -0,0 +1,351 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/comms.hpp>
+#include <IXT/thread-pool.hpp>
+
+#if !defined( _ENGINE_OS_WINDOWS )
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+enum ASYNC_FILE_LOADER_MODE : BYTE {
+    ASYNC_FILE_LOADER_MODE_AUTO,
+    /* Overlapped reads, reaped off an I/O completion port. Windows only. */
+    ASYNC_FILE_LOADER_MODE_PORT,
+    /* Blocking reads, one pool task per file. */
+    ASYNC_FILE_LOADER_MODE_POOL
+};
+
+/*
+Whole-file reads, in batches. load() stages a file along with what to do with its bytes, submit() issues every
+staged read at once. Continuations run on the pool as soon as their own file is in, so decoding overlaps the
+reads still in flight. Reads go through overlapped I/O and a completion port where there is one, otherwise
+through blocking reads on the pool.
+*/
+class AsyncFileLoader : public Descriptor {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "AsyncFileLoader" );
+
+public:
+    /* The buffer is left uninitialized before the read, zeroing it first costs about as much as the copy. */
+    struct Loaded {
+        std::filesystem::path    path    = {};
+        UPtr< ubyte_t[] >        bytes   = nullptr;
+        size_t                   size    = 0;
+        bool                     ok      = false;
+
+        explicit operator bool () const { return ok; }
+
+        std::span< const ubyte_t > span() const { return { bytes.get(), size }; }
+
+        void alloc( size_t count ) {
+            bytes.reset( new ubyte_t[ count ] );
+            size = count;
+        }
+    };
+
+    /* Largest single read, ReadFile counts in DWORDs. */
+    inline static constexpr size_t   READ_CHUNK   = 1 << 30;
+
+public:
+    AsyncFileLoader(
+        ThreadPool&              pool   = ThreadPool::shared(),
+        ASYNC_FILE_LOADER_MODE   mode   = ASYNC_FILE_LOADER_MODE_AUTO,
+        _ENGINE_COMMS_ECHO_ARG
+    ) : _pool{ &pool } {
+    #if defined( _ENGINE_OS_WINDOWS )
+        if( mode != ASYNC_FILE_LOADER_MODE_POOL ) {
+            _port = CreateIoCompletionPort( INVALID_HANDLE_VALUE, NULL, 0, 1 );
+
+            if( _port != NULL ) {
+                _mode   = ASYNC_FILE_LOADER_MODE_PORT;
+                _reaper = std::thread{ &AsyncFileLoader::_reap, this };
+            } else {
+                echo( this, ECHO_LEVEL_WARNING ) << "Could NOT create a completion port, reading through the pool.";
+            }
+        }
+    #else
+        if( mode == ASYNC_FILE_LOADER_MODE_PORT )
+            echo( this, ECHO_LEVEL_WARNING ) << "Completion ports are Windows only, reading through the pool.";
+    #endif
+
+        echo( this, ECHO_LEVEL_OK ) << "Created, reading through " << ( _mode == ASYNC_FILE_LOADER_MODE_PORT ? "a completion port." : "the pool." );
+    }
+
+    AsyncFileLoader( const AsyncFileLoader& ) = delete;
+    AsyncFileLoader( AsyncFileLoader&& ) = delete;
+
+    ~AsyncFileLoader() {
+        this->submit();
+        this->wait();
+
+    #if defined( _ENGINE_OS_WINDOWS )
+        if( _port != NULL ) {
+            PostQueuedCompletionStatus( _port, 0, _KEY_QUIT, NULL );
+            _reaper.join();
+            CloseHandle( _port );
+        }
+    #endif
+    }
+
+_ENGINE_PROTECTED:
+#if defined( _ENGINE_OS_WINDOWS )
+    inline static constexpr ULONG_PTR   _KEY_READ   = 1;
+    inline static constexpr ULONG_PTR   _KEY_QUIT   = 2;
+
+    /* The OVERLAPPED comes back from the port, the request is recovered from it. */
+    struct _RequestBase : OVERLAPPED {
+        _RequestBase() : OVERLAPPED{} {}
+
+        HANDLE   file   = INVALID_HANDLE_VALUE;
+    };
+#else
+    struct _RequestBase {};
+#endif
+
+    struct _Request : _RequestBase {
+        Loaded                             loaded   = {};
+        std::function< void( Loaded& ) >   then     = {};
+    };
+
+_ENGINE_PROTECTED:
+    ThreadPool*                       _pool        = nullptr;
+    ASYNC_FILE_LOADER_MODE            _mode        = ASYNC_FILE_LOADER_MODE_POOL;
+
+    std::mutex                        _mtx         = {};
+    std::condition_variable           _idle        = {};
+    std::vector< UPtr< _Request > >   _staged      = {};
+    size_t                            _in_flight   = 0;
+
+#if defined( _ENGINE_OS_WINDOWS )
+    HANDLE                            _port        = NULL;
+    std::thread                       _reaper      = {};
+#endif
+
+_ENGINE_PROTECTED:
+    static bool _read_blocking( Loaded& loaded ) {
+    #if defined( _ENGINE_OS_WINDOWS )
+        HANDLE file = CreateFileW( loaded.path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+        if( file == INVALID_HANDLE_VALUE ) return false;
+
+        LARGE_INTEGER size;
+        if( !GetFileSizeEx( file, &size ) ) { CloseHandle( file ); return false; }
+
+        loaded.alloc( size.QuadPart );
+
+        size_t done = 0;
+        for( ::DWORD got = 0; done < loaded.size; done += got ) {
+            DWORD count = ( DWORD )std::min( READ_CHUNK, loaded.size - done );
+            if( !ReadFile( file, loaded.bytes.get() + done, count, &got, NULL ) || got == 0 ) break;
+        }
+
+        CloseHandle( file );
+    #else
+        int file = ::open( loaded.path.c_str(), O_RDONLY | O_CLOEXEC );
+        if( file < 0 ) return false;
+
+        struct stat st;
+        if( ::fstat( file, &st ) != 0 ) { ::close( file ); return false; }
+
+        loaded.alloc( st.st_size );
+
+        size_t done = 0;
+        for( ssize_t got = 0; done < loaded.size; done += got ) {
+            got = ::pread( file, loaded.bytes.get() + done, std::min( READ_CHUNK, loaded.size - done ), done );
+            if( got <= 0 ) break;
+        }
+
+        ::close( file );
+    #endif
+
+        return done == loaded.size;
+    }
+
+    /* Continuation, then bookkeeping. The notify stays under the lock, wait() may be all that keeps this alive. */
+    void _run( _Request* req ) {
+        {
+            UPtr< _Request > own{ req };
+
+            if( !own->loaded.ok ) {
+                own->loaded.bytes.reset();
+                own->loaded.size = 0;
+            }
+            if( own->then ) std::invoke( own->then, own->loaded );
+        }
+
+        std::unique_lock< std::mutex > lock{ _mtx };
+        if( --_in_flight == 0 ) _idle.notify_all();
+    }
+
+#if defined( _ENGINE_OS_WINDOWS )
+    void _complete( _Request* req, bool ok ) {
+        if( req->file != INVALID_HANDLE_VALUE ) CloseHandle( req->file );
+
+        req->file      = INVALID_HANDLE_VALUE;
+        req->loaded.ok = ok;
+
+        _pool->post( [ this, req ] () -> void { this->_run( req ); } );
+    }
+
+    void _read_next( _Request* req ) {
+        const size_t done  = ( ( size_t )req->OffsetHigh << 32 ) | req->Offset;
+        const DWORD  count = ( DWORD )std::min( READ_CHUNK, req->loaded.size - done );
+
+        if( !ReadFile( req->file, req->loaded.bytes.get() + done, count, NULL, req ) && GetLastError() != ERROR_IO_PENDING )
+            this->_complete( req, false );
+    }
+
+    void _issue( _Request* req ) {
+        req->file = CreateFileW( req->loaded.path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+
+        LARGE_INTEGER size;
+
+        if(
+            req->file == INVALID_HANDLE_VALUE
+            || !GetFileSizeEx( req->file, &size )
+            || CreateIoCompletionPort( req->file, _port, _KEY_READ, 0 ) == NULL
+        ) {
+            this->_complete( req, false );
+            return;
+        }
+
+        req->loaded.alloc( size.QuadPart );
+
+        if( req->loaded.size == 0 ) {
+            this->_complete( req, true );
+            return;
+        }
+
+        this->_read_next( req );
+    }
+
+    void _reap() {
+        for(;;) {
+            ::DWORD     got = 0;
+            ULONG_PTR   key = 0;
+            OVERLAPPED* ov  = nullptr;
+
+            BOOL ok = GetQueuedCompletionStatus( _port, &got, &key, &ov, INFINITE );
+
+            if( ov == nullptr ) {
+                if( key == _KEY_QUIT ) return;
+                continue;
+            }
+
+            _Request* req = static_cast< _Request* >( static_cast< _RequestBase* >( ov ) );
+
+            if( !ok || got == 0 ) {
+                this->_complete( req, false );
+                continue;
+            }
+
+            const size_t done = ( ( ( size_t )req->OffsetHigh << 32 ) | req->Offset ) + got;
+
+            req->Offset     = ( DWORD )done;
+            req->OffsetHigh = ( DWORD )( ( uint64_t )done >> 32 );
+
+            if( done < req->loaded.size ) this->_read_next( req );
+            else this->_complete( req, true );
+        }
+    }
+#endif
+
+    void _stage( std::filesystem::path path, std::function< void( Loaded& ) > then ) {
+        auto req = std::make_unique< _Request >();
+
+        req->loaded.path = std::move( path );
+        req->then        = std::move( then );
+
+        std::unique_lock< std::mutex > lock{ _mtx };
+        _staged.emplace_back( std::move( req ) );
+    }
+
+public:
+    static AsyncFileLoader& shared() {
+        static AsyncFileLoader loader{};
+        return loader;
+    }
+
+public:
+    ASYNC_FILE_LOADER_MODE mode() const {
+        return _mode;
+    }
+
+    size_t staged_count() {
+        std::unique_lock< std::mutex > lock{ _mtx };
+        return _staged.size();
+    }
+
+    size_t in_flight_count() {
+        std::unique_lock< std::mutex > lock{ _mtx };
+        return _in_flight;
+    }
+
+public:
+    /* Stages path. op( Loaded& ) runs on the pool once it is read, failed reads included, and its result lands in the future. */
+    template< typename Op >
+    auto load( std::filesystem::path path, Op&& op ) -> std::future< std::invoke_result_t< Op, Loaded& > > {
+        using R = std::invoke_result_t< Op, Loaded& >;
+
+        auto packaged = std::make_shared< std::packaged_task< R( Loaded& ) > >( std::forward< Op >( op ) );
+        auto future   = packaged->get_future();
+
+        this->_stage( std::move( path ), [ packaged ] ( Loaded& loaded ) -> void { ( *packaged )( loaded ); } );
+
+        return future;
+    }
+
+    std::future< Loaded > load( std::filesystem::path path ) {
+        return this->load( std::move( path ), [] ( Loaded& loaded ) -> Loaded { return std::move( loaded ); } );
+    }
+
+    /* Issues every staged read. Returns how many. */
+    size_t submit() {
+        std::vector< UPtr< _Request > > batch;
+
+        {
+            std::unique_lock< std::mutex > lock{ _mtx };
+            batch.swap( _staged );
+            _in_flight += batch.size();
+        }
+
+        for( auto& req : batch ) {
+            _Request* raw = req.release();
+
+        #if defined( _ENGINE_OS_WINDOWS )
+            if( _mode == ASYNC_FILE_LOADER_MODE_PORT ) {
+                this->_issue( raw );
+                continue;
+            }
+        #endif
+
+            _pool->post( [ this, raw ] () -> void {
+                raw->loaded.ok = _read_blocking( raw->loaded );
+                this->_run( raw );
+            } );
+        }
+
+        return batch.size();
+    }
+
+    /* Blocks until every submitted load has run its continuation. Not from inside a pool task. */
+    void wait() {
+        std::unique_lock< std::mutex > lock{ _mtx };
+        _idle.wait( lock, [ this ] () -> bool { return _in_flight == 0; } );
+    }
+
+};
+
+
+
+};
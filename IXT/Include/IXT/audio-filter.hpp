@@ -0,0 +1,511 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/comms.hpp>
+#include <IXT/fft.hpp>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+/*
+Filter over whole blocks, frames interleaved over tunnels, in place. Keeps a state per tunnel, set up on the first
+block or ahead of time through reset(), so one filter goes to one wave.
+*/
+class AudioFilter : public Descriptor {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "AudioFilter" );
+
+public:
+    virtual ~AudioFilter() = default;
+
+public:
+    virtual void process( double* block, size_t frames, WORD tunnels ) = 0;
+
+    /* Clears the state, sized for tunnels. */
+    virtual void reset( WORD tunnels ) = 0;
+
+    /* Frames the output lags behind the input. */
+    virtual size_t latency() const { return 0; }
+
+};
+
+
+
+/* Normalized, a0 being 1. RBJ's cookbook for the factories, freq in Hz. */
+struct Biquad {
+    double   b0   = 1.0;
+    double   b1   = 0.0;
+    double   b2   = 0.0;
+    double   a1   = 0.0;
+    double   a2   = 0.0;
+
+    static Biquad low_pass( double sample_rate, double freq, double q = std::numbers::sqrt2 / 2.0 ) {
+        auto [ cs, alpha ] = _prewarp( sample_rate, freq, q );
+        return _normalized( ( 1.0 - cs ) / 2.0, 1.0 - cs, ( 1.0 - cs ) / 2.0, 1.0 + alpha, -2.0 * cs, 1.0 - alpha );
+    }
+
+    static Biquad high_pass( double sample_rate, double freq, double q = std::numbers::sqrt2 / 2.0 ) {
+        auto [ cs, alpha ] = _prewarp( sample_rate, freq, q );
+        return _normalized( ( 1.0 + cs ) / 2.0, -( 1.0 + cs ), ( 1.0 + cs ) / 2.0, 1.0 + alpha, -2.0 * cs, 1.0 - alpha );
+    }
+
+    /* Unit gain at freq. */
+    static Biquad band_pass( double sample_rate, double freq, double q = 1.0 ) {
+        auto [ cs, alpha ] = _prewarp( sample_rate, freq, q );
+        return _normalized( alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * cs, 1.0 - alpha );
+    }
+
+    static Biquad notch( double sample_rate, double freq, double q = 1.0 ) {
+        auto [ cs, alpha ] = _prewarp( sample_rate, freq, q );
+        return _normalized( 1.0, -2.0 * cs, 1.0, 1.0 + alpha, -2.0 * cs, 1.0 - alpha );
+    }
+
+    static Biquad peak( double sample_rate, double freq, double q, double gain_db ) {
+        auto [ cs, alpha ] = _prewarp( sample_rate, freq, q );
+        const double a = std::pow( 10.0, gain_db / 40.0 );
+        return _normalized( 1.0 + alpha * a, -2.0 * cs, 1.0 - alpha * a, 1.0 + alpha / a, -2.0 * cs, 1.0 - alpha / a );
+    }
+
+    static Biquad low_shelf( double sample_rate, double freq, double gain_db, double q = std::numbers::sqrt2 / 2.0 ) {
+        auto [ cs, alpha ] = _prewarp( sample_rate, freq, q );
+        const double a  = std::pow( 10.0, gain_db / 40.0 );
+        const double sq = 2.0 * std::sqrt( a ) * alpha;
+        return _normalized(
+            a * ( ( a + 1.0 ) - ( a - 1.0 ) * cs + sq ), 2.0 * a * ( ( a - 1.0 ) - ( a + 1.0 ) * cs ), a * ( ( a + 1.0 ) - ( a - 1.0 ) * cs - sq ),
+            ( a + 1.0 ) + ( a - 1.0 ) * cs + sq, -2.0 * ( ( a - 1.0 ) + ( a + 1.0 ) * cs ), ( a + 1.0 ) + ( a - 1.0 ) * cs - sq
+        );
+    }
+
+    static Biquad high_shelf( double sample_rate, double freq, double gain_db, double q = std::numbers::sqrt2 / 2.0 ) {
+        auto [ cs, alpha ] = _prewarp( sample_rate, freq, q );
+        const double a  = std::pow( 10.0, gain_db / 40.0 );
+        const double sq = 2.0 * std::sqrt( a ) * alpha;
+        return _normalized(
+            a * ( ( a + 1.0 ) + ( a - 1.0 ) * cs + sq ), -2.0 * a * ( ( a - 1.0 ) + ( a + 1.0 ) * cs ), a * ( ( a + 1.0 ) + ( a - 1.0 ) * cs - sq ),
+            ( a + 1.0 ) - ( a - 1.0 ) * cs + sq, 2.0 * ( ( a - 1.0 ) - ( a + 1.0 ) * cs ), ( a + 1.0 ) - ( a - 1.0 ) * cs - sq
+        );
+    }
+
+    static std::pair< double, double > _prewarp( double sample_rate, double freq, double q ) {
+        const double w = 2.0 * std::numbers::pi * std::clamp( freq / sample_rate, 1e-6, 0.499 );
+        return { std::cos( w ), std::sin( w ) / ( 2.0 * q ) };
+    }
+
+    static Biquad _normalized( double b0, double b1, double b2, double a0, double a1, double a2 ) {
+        return Biquad{ b0: b0 / a0, b1: b1 / a0, b2: b2 / a0, a1: a1 / a0, a2: a2 / a0 };
+    }
+};
+
+
+/*
+Biquads in series, transposed direct form II. A stage goes over the whole block before the next one, its state
+sitting in registers meanwhile. Under AVX, four tunnels of a frame run side by side, one lane each.
+*/
+class BiquadCascade : public AudioFilter {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "BiquadCascade" );
+
+public:
+    inline static constexpr WORD   LANES   = 4;
+
+public:
+    BiquadCascade() = default;
+
+    BiquadCascade( std::vector< Biquad > stages )
+    : _stages{ std::move( stages ) }
+    {}
+
+_ENGINE_PROTECTED:
+    std::vector< Biquad >   _stages    = {};
+
+    /* Per stage, per tunnel, padded to whole lane groups. */
+    std::vector< double >   _z1        = {};
+    std::vector< double >   _z2        = {};
+    WORD                    _tunnels   = 0;
+    WORD                    _padded    = 0;
+
+public:
+    const std::vector< Biquad >& stages() const {
+        return _stages;
+    }
+
+    BiquadCascade& push( const Biquad& stage ) {
+        _stages.push_back( stage );
+        this->reset( _tunnels );
+        return *this;
+    }
+
+    virtual void reset( WORD tunnels ) override {
+        _tunnels = tunnels;
+        _padded  = ( tunnels + LANES - 1 ) / LANES * LANES;
+
+        _z1.assign( _stages.size() * _padded, 0.0 );
+        _z2.assign( _stages.size() * _padded, 0.0 );
+    }
+
+    virtual void process( double* block, size_t frames, WORD tunnels ) override {
+        if( tunnels != _tunnels ) this->reset( tunnels );
+
+        for( size_t s = 0; s < _stages.size(); ++s ) {
+            const Biquad& bq = _stages[ s ];
+            double*       z1 = _z1.data() + s * _padded;
+            double*       z2 = _z2.data() + s * _padded;
+
+        #if defined( _ENGINE_AVX )
+            const __m256d b0 = _mm256_set1_pd( bq.b0 );
+            const __m256d b1 = _mm256_set1_pd( bq.b1 );
+            const __m256d b2 = _mm256_set1_pd( bq.b2 );
+            const __m256d a1 = _mm256_set1_pd( bq.a1 );
+            const __m256d a2 = _mm256_set1_pd( bq.a2 );
+
+            for( WORD base = 0; base < tunnels; base += LANES ) {
+                const __m256i mask = _mm256_cmpgt_epi64( _mm256_set1_epi64x( tunnels - base ), _mm256_setr_epi64x( 0, 1, 2, 3 ) );
+
+                __m256d s1 = _mm256_loadu_pd( z1 + base );
+                __m256d s2 = _mm256_loadu_pd( z2 + base );
+
+                for( double* at = block + base; at < block + frames * tunnels; at += tunnels ) {
+                    const __m256d x = _mm256_maskload_pd( at, mask );
+                    const __m256d y = _mm256_add_pd( _mm256_mul_pd( b0, x ), s1 );
+
+                    s1 = _mm256_add_pd( _mm256_sub_pd( _mm256_mul_pd( b1, x ), _mm256_mul_pd( a1, y ) ), s2 );
+                    s2 = _mm256_sub_pd( _mm256_mul_pd( b2, x ), _mm256_mul_pd( a2, y ) );
+
+                    _mm256_maskstore_pd( at, mask, y );
+                }
+
+                _mm256_storeu_pd( z1 + base, s1 );
+                _mm256_storeu_pd( z2 + base, s2 );
+            }
+        #else
+            for( WORD tunnel = 0; tunnel < tunnels; ++tunnel ) {
+                double s1 = z1[ tunnel ];
+                double s2 = z2[ tunnel ];
+
+                for( double* at = block + tunnel; at < block + frames * tunnels; at += tunnels ) {
+                    const double x = *at;
+                    const double y = bq.b0 * x + s1;
+
+                    s1 = bq.b1 * x - bq.a1 * y + s2;
+                    s2 = bq.b2 * x - bq.a2 * y;
+
+                    *at = y;
+                }
+
+                z1[ tunnel ] = s1;
+                z2[ tunnel ] = s2;
+            }
+        #endif
+        }
+    }
+
+};
+
+
+
+enum FIR_FILTER_MODE : BYTE {
+    FIR_FILTER_MODE_AUTO = 0,
+    FIR_FILTER_MODE_DIRECT,
+    FIR_FILTER_MODE_FFT,
+
+    _FIR_FILTER_MODE_FORCE_BYTE = 0x7F
+};
+
+/*
+Causal FIR, out[ n ] = sum of taps[ k ] * in[ n - k ]. Short kernels run directly, four outputs at a time under AVX.
+Long ones go through uniformly partitioned overlap-save: the kernel is cut in partitions of a block each, whose
+spectra are multiplied against a delay line of past input spectra, so a block costs two FFTs and a sweep of
+complex multiply-adds however long the kernel. Tunnels are paired into the real and imaginary parts of one
+transform, the kernel being real. The FFT path lags by one partition.
+*/
+class FirFilter : public AudioFilter {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "FirFilter" );
+
+public:
+    inline static constexpr size_t   FFT_TAP_THRESHOLD   = 64;
+    inline static constexpr size_t   DEFAULT_PARTITION   = 256;
+
+public:
+    using Cplx = FftPlan< double >::Cplx;
+
+public:
+    FirFilter() = default;
+
+    FirFilter(
+        std::vector< double >   taps,
+        FIR_FILTER_MODE         mode        = FIR_FILTER_MODE_AUTO,
+        size_t                  partition   = DEFAULT_PARTITION,
+        _ENGINE_COMMS_ECHO_ARG
+    )
+    : _taps{ std::move( taps ) }
+    {
+        if( _taps.empty() ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Kernel shall have at least one tap.";
+            _taps = { 1.0 };
+        }
+
+        _fft = mode == FIR_FILTER_MODE_FFT || ( mode == FIR_FILTER_MODE_AUTO && _taps.size() > FFT_TAP_THRESHOLD );
+
+        _reversed.assign( _taps.rbegin(), _taps.rend() );
+
+        if( _fft ) this->_partition( FftPlan< double >::next_pow2( std::max< size_t >( partition, 16 ) ) );
+    }
+
+_ENGINE_PROTECTED:
+    std::vector< double >   _taps       = {};
+    std::vector< double >   _reversed   = {};
+    bool                    _fft        = false;
+    WORD                    _tunnels    = 0;
+
+    /* Direct. Per tunnel, pitch apart, the last taps - 1 inputs, then the block's. */
+    std::vector< double >   _lines      = {};
+    size_t                  _pitch      = 0;
+
+    /* FFT. */
+    struct _Pair {
+        std::vector< Cplx >   time      = {};
+        std::vector< Cplx >   delay     = {};
+        std::vector< Cplx >   out       = {};
+    };
+
+    size_t                  _block      = 0;
+    size_t                  _parts      = 0;
+    FftPlan< double >       _plan       = {};
+    std::vector< Cplx >     _spectra    = {};
+    std::vector< Cplx >     _acc        = {};
+    std::vector< _Pair >    _pairs      = {};
+    size_t                  _fill       = 0;
+    size_t                  _delay_at   = 0;
+
+_ENGINE_PROTECTED:
+    void _partition( size_t block ) {
+        _block = block;
+        _parts = ( _taps.size() + _block - 1 ) / _block;
+        _plan.reset( 2 * _block );
+
+        _spectra.assign( _parts * 2 * _block, Cplx{} );
+
+        for( size_t p = 0; p < _parts; ++p ) {
+            Cplx* spectrum = _spectra.data() + p * 2 * _block;
+
+            for( size_t k = 0; k < _block && p * _block + k < _taps.size(); ++k )
+                spectrum[ k ] = _taps[ p * _block + k ];
+
+            _plan.forward( spectrum );
+        }
+
+        _acc.resize( 2 * _block );
+    }
+
+    void _process_direct( double* block, size_t frames, WORD tunnels ) {
+        const size_t  history = _taps.size() - 1;
+        const size_t  stride  = history + frames;
+        const double* h       = _reversed.data();
+
+        /* Grows once, to the largest block seen, keeping the history. */
+        if( _pitch < stride ) {
+            std::vector< double > grown( stride * tunnels, 0.0 );
+
+            if( _pitch != 0 )
+                for( WORD tunnel = 0; tunnel < tunnels; ++tunnel )
+                    std::copy_n( _lines.data() + tunnel * _pitch, history, grown.data() + tunnel * stride );
+
+            _lines.swap( grown );
+            _pitch = stride;
+        }
+
+        for( WORD tunnel = 0; tunnel < tunnels; ++tunnel ) {
+            double* line = _lines.data() + tunnel * _pitch;
+
+            for( size_t frame = 0; frame < frames; ++frame )
+                line[ history + frame ] = block[ frame * tunnels + tunnel ];
+
+            size_t frame = 0;
+
+        #if defined( _ENGINE_AVX )
+            for( ; frame + 4 <= frames; frame += 4 ) {
+                __m256d acc = _mm256_setzero_pd();
+
+                for( size_t k = 0; k <= history; ++k )
+                    acc = _mm256_add_pd( acc, _mm256_mul_pd( _mm256_set1_pd( h[ k ] ), _mm256_loadu_pd( line + frame + k ) ) );
+
+                alignas( 32 ) double out[ 4 ];
+                _mm256_store_pd( out, acc );
+
+                for( size_t n = 0; n < 4; ++n )
+                    block[ ( frame + n ) * tunnels + tunnel ] = out[ n ];
+            }
+        #endif
+
+            for( ; frame < frames; ++frame ) {
+                double acc = 0.0;
+
+                for( size_t k = 0; k <= history; ++k )
+                    acc += h[ k ] * line[ frame + k ];
+
+                block[ frame * tunnels + tunnel ] = acc;
+            }
+
+            std::copy_n( line + frames, history, line );
+        }
+    }
+
+    /* acc += x * h, over n complex bins. */
+    static void _multiply_add( Cplx* acc, const Cplx* x, const Cplx* h, size_t n ) {
+        double*       a  = reinterpret_cast< double* >( acc );
+        const double* xs = reinterpret_cast< const double* >( x );
+        const double* hs = reinterpret_cast< const double* >( h );
+        size_t        k  = 0;
+
+    #if defined( _ENGINE_AVX )
+        for( ; k + 2 <= n; k += 2 ) {
+            const __m256d xv = _mm256_loadu_pd( xs + 2 * k );
+            const __m256d hv = _mm256_loadu_pd( hs + 2 * k );
+
+            const __m256d re = _mm256_mul_pd( xv, _mm256_movedup_pd( hv ) );
+            const __m256d im = _mm256_mul_pd( _mm256_permute_pd( xv, 0x5 ), _mm256_permute_pd( hv, 0xF ) );
+
+            _mm256_storeu_pd( a + 2 * k, _mm256_add_pd( _mm256_loadu_pd( a + 2 * k ), _mm256_addsub_pd( re, im ) ) );
+        }
+    #endif
+
+        for( ; k < n; ++k ) {
+            const double xr = xs[ 2 * k ], xi = xs[ 2 * k + 1 ];
+            const double hr = hs[ 2 * k ], hi = hs[ 2 * k + 1 ];
+
+            a[ 2 * k ]     += xr * hr - xi * hi;
+            a[ 2 * k + 1 ] += xr * hi + xi * hr;
+        }
+    }
+
+    /* A full partition came in, every pair gets its next partition out. */
+    void _convolve() {
+        const size_t n = 2 * _block;
+
+        for( _Pair& pair : _pairs ) {
+            Cplx* spectrum = pair.delay.data() + _delay_at * n;
+
+            std::copy_n( pair.time.data(), n, spectrum );
+            _plan.forward( spectrum );
+
+            std::fill( _acc.begin(), _acc.end(), Cplx{} );
+
+            for( size_t p = 0; p < _parts; ++p )
+                _multiply_add( _acc.data(), pair.delay.data() + ( ( _delay_at + _parts - p ) % _parts ) * n, _spectra.data() + p * n, n );
+
+            _plan.inverse( _acc.data() );
+
+            std::copy_n( _acc.data() + _block, _block, pair.out.data() );
+            std::copy_n( pair.time.data() + _block, _block, pair.time.data() );
+        }
+
+        _delay_at = ( _delay_at + 1 ) % _parts;
+    }
+
+    void _process_fft( double* block, size_t frames, WORD tunnels ) {
+        for( size_t frame = 0; frame < frames; ) {
+            const size_t run = std::min( frames - frame, _block - _fill );
+
+            for( WORD tunnel = 0; tunnel < tunnels; tunnel += 2 ) {
+                _Pair&     pair = _pairs[ tunnel / 2 ];
+                const bool odd  = tunnel + 1 == tunnels;
+
+                for( size_t n = 0; n < run; ++n ) {
+                    double* at = block + ( frame + n ) * tunnels + tunnel;
+
+                    pair.time[ _block + _fill + n ] = Cplx{ at[ 0 ], odd ? 0.0 : at[ 1 ] };
+
+                    at[ 0 ] = pair.out[ _fill + n ].real();
+                    if( !odd ) at[ 1 ] = pair.out[ _fill + n ].imag();
+                }
+            }
+
+            frame += run;
+
+            if( ( _fill += run ) == _block ) {
+                this->_convolve();
+                _fill = 0;
+            }
+        }
+    }
+
+public:
+    const std::vector< double >& taps() const {
+        return _taps;
+    }
+
+    bool is_fft() const {
+        return _fft;
+    }
+
+    virtual size_t latency() const override {
+        return _fft ? _block : 0;
+    }
+
+    virtual void reset( WORD tunnels ) override {
+        _tunnels = tunnels;
+
+        if( !_fft ) {
+            _lines.assign( _pitch * tunnels, 0.0 );
+            return;
+        }
+
+        _pairs.resize( ( tunnels + 1 ) / 2 );
+
+        for( _Pair& pair : _pairs ) {
+            pair.time.assign( 2 * _block, Cplx{} );
+            pair.delay.assign( _parts * 2 * _block, Cplx{} );
+            pair.out.assign( _block, Cplx{} );
+        }
+
+        _fill     = 0;
+        _delay_at = 0;
+    }
+
+    virtual void process( double* block, size_t frames, WORD tunnels ) override {
+        if( tunnels != _tunnels ) this->reset( tunnels );
+
+        if( _fft ) this->_process_fft( block, frames, tunnels );
+        else this->_process_direct( block, frames, tunnels );
+    }
+
+public:
+    /* Hamming windowed sinc, cutoff in Hz. */
+    static FirFilter low_pass( double sample_rate, double cutoff, size_t tap_count, FIR_FILTER_MODE mode = FIR_FILTER_MODE_AUTO ) {
+        std::vector< double > taps( std::max< size_t >( tap_count, 1 ) );
+
+        const double fc  = std::clamp( cutoff / sample_rate, 0.0, 0.5 );
+        const double mid = ( taps.size() - 1 ) / 2.0;
+        double       sum = 0.0;
+
+        for( size_t k = 0; k < taps.size(); ++k ) {
+            const double x   = k - mid;
+            const double win = taps.size() > 1 ? 0.54 - 0.46 * std::cos( 2.0 * std::numbers::pi * k / ( taps.size() - 1 ) ) : 1.0;
+
+            sum += ( taps[ k ] = ( x == 0.0 ? 2.0 * fc : std::sin( 2.0 * std::numbers::pi * fc * x ) / ( std::numbers::pi * x ) ) * win );
+        }
+
+        if( sum != 0.0 ) for( auto& t : taps ) t /= sum;
+
+        return FirFilter{ std::move( taps ), mode };
+    }
+
+    /* Legacy audio_filtering's kernel, every other tap at 2 / n. */
+    static FirFilter alternating( size_t tap_count = 50, FIR_FILTER_MODE mode = FIR_FILTER_MODE_AUTO ) {
+        std::vector< double > taps( tap_count );
+
+        for( size_t n = 1; n <= tap_count; ++n )
+            taps[ n - 1 ] = 2.0 / tap_count * ( n % 2 );
+
+        return FirFilter{ std::move( taps ), mode };
+    }
+
+};
+
+
+
+};
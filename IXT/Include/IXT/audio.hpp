@@ -8,6 +8,10 @@
 #include <IXT/endec.hpp>
 #include <IXT/tempo.hpp>
 #include <IXT/hyper-vector.hpp>
+#include <IXT/audio-filter.hpp>
+#include <IXT/lock-free.hpp>
+#include <IXT/pcm.hpp>
+#include <IXT/profiler.hpp>
 
 namespace _ENGINE_NAMESPACE {
 
@@ -24,6 +28,7 @@ namespace _ENGINE_NAMESPACE {
         #define   _engine_audio__mAVXi               __m128i
 
         #define   _engine_audio_mmAVX_set1_pd        _mm256_set1_pd
+        #define   _engine_audio_mmAVX_loadu_pd       _mm256_loadu_pd
 
         #define   _engine_audio_mmAVX_mul_pd         _mm256_mul_pd
         #define   _engine_audio_mmAVX_add_pd         _mm256_add_pd
@@ -37,6 +42,7 @@ namespace _ENGINE_NAMESPACE {
         #define   _engine_audio__mAVXi               __m256i
 
         #define   _engine_audio_mmAVX_set1_pd        _mm512_set1_pd
+        #define   _engine_audio_mmAVX_loadu_pd       _mm512_loadu_pd
 
         #define   _engine_audio_mmAVX_mul_pd         _mm512_mul_pd
         #define   _engine_audio_mmAVX_add_pd         _mm512_add_pd
@@ -52,140 +58,105 @@ namespace _ENGINE_NAMESPACE {
 
 class  Wave;
 struct WaveMeta;
+struct AudioCommand;
 class  Audio;
 
 
 
+/*
+What a wave plays with, the audio itself having its own for the whole mix. Only the mixing thread writes it, through
+the commands posted by Wave and Audio, the atomics let any thread read it meanwhile.
+*/
 struct WaveMeta {
 public:
     typedef   std::function< double( double, WORD ) >   Filter;
 
+public:
+    friend class Audio;
+
 _ENGINE_PROTECTED:
-    double   _volume     = 1.0;
-    bool     _paused     = false;
-    bool     _muted      = false;
-    bool     _looping    = false;
-    double   _velocity   = 1.0;
-    Filter   _filter     = {};
+    std::atomic< double >   _volume         = 1.0;
+    std::atomic< bool >     _paused         = false;
+    std::atomic< bool >     _muted          = false;
+    std::atomic< bool >     _looping        = false;
+    std::atomic< double >   _velocity       = 1.0;
+    Filter                  _filter         = {};
+    SPtr< AudioFilter >     _block_filter   = nullptr;
 #if defined( _ENGINE_AVX )
     struct {
         _engine_audio__mAVXd      volume   = { _engine_audio_mmAVX_set1_pd( 1.0 ) };
-    }        _avx        = {};            
+    }                       _avx            = {};
 #endif
 
 public:
     double volume() const {
-        return _volume;
+        return _volume.load( std::memory_order_relaxed );
     } 
 
-public:
-    WaveMeta& volume_at( double vlm ) {
-        _volume = std::clamp( vlm, -1.0, 1.0 );
-    #if defined( _ENGINE_AVX )
-        _avx.volume = _engine_audio_mmAVX_set1_pd( _volume );
-    #endif
-        return *this;
-    }
-
-    WaveMeta& volume_tweak( const auto& op, const auto& rhs ) {
-        _volume = std::clamp( std::invoke( op, _volume, rhs ), -1.0, 1.0 );
-    #if defined( _ENGINE_AVX )
-        _avx.volume = _engine_audio_mmAVX_set1_pd( _volume );
-    #endif
-        return *this;
-    }
-
-public:
     bool is_paused() const {
-        return _paused;
-    }
-
-    WaveMeta& pause() {
-        _paused = true;
-        return *this;
+        return _paused.load( std::memory_order_relaxed );
     }
 
-    WaveMeta& resume() {
-        _paused = false;
-        return *this;
-    }
-
-    WaveMeta& pause_tweak() {
-        _paused ^= true;
-        return *this;
-    }
-
-public:
     bool is_muted() const {
-        return _muted;
+        return _muted.load( std::memory_order_relaxed );
     }
 
-    WaveMeta& mute() {
-        _muted = true;
-        return *this;
+    bool is_looping() const {
+        return _looping.load( std::memory_order_relaxed );
     }
 
-    WaveMeta& unmute() {
-        _muted = false;
-        return *this;
+    double velocity() const {
+        return _velocity.load( std::memory_order_relaxed );
     }
 
-    WaveMeta& mute_tweak() {
-        _muted ^= true;
-        return *this;
+    /* Mixing thread only, the same as block_filter(). */
+    const Filter& filter() const {
+        return _filter;
     }
 
-public:
-    bool is_looping() const {
-        return _looping;
+    const SPtr< AudioFilter >& block_filter() const {
+        return _block_filter;
     }
 
-    WaveMeta& loop() {
-        _looping = true;
-        return *this;
+_ENGINE_PROTECTED:
+    template< typename Op >
+    static double _tweak_with( double lhs, double rhs ) {
+        return std::invoke( Op{}, lhs, rhs );
     }
 
-    WaveMeta& unloop() {
-        _looping = false;
-        return *this;
+    void _volume_at( double vlm ) {
+        _volume.store( std::clamp( vlm, -1.0, 1.0 ), std::memory_order_relaxed );
+    #if defined( _ENGINE_AVX )
+        _avx.volume = _engine_audio_mmAVX_set1_pd( _volume.load( std::memory_order_relaxed ) );
+    #endif
     }
 
-    WaveMeta& loop_tweak() {
-        _looping ^= true;
-        return *this;
-    }
+};
 
-public:
-    double velocity() const {
-        return _velocity;
-    }
 
-    WaveMeta& velocity_at( double vlc ) {
-        _velocity = vlc;
-        return *this;
-    }
 
-    WaveMeta& velocity_tweak( const auto& op, const auto& rhs ) {
-        _velocity = std::invoke( op, _velocity, rhs );
-        return *this;
-    }
+enum AUDIO_COMMAND : BYTE {
+    AUDIO_COMMAND_PLAY,
+    AUDIO_COMMAND_STOP,
+    AUDIO_COMMAND_STOP_ALL,
+    AUDIO_COMMAND_UNVOICE,
 
-public:
-    Filter filter() const {
-        return _filter;
-    }
+    AUDIO_COMMAND_VOLUME,
+    AUDIO_COMMAND_VELOCITY,
+    AUDIO_COMMAND_PAUSE,
+    AUDIO_COMMAND_MUTE,
+    AUDIO_COMMAND_LOOP,
+    AUDIO_COMMAND_FILTER,
+    AUDIO_COMMAND_BLOCK_FILTER
+};
 
-    WaveMeta& filter_with( const Filter& flt ) {
-        _filter = flt;
-        return *this;
-    }
+enum AUDIO_SWITCH : BYTE {
+    AUDIO_SWITCH_OFF,
+    AUDIO_SWITCH_ON,
+    AUDIO_SWITCH_TWEAK
+};
 
-    WaveMeta& remove_filter() {
-        _filter = nullptr;
-        return *this;
-    }
 
-};
 
 class Wave : public Descriptor, public WaveMeta {
 public:
@@ -197,37 +168,107 @@ public:
 public:
     Wave() = default;
 
+    /* Docked by reference, the audio shall outlive the waves docked in it. */
     Wave( HVEC< Audio > audio )
-    : _audio{ std::move( audio ) }
+    : _audio{ audio ? HVEC< Audio >{ *audio } : nullptr }
     {}
 
 public:
     virtual ~Wave() = default;
 
 _ENGINE_PROTECTED:
-    HVEC< Audio >   _audio   = nullptr;
+    HVEC< Audio >         _audio    = nullptr;
+    /* Whether the wave holds a voice of its audio. Written by the mixing thread only. */
+    std::atomic< bool >   _voiced   = false;
     
 public:
     bool is_playing() const;
 
+    /* 
+    Posted to the audio, as are stop() and the meta ones below, the wave itself is only ever touched by the mixing thread.
+    Without a hard handle to it, the wave is played by reference, its destructor then takes the voice back.
+    */
     void play();
 
     void play( HVEC< Wave > self );
 
+    void stop();
+
 public:
-    virtual void set() = 0;
+    /* Undocked, these land right away instead. */
+    Wave& volume_at( double vlm ) {
+        return this->_meta_value( AUDIO_COMMAND_VOLUME, vlm );
+    }
 
-    virtual void stop() = 0;
+    /* Stateless ops only, such as std::plus, as they run later on the mixing thread. */
+    template< typename Op >
+    Wave& volume_tweak( const Op&, double rhs ) {
+        return this->_meta_value( AUDIO_COMMAND_VOLUME, rhs, &WaveMeta::_tweak_with< Op > );
+    }
+
+    Wave& velocity_at( double vlc ) {
+        return this->_meta_value( AUDIO_COMMAND_VELOCITY, vlc );
+    }
+
+    template< typename Op >
+    Wave& velocity_tweak( const Op&, double rhs ) {
+        return this->_meta_value( AUDIO_COMMAND_VELOCITY, rhs, &WaveMeta::_tweak_with< Op > );
+    }
+
+    Wave& pause() { return this->_meta_switch( AUDIO_COMMAND_PAUSE, AUDIO_SWITCH_ON ); }
+    Wave& resume() { return this->_meta_switch( AUDIO_COMMAND_PAUSE, AUDIO_SWITCH_OFF ); }
+    Wave& pause_tweak() { return this->_meta_switch( AUDIO_COMMAND_PAUSE, AUDIO_SWITCH_TWEAK ); }
+
+    Wave& mute() { return this->_meta_switch( AUDIO_COMMAND_MUTE, AUDIO_SWITCH_ON ); }
+    Wave& unmute() { return this->_meta_switch( AUDIO_COMMAND_MUTE, AUDIO_SWITCH_OFF ); }
+    Wave& mute_tweak() { return this->_meta_switch( AUDIO_COMMAND_MUTE, AUDIO_SWITCH_TWEAK ); }
+
+    Wave& loop() { return this->_meta_switch( AUDIO_COMMAND_LOOP, AUDIO_SWITCH_ON ); }
+    Wave& unloop() { return this->_meta_switch( AUDIO_COMMAND_LOOP, AUDIO_SWITCH_OFF ); }
+    Wave& loop_tweak() { return this->_meta_switch( AUDIO_COMMAND_LOOP, AUDIO_SWITCH_TWEAK ); }
+
+    Wave& filter_with( Filter flt );
+
+    Wave& remove_filter() {
+        return this->filter_with( nullptr );
+    }
+
+    /* Goes over every block of this, keeping its state from one to the next. */
+    Wave& block_filter_with( SPtr< AudioFilter > flt );
+
+    Wave& remove_block_filter() {
+        return this->block_filter_with( nullptr );
+    }
+
+_ENGINE_PROTECTED:
+    Wave& _meta( AudioCommand&& cmd );
 
+    Wave& _meta_value( AUDIO_COMMAND op, double value, double ( *tweak )( double, double ) = nullptr );
+
+    Wave& _meta_switch( AUDIO_COMMAND op, AUDIO_SWITCH flip );
+
+public:
     virtual bool done() const = 0;
 
+_ENGINE_PROTECTED:
+    /* Mixing thread only, through the commands posted to the audio. */
+    virtual void _set() = 0;
+
+    virtual void _stop() = 0;
+
+    /* 
+    First thing in the destructor of every final wave. Returns once the mixer dropped the voice of this and went
+    past every command posted on it before, so nothing is left pointing here.
+    */
+    void _unvoice_wait();
+
 public:
     bool is_docked() const {
         return _audio != nullptr;
     }
 
     Wave& dock_in( HVEC< Audio > audio ) {
-        _audio = std::move( audio );
+        _audio = audio ? HVEC< Audio >{ *audio } : nullptr;
         return *this;
     }
 
@@ -241,30 +282,103 @@ public:
         return *_audio;
     }
 
-_ENGINE_PROTECTED:
-    virtual double _sample( double elapsed, WORD tunnel, bool tunnel_end ) = 0;
-
-#if defined( _ENGINE_AVX )
 public:
-    virtual const DWORD waveid_assert_avx() const = 0;
+    /* 
+    Adds the next frames of this wave into out, interleaved over tunnels, t0 being the mixer's time at the first frame.
+    Waves that can render a whole block natively override this, the rest go through _sample(), one sample at a time.
+    */
+    virtual void render_block( double* out, size_t frames, WORD tunnels, double t0 );
 
 _ENGINE_PROTECTED:
-    virtual _engine_audio__mAVXd _sample_avx( _engine_audio__mAVXd elapsed, _engine_audio__mAVXi tunnel, __mmask8 tunnel_end ) {
-        return _engine_audio_mmAVX_set1_pd( 0.0 );
-    }
-#endif
+    virtual double _sample( double elapsed, WORD tunnel, bool tunnel_end ) = 0;
 
 };
 
 
 
+struct audio_offline_init_t{};
+
+struct AudioRenderStats {
+    uint64_t   frame_count      = 0;
+    double     secs             = 0.0;
+    double     frames_per_sec   = 0.0;
+    double     realtime_ratio   = 0.0;
+};
+
+struct AudioCommand {
+    AUDIO_COMMAND           op             = AUDIO_COMMAND_PLAY;
+    /* Pause, mute and loop only. */
+    AUDIO_SWITCH            flip           = AUDIO_SWITCH_ON;
+    /* Null for the meta commands on the audio itself. */
+    HVEC< Wave >            wave           = nullptr;
+    double                  value          = 0.0;
+    /* Volume and velocity only, when set the value goes in as the right hand side of it, against the current one. */
+    double               ( *tweak )( double, double )   = nullptr;
+    /* Filter and block filter only. Swapped with the meta's, so the old ones go back through the retire ring. */
+    WaveMeta::Filter        filter         = {};
+    SPtr< AudioFilter >     block_filter   = nullptr;
+    /* Unvoice only, raised once done. */
+    std::atomic< bool >*    signal         = nullptr;
+};
+
+/*
+The mixing thread owns the voices, a fixed array of the waves playing. Other threads never touch it, nor the waves
+in it, they post commands instead, drained at the start of every block. Waves the mixer is done with are handed
+back through a ring and released on the next posting thread, so the mixer never locks, allocates nor frees.
+*/
 class Audio : public Descriptor, public WaveMeta {
 public:
     _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Audio" );
 
+public:
+    friend class Wave;
+
+public:
+    inline static constexpr size_t   VOICE_CAPACITY     = 512;
+    inline static constexpr size_t   COMMAND_CAPACITY   = 4096;
+
 public:
     Audio() = default;
 
+    /* 
+    Deviceless audio. Nothing plays in real time, instead the mixing loop runs on demand, as fast as possible, through render().
+    */
+    Audio(
+        [[maybe_unused]]audio_offline_init_t,
+        DWORD              sample_rate          = 48'000,
+        WORD               tunnel_count         = 1,
+        DWORD              block_sample_count   = 256,
+        _ENGINE_COMMS_ECHO_ARG
+    )
+    : _sample_rate       { sample_rate },
+      _time_step         { 1.0 / _sample_rate },
+      _tunnel_count      { tunnel_count },
+      _block_count       { 1 },
+      _block_sample_count{ block_sample_count * tunnel_count },
+      _block_current     { 0 },
+      _offline           { true }
+    {
+    #if defined( _ENGINE_AVX )
+        if( block_sample_count % _ENGINE_AUDIO_AVX_ALIGN != 0 ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Block sample count is not " << _ENGINE_AUDIO_AVX_ALIGN << " sample aligned. Cannot use AVX-" << _ENGINE_AVX << ".";
+            return;
+        }
+    #endif
+
+        _blocks_memory.reset( new int[ _block_sample_count ] );
+        _mix_block.reset( new double[ _block_sample_count ] );
+        _wave_block.reset( new double[ _block_sample_count ] );
+
+        if( !_blocks_memory || !_mix_block || !_wave_block ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Blocks bad alloc."; 
+            return;
+        }
+
+        std::fill_n( _blocks_memory.get(), _block_sample_count, 0 );
+
+        echo( this, ECHO_LEVEL_OK ) << "Created offline.";
+    }
+
     Audio(
         std::string_view   device,
         DWORD              sample_rate          = 48'000,
@@ -302,6 +416,15 @@ public:
         std::fill_n( _blocks_memory.get(), _block_count * _block_sample_count, 0 );
 
 
+        _mix_block.reset( new double[ _block_sample_count ] );
+        _wave_block.reset( new double[ _block_sample_count ] );
+
+        if( !_mix_block || !_wave_block ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Mix block bad alloc."; 
+            return;
+        }
+
+
         _wave_headers.reset( new WAVEHDR[ _block_count ] );
 
         if( !_wave_headers ) {
@@ -360,7 +483,7 @@ public:
 
         _powered.store( true, std::memory_order_seq_cst );
 
-        _thread = std::thread( _main, this );
+        _thread = std::thread( &Audio::_main, this );
 
         if( !_thread.joinable() ) {
             echo( this, ECHO_LEVEL_ERROR ) << "Could NOT launch main thread."; 
@@ -387,159 +510,429 @@ public:
         if( _thread.joinable() )
             _thread.join();
 
+        this->_release_all();
+
+        if( _wave_out == nullptr ) return;
+
         waveOutReset( _wave_out );
         waveOutClose( _wave_out );
     }
 
 _ENGINE_PROTECTED:
-    std::atomic< bool >         _powered              = false;
-
-    DWORD                       _sample_rate          = 0;
-    double                      _time_step            = 0.0;
-    WORD                        _tunnel_count         = 0;
-
-    DWORD                       _block_count          = 0;
-    DWORD                       _block_sample_count   = 0;
-    DWORD                       _block_current        = 0;
-    UPtr< int[] >               _blocks_memory        = nullptr;
-
-    UPtr< WAVEHDR[] >           _wave_headers         = nullptr;
-    HWAVEOUT                    _wave_out             = nullptr;
-    std::string                 _device               = {};
-
-    std::thread                 _thread               = {};
-
-    std::atomic< DWORD >        _free_block_count     = 0;
-    std::condition_variable     _cnd_var              = {};
-    std::mutex                  _mtx                  = {};
-
-    std::list< HVEC< Wave > >   _waves                = {};
+    std::atomic< bool >                          _powered              = false;
+    bool                                         _offline              = false;
+
+    DWORD                                        _sample_rate          = 0;
+    double                                       _time_step            = 0.0;
+    WORD                                         _tunnel_count         = 0;
+
+    DWORD                                        _block_count          = 0;
+    DWORD                                        _block_sample_count   = 0;
+    DWORD                                        _block_current        = 0;
+    UPtr< int[] >                                _blocks_memory        = nullptr;
+    UPtr< double[] >                             _mix_block            = nullptr;
+    /* Filtered waves render in here first. */
+    UPtr< double[] >                             _wave_block           = nullptr;
+
+    UPtr< WAVEHDR[] >                            _wave_headers         = nullptr;
+    HWAVEOUT                                     _wave_out             = nullptr;
+    std::string                                  _device               = {};
+
+    std::thread                                  _thread               = {};
+
+    std::atomic< DWORD >                         _free_block_count     = 0;
+    std::condition_variable                      _cnd_var              = {};
+    std::mutex                                   _mtx                  = {};
+
+    MpscQueue< AudioCommand >                    _commands             = { COMMAND_CAPACITY };
+    std::array< HVEC< Wave >, VOICE_CAPACITY >   _voices               = {};
+    size_t                                       _voice_count          = 0;
+    std::atomic< size_t >                        _refused_count        = 0;
+    std::atomic< size_t >                        _dropped_count        = 0;
+
+    SpscRing< AudioCommand >                     _retired              = { COMMAND_CAPACITY };
+    std::mutex                                   _retired_mtx          = {};
+    /* Bumped by the mixer on every unvoice done, for the destructors waiting on one. */
+    std::atomic< uint32_t >                      _unvoiced             = 0;
 
 #if defined( _ENGINE_AVX )
     struct {
         _engine_audio__mAVXd   elapsed   = { _engine_audio_mmAVX_set1_pd( 0.0 ) };
-    }                           _avx                  = {};
+    }                                            _avx                  = {};
 #else
-    double                      _elapsed              = 0.0;
+    double                                       _elapsed              = 0.0;
 #endif
 
 _ENGINE_PROTECTED:
     void _main() {
+        this->_mix_loop( 
+            [ this ] () -> int* {
+                if( !_powered.load( std::memory_order_relaxed ) ) return nullptr;
+
+                if( _free_block_count.load( std::memory_order_consume ) == 0 ) {
+                    std::unique_lock< std::mutex > lock{ _mtx, std::defer_lock_t{} };
+
+                    if( lock.try_lock() )
+                        _cnd_var.wait( lock );
+                }
+
+                _free_block_count.fetch_sub( 1, std::memory_order_release );
+
+            
+                if( _wave_headers[ _block_current ].dwFlags & WHDR_PREPARED )
+                    waveOutUnprepareHeader( _wave_out, &_wave_headers[ _block_current ], sizeof( WAVEHDR ) );
+
+                return _blocks_memory.get() + _block_current * _block_sample_count;
+            },
+            [ this ] ( [[maybe_unused]]int* block ) -> void {
+                waveOutPrepareHeader( _wave_out, &_wave_headers[ _block_current ], sizeof( WAVEHDR ) );
+                waveOutWrite( _wave_out, &_wave_headers[ _block_current ], sizeof( WAVEHDR ) );
+
+
+                ++_block_current;
+                _block_current %= _block_count;
+            }
+        );
+    }
+
+    /* 
+    The mixing loop, decoupled from where the blocks go. acquire() hands out the next block to fill, or nullptr to stop.
+    submit() receives the filled block.
+    */
+    template< typename Acquire, typename Submit >
+    void _mix_loop( Acquire&& acquire, Submit&& submit ) {
     #if defined( _ENGINE_AVX )
         const _engine_audio__mAVXd max_sample = _engine_audio_mmAVX_set1_pd( std::numeric_limits< int >::max() );
-    #else
-        constexpr double max_sample = static_cast< double >(
-            std::numeric_limits< int >::max()
-        );
     #endif
 
     #if defined( _ENGINE_AVX )
         _engine_audio__mAVXd avx_time_step = _engine_audio_mmAVX_set1_pd( _time_step ); 
-        WORD avx_tunnel[ _ENGINE_AUDIO_AVX_ALIGN + _tunnel_count ];
-        bool avx_tunend[ _ENGINE_AUDIO_AVX_ALIGN + _tunnel_count ];
-        BYTE avx_tunoff = 0;
+        /* A vector holds samples, not frames, so the clock moves a whole block of frames at once. */
+        _engine_audio__mAVXd avx_block_step = _engine_audio_mmAVX_set1_pd( _time_step * ( _block_sample_count / _tunnel_count ) );
         _engine_audio__mAVXd avx_amp_low = _engine_audio_mmAVX_set1_pd( -1.0 );
         _engine_audio__mAVXd avx_amp_high = _engine_audio_mmAVX_set1_pd( 1.0 );
 
-        for( BYTE idx = 0; idx < _ENGINE_AUDIO_AVX_ALIGN; ++idx )
-            _ENGINE_AUDIO_AVX_SELECT_PD( _avx.elapsed, idx ) = idx;
-        _avx.elapsed = _engine_audio_mmAVX_mul_pd( avx_time_step, _avx.elapsed );  
+        const double avx_elapsed_base = this->elapsed();
 
-        for( WORD t = 0; t < sizeof( avx_tunnel ) / sizeof( WORD ); ++t ) {
-            avx_tunnel[ t ] = t % _tunnel_count;
-            avx_tunend[ t ] = ( avx_tunnel[ t ] == _tunnel_count - 1 );
-        }
+        for( BYTE idx = 0; idx < _ENGINE_AUDIO_AVX_ALIGN; ++idx )
+            _ENGINE_AUDIO_AVX_SELECT_PD( _avx.elapsed, idx ) = idx / _tunnel_count;
+        _avx.elapsed = _engine_audio_mmAVX_add_pd( 
+            _engine_audio_mmAVX_mul_pd( avx_time_step, _avx.elapsed ), 
+            _engine_audio_mmAVX_set1_pd( avx_elapsed_base ) 
+        );  
 
-        auto sample = [ this, &avx_tunend, &avx_tunoff ] ( _engine_audio__mAVXi tunnel ) -> _engine_audio__mAVXd {
-            _engine_audio__mAVXd amp = _engine_audio_mmAVX_set1_pd( 0.0 );
+        auto sample = [ this ] ( const double* mixed ) -> _engine_audio__mAVXd {
+            _engine_audio__mAVXd amp = _engine_audio_mmAVX_loadu_pd( mixed );
 
             if( _paused ) return amp;
 
-            for( auto& wave : _waves )
-                if( wave->waveid_assert_avx() ) {
-                    amp += wave->_sample_avx( _avx.elapsed, tunnel, {} ); /*MARK_NOT_DONE*/
-                } else {
-                    for( BYTE idx = 0; idx < _ENGINE_AUDIO_AVX_ALIGN; ++idx )
-                        _ENGINE_AUDIO_AVX_SELECT_PD( amp, idx ) += wave->_sample(
-                            _ENGINE_AUDIO_AVX_SELECT_PD( _avx.elapsed, idx ),
-                            _ENGINE_AUDIO_AVX_SELECT_PD( tunnel, idx ),
-                            *( avx_tunend + avx_tunoff + idx )
-                        );
-                }
-
             if( !_muted )
                 return _engine_audio_mmAVX_mul_pd( amp, WaveMeta::_avx.volume );
             return _engine_audio_mmAVX_set1_pd( 0.0 );
         };
     #else
-        auto sample = [ this ] ( WORD tunnel ) -> double {
-            double amp = 0.0;
-
+        auto sample = [ this ] ( double amp, WORD tunnel ) -> double {
             if( _paused ) return amp;
 
-            for( auto& wave : _waves )
-                amp += wave->_sample( _elapsed, tunnel, tunnel == _tunnel_count - 1 );
-
             return _filter ? _filter( amp, tunnel ) : amp
                    * _volume * !_muted;
         };
     #endif
         
-        while( _powered.load( std::memory_order_relaxed ) ) {
-            if( _free_block_count.load( std::memory_order_consume ) == 0 ) {
-                std::unique_lock< std::mutex > lock{ _mtx, std::defer_lock_t{} };
+        for( int* current_block = acquire(); current_block != nullptr; current_block = acquire() ) {
+            IXT_ZONE( "Audio::mix_block" );
 
-                if( lock.try_lock() )
-                    _cnd_var.wait( lock );
-            }
+            this->_run_commands();
+            this->_retire_done();
 
-            _free_block_count.fetch_sub( 1, std::memory_order_release );
+            /* Every wave adds its block in here, then the volume and filter of the mix go over it. */
+            std::fill_n( _mix_block.get(), _block_sample_count, 0.0 );
 
-           
-            if( _wave_headers[ _block_current ].dwFlags & WHDR_PREPARED )
-                waveOutUnprepareHeader( _wave_out, &_wave_headers[ _block_current ], sizeof( WAVEHDR ) );
+            if( !_paused ) {
+                const double t0     = this->elapsed();
+                const size_t frames = _block_sample_count / _tunnel_count;
 
-            _waves.remove_if( [] ( auto& wave ) {
-                return wave->done();
-            } );
-            
+                for( size_t idx = 0; idx < _voice_count; ++idx )
+                    this->_render_voice( *_voices[ idx ], frames, t0 );
+
+                if( _block_filter ) _block_filter->process( _mix_block.get(), frames, _tunnel_count );
+            }
             
-            int* current_block = _blocks_memory.get() + _block_current * _block_sample_count;
    
         #if defined( _ENGINE_AVX )
             for( WORD n = 0; n < _block_sample_count; n += _ENGINE_AUDIO_AVX_ALIGN ) {
-                if( ( avx_tunoff += _ENGINE_AUDIO_AVX_ALIGN ) >= _tunnel_count )
-                    avx_tunoff %= _tunnel_count;
-           
                 _engine_audio__mAVXd amp = _engine_audio_mmAVX_min_pd( 
-                    _engine_audio_mmAVX_max_pd( sample( *( _engine_audio__mAVXi* )( avx_tunnel + avx_tunoff ) ), 
+                    _engine_audio_mmAVX_max_pd( sample( _mix_block.get() + n ), 
                     avx_amp_low ), avx_amp_high 
                 );
                
                 _engine_audio__mAVXi& current_vector = *( _engine_audio__mAVXi* )&current_block[ n ]; 
                 current_vector = _engine_audio_mmAVX_cvtpd_epi32( _engine_audio_mmAVX_mul_pd( amp, max_sample ) ); 
-
-                _avx.elapsed = _engine_audio_mmAVX_add_pd( _avx.elapsed, avx_time_step );
             }
+
+            _avx.elapsed = _engine_audio_mmAVX_add_pd( _avx.elapsed, avx_block_step );
         #else
             for( WORD n = 0; n < _block_sample_count; n += _tunnel_count ) {
                 for( WORD tnl = 0; tnl < _tunnel_count; ++tnl )
-                    current_block[ n + tnl ] = static_cast< int >( 
-                        std::clamp( sample( tnl ), -1.0, 1.0 ) * max_sample 
-                    );
+                    _mix_block[ n + tnl ] = sample( _mix_block[ n + tnl ], tnl );
                 
                 _elapsed += _time_step;
             }
+
+            Pcm::encode( _mix_block.get(), current_block, _block_sample_count, PCM_FMT_S32 );
         #endif
            
-            waveOutPrepareHeader( _wave_out, &_wave_headers[ _block_current ], sizeof( WAVEHDR ) );
-            waveOutWrite( _wave_out, &_wave_headers[ _block_current ], sizeof( WAVEHDR ) );
+            submit( current_block );
+        }
+
+    }
+
+_ENGINE_PROTECTED:
+    /* Mixing thread. Waves with a block filter go through it on their own, before joining the mix. */
+    void _render_voice( Wave& wave, size_t frames, double t0 ) {
+        const SPtr< AudioFilter >& filter = wave.block_filter();
+
+        if( !filter ) {
+            wave.render_block( _mix_block.get(), frames, _tunnel_count, t0 );
+            return;
+        }
+
+        std::fill_n( _wave_block.get(), _block_sample_count, 0.0 );
+
+        wave.render_block( _wave_block.get(), frames, _tunnel_count, t0 );
+        filter->process( _wave_block.get(), frames, _tunnel_count );
+
+        for( DWORD n = 0; n < _block_sample_count; ++n )
+            _mix_block[ n ] += _wave_block[ n ];
+    }
+
+    /* 
+    Mixing thread. Owning handles and replaced filters go back to the posting threads, as dropping the last of one
+    here would free. The ring is kept with room for every voice and the command at hand, see _run_commands(),
+    dropping here is the last resort.
+    */
+    void _retire( AudioCommand&& cmd ) {
+        if( !cmd.wave.hard() ) cmd.wave = nullptr;
+
+        if( cmd.wave || cmd.filter || cmd.block_filter ) {
+            if( auto span = _retired.write_span( 1 ); !span.empty() ) {
+                span[ 0 ] = std::move( cmd );
+                _retired.commit( 1 );
+            }
+        }
+
+        cmd = {};
+    }
+
+    void _unvoice( size_t idx ) {
+        _voices[ idx ]->_voiced.store( false, std::memory_order_release );
+        this->_retire( AudioCommand{ wave: std::move( _voices[ idx ] ) } );
+    }
+
+    /* Mixing thread. Keeps the other voices in the order they were played in. */
+    void _drop_voice( const Wave& wave ) {
+        for( size_t idx = 0; idx < _voice_count; ++idx ) {
+            if( _voices[ idx ].get() != &wave ) continue;
+
+            this->_unvoice( idx );
+            std::move( _voices.begin() + idx + 1, _voices.begin() + _voice_count, _voices.begin() + idx );
+            --_voice_count;
+            return;
+        }
+    }
+
+    static bool _flipped( bool now, AUDIO_SWITCH flip ) {
+        return flip == AUDIO_SWITCH_TWEAK ? !now : flip == AUDIO_SWITCH_ON;
+    }
+
+    /* Mixing thread, or whoever holds an undocked wave. The replaced filters are left in the command. */
+    static void _apply_meta( WaveMeta& meta, AudioCommand& cmd ) {
+        switch( cmd.op ) {
+            case AUDIO_COMMAND_VOLUME: {
+                meta._volume_at( cmd.tweak ? cmd.tweak( meta.volume(), cmd.value ) : cmd.value );
+            break; }
+
+            case AUDIO_COMMAND_VELOCITY: {
+                meta._velocity.store( cmd.tweak ? cmd.tweak( meta.velocity(), cmd.value ) : cmd.value, std::memory_order_relaxed );
+            break; }
+
+            case AUDIO_COMMAND_PAUSE: {
+                meta._paused.store( _flipped( meta.is_paused(), cmd.flip ), std::memory_order_relaxed );
+            break; }
+
+            case AUDIO_COMMAND_MUTE: {
+                meta._muted.store( _flipped( meta.is_muted(), cmd.flip ), std::memory_order_relaxed );
+            break; }
+
+            case AUDIO_COMMAND_LOOP: {
+                meta._looping.store( _flipped( meta.is_looping(), cmd.flip ), std::memory_order_relaxed );
+            break; }
+
+            case AUDIO_COMMAND_FILTER: {
+                std::swap( meta._filter, cmd.filter );
+            break; }
+
+            case AUDIO_COMMAND_BLOCK_FILTER: {
+                std::swap( meta._block_filter, cmd.block_filter );
+            break; }
+
+            default: break;
+        }
+    }
+
+    /* 
+    Mixing thread. A command retires at most one ring slot, either its own or, later, the voice it became. Draining
+    stops while the ring could not take that for every voice, what is left waits in the queue for the next block,
+    and the destructors waiting on an unvoice are woken up to release the ring meanwhile. Returns whether the queue
+    was drained.
+    */
+    bool _run_commands() {
+        for( AudioCommand cmd; _retired.space() > _voice_count; this->_retire( std::move( cmd ) ) ) {
+            if( !_commands.pop( cmd ) ) return true;
+
+            switch( cmd.op ) {
+                case AUDIO_COMMAND_PLAY: {
+                    if( cmd.wave->_voiced.load( std::memory_order_relaxed ) ) {
+                        cmd.wave->_set();
+                        break;
+                    }
+
+                    if( _voice_count == VOICE_CAPACITY ) {
+                        _refused_count.fetch_add( 1, std::memory_order_relaxed );
+                        break;
+                    }
+
+                    cmd.wave->_set();
+                    cmd.wave->_voiced.store( true, std::memory_order_release );
+                    _voices[ _voice_count++ ] = std::move( cmd.wave );
+                break; }
+
+                case AUDIO_COMMAND_STOP: {
+                    cmd.wave->_stop();
+                break; }
+
+                case AUDIO_COMMAND_STOP_ALL: {
+                    for( size_t idx = 0; idx < _voice_count; ++idx )
+                        _voices[ idx ]->_stop();
+                break; }
+
+                case AUDIO_COMMAND_UNVOICE: {
+                    /* The waiting destructor may return as soon as the signal is up, so it is the last touch of either. */
+                    this->_drop_voice( *cmd.wave );
+                    cmd.wave = nullptr;
+
+                    cmd.signal->store( true, std::memory_order_release );
+                    _unvoiced.fetch_add( 1, std::memory_order_release );
+                    _unvoiced.notify_all();
+                break; }
+
+                default: {
+                    if( cmd.wave ) this->_apply_meta( *cmd.wave, cmd );
+                    else this->_apply_meta( *this, cmd );
+                break; }
+            }
+        }
+
+        _unvoiced.fetch_add( 1, std::memory_order_release );
+        _unvoiced.notify_all();
+        return false;
+    }
+
+    /* Mixing thread. Keeps the voices in the order they were played in. */
+    void _retire_done() {
+        size_t kept = 0;
+
+        for( size_t idx = 0; idx < _voice_count; ++idx ) {
+            if( _voices[ idx ]->done() ) {
+                this->_unvoice( idx );
+                continue;
+            }
+
+            if( kept != idx ) _voices[ kept ] = std::move( _voices[ idx ] );
+            ++kept;
+        }
+
+        _voice_count = kept;
+    }
+
+    /* 
+    Posting threads. Whoever gets the lock moves out what the mixer is done with, a batch at a time, and drops it
+    past the lock and the ring, as the last handle of a wave runs its destructor, which may wait on the mixer.
+    */
+    void _release_retired() {
+        std::array< AudioCommand, 32 > batch;
+
+        for(;;) {
+            size_t count = 0;
+
+            if( std::unique_lock< std::mutex > lock{ _retired_mtx, std::try_to_lock }; lock.owns_lock() ) {
+                auto span = _retired.read_span( batch.size() );
+
+                for( auto& cmd : span ) batch[ count++ ] = std::move( const_cast< AudioCommand& >( cmd ) );
+                _retired.release( count );
+            }
+
+            if( count == 0 ) return;
+
+            for( size_t idx = 0; idx < count; ++idx ) batch[ idx ] = {};
+        }
+    }
+
+    Audio& _post( AudioCommand&& cmd ) {
+        this->_release_retired();
+
+        if( !_commands.push( std::move( cmd ) ) )
+            _dropped_count.fetch_add( 1, std::memory_order_relaxed );
+
+        return *this;
+    }
+
+    /* 
+    Posting threads, for Wave::_unvoice_wait(). Unlike _post(), this one never drops the command. Without a mixing
+    thread, offline or with no device, the mixer only runs inside render(), on the thread letting go of the wave,
+    which then drains the commands itself.
+    */
+    void _unvoice_wait( Wave& wave ) {
+        if( !_powered.load( std::memory_order_acquire ) ) {
+            do this->_release_retired(); while( !this->_run_commands() );
+            this->_drop_voice( wave );
+            return;
+        }
 
+        std::atomic< bool > signal = false;
 
-            ++_block_current;
-            _block_current %= _block_count;
+        for( AudioCommand cmd{ op: AUDIO_COMMAND_UNVOICE, wave: HVEC< Wave >{ wave }, signal: &signal }; !_commands.push( std::move( cmd ) ); )
+            std::this_thread::yield();
+
+        for( uint32_t seen = _unvoiced.load( std::memory_order_acquire ); !signal.load( std::memory_order_acquire ); seen = _unvoiced.load( std::memory_order_acquire ) ) {
+            this->_release_retired();
+            _unvoiced.wait( seen, std::memory_order_acquire );
+        }
+    }
+
+    /* 
+    Destructor, past the mixing thread. Drops whatever is left in the queue, the voices and the ring, with their
+    waves docked out first, as those about to go would otherwise wait on this from their destructors.
+    */
+    void _release_all() {
+        std::vector< AudioCommand > held;
+
+        for( AudioCommand cmd; _commands.pop( cmd ); ) held.push_back( std::move( cmd ) );
+
+        for( size_t idx = 0; idx < _voice_count; ++idx ) held.push_back( AudioCommand{ wave: std::move( _voices[ idx ] ) } );
+        _voice_count = 0;
+
+        for( auto span = _retired.read_span(); !span.empty(); span = _retired.read_span() ) {
+            for( auto& cmd : span ) held.push_back( std::move( const_cast< AudioCommand& >( cmd ) ) );
+            _retired.release( span.size() );
         }
 
+        for( auto& cmd : held ) {
+            if( !cmd.wave ) continue;
+
+            cmd.wave->_voiced.store( false, std::memory_order_relaxed );
+            cmd.wave->_audio = nullptr;
+        }
     }
 
 _ENGINE_PROTECTED:
@@ -567,6 +960,72 @@ _ENGINE_PROTECTED:
         }
     }
 
+public:
+    bool is_offline() const {
+        return _offline;
+    }
+
+    /* 
+    Offline only. Runs the mixing loop for frame_count frames, handing every block to op( const int* samples, size_t sample_count ),
+    as 32 bit interleaved PCM. The last block is cut to frame_count.
+    */
+    template< typename Op >
+    AudioRenderStats render( uint64_t frame_count, Op&& op ) {
+        if( !_offline || !_blocks_memory ) return {};
+
+        const uint64_t block_frames = _block_sample_count / _tunnel_count;
+        const uint64_t block_total  = ( frame_count + block_frames - 1 ) / block_frames;
+        uint64_t       block_done   = 0;
+
+        Ticker tick{};
+
+        this->_mix_loop(
+            [ & ] () -> int* {
+                return block_done < block_total ? _blocks_memory.get() : nullptr;
+            },
+            [ & ] ( int* block ) -> void {
+                uint64_t frames = std::min( block_frames, frame_count - block_done * block_frames );
+                std::invoke( op, ( const int* )block, ( size_t )( frames * _tunnel_count ) );
+                ++block_done;
+            }
+        );
+
+        AudioRenderStats stats{ .frame_count = frame_count, .secs = tick.lap() };
+        stats.frames_per_sec = stats.secs > 0.0 ? frame_count / stats.secs : 0.0;
+        stats.realtime_ratio = stats.frames_per_sec / _sample_rate;
+
+        return stats;
+    }
+
+    AudioRenderStats render_to( std::vector< int >& pcm, double secs ) {
+        uint64_t frame_count = secs * _sample_rate;
+
+        pcm.reserve( pcm.size() + frame_count * _tunnel_count );
+
+        return this->render( frame_count, [ &pcm ] ( const int* block, size_t count ) -> void {
+            pcm.insert( pcm.end(), block, block + count );
+        } );
+    }
+
+    AudioRenderStats render_to( std::string_view path, double secs, PCM_FMT fmt = PCM_FMT_S16, _ENGINE_COMMS_ECHO_ARG ) {
+        Endec::WavWriter writer{ path, _sample_rate, _tunnel_count, fmt, echo };
+
+        if( !writer ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Could NOT render to: \"" << path.data() << "\".";
+            return {};
+        }
+
+        AudioRenderStats stats = this->render( secs * _sample_rate, [ this, &writer ] ( const int* block, size_t count ) -> void {
+            writer.push_pcm( block, count / _tunnel_count, PCM_FMT_S32 );
+        } );
+
+        writer.close();
+
+        echo( this, ECHO_LEVEL_OK ) << "Rendered " << stats.frame_count << " frames to: \"" << path.data() << "\", in " << stats.secs << "s ( " << stats.realtime_ratio << "x real time ).";
+
+        return stats;
+    }
+
 public:
     static std::vector< std::string > devices() {
         WAVEOUTCAPS woc;
@@ -613,31 +1072,96 @@ public:
 
 public:
     bool is_playing( const Wave& wave ) const {
-        return std::find_if( _waves.begin(), _waves.end(), [ &wave ] ( auto& node ) -> bool {
-            return node->xtdx() == wave.xtdx();
-        } ) != _waves.end();
+        return wave._voiced.load( std::memory_order_acquire );
     }
 
-    Audio& play( HVEC< Wave > wave ) {
-        wave->set();
+    /* Plays refused for lack of a free voice, so far. */
+    size_t refused_count() const {
+        return _refused_count.load( std::memory_order_relaxed );
+    }
 
-        if( !this->is_playing( *wave ) )
-            _waves.emplace_back( std::move( wave ) );
+    /* Commands dropped on a full queue, so far. */
+    size_t dropped_count() const {
+        return _dropped_count.load( std::memory_order_relaxed );
+    }
 
-        return *this;
+public:
+    /* 
+    Any thread, no echoes, as these sit on hot paths. The commands land at the start of the next block. Playing a 
+    wave already playing sets it again, e.g. a Sound then plays once more over itself.
+    */
+    Audio& play( HVEC< Wave > wave ) {
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_PLAY, wave: std::move( wave ) } );
+    }
+
+    Audio& stop( HVEC< Wave > wave ) {
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_STOP, wave: std::move( wave ) } );
     }
 
     Audio& stop() {
-        for( auto& w : _waves )
-            w->stop();
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_STOP_ALL } );
+    }
 
-        return *this;
+    Audio& volume_at( HVEC< Wave > wave, double vlm ) {
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_VOLUME, wave: std::move( wave ), value: vlm } );
+    }
+
+public:
+    /* The meta of the whole mix, posted the same as that of the waves. */
+    Audio& volume_at( double vlm ) {
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_VOLUME, value: vlm } );
+    }
+
+    /* Stateless ops only, such as std::plus, as they run later on the mixing thread. */
+    template< typename Op >
+    Audio& volume_tweak( const Op&, double rhs ) {
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_VOLUME, value: rhs, tweak: &WaveMeta::_tweak_with< Op > } );
+    }
+
+    Audio& velocity_at( double vlc ) {
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_VELOCITY, value: vlc } );
+    }
+
+    template< typename Op >
+    Audio& velocity_tweak( const Op&, double rhs ) {
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_VELOCITY, value: rhs, tweak: &WaveMeta::_tweak_with< Op > } );
+    }
+
+    Audio& pause() { return this->_post( AudioCommand{ op: AUDIO_COMMAND_PAUSE, flip: AUDIO_SWITCH_ON } ); }
+    Audio& resume() { return this->_post( AudioCommand{ op: AUDIO_COMMAND_PAUSE, flip: AUDIO_SWITCH_OFF } ); }
+    Audio& pause_tweak() { return this->_post( AudioCommand{ op: AUDIO_COMMAND_PAUSE, flip: AUDIO_SWITCH_TWEAK } ); }
+
+    Audio& mute() { return this->_post( AudioCommand{ op: AUDIO_COMMAND_MUTE, flip: AUDIO_SWITCH_ON } ); }
+    Audio& unmute() { return this->_post( AudioCommand{ op: AUDIO_COMMAND_MUTE, flip: AUDIO_SWITCH_OFF } ); }
+    Audio& mute_tweak() { return this->_post( AudioCommand{ op: AUDIO_COMMAND_MUTE, flip: AUDIO_SWITCH_TWEAK } ); }
+
+    Audio& filter_with( Filter flt ) {
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_FILTER, filter: std::move( flt ) } );
+    }
+
+    Audio& remove_filter() {
+        return this->filter_with( nullptr );
+    }
+
+    /* Goes over every block of the mix, keeping its state from one to the next. */
+    Audio& block_filter_with( SPtr< AudioFilter > flt ) {
+        return this->_post( AudioCommand{ op: AUDIO_COMMAND_BLOCK_FILTER, block_filter: std::move( flt ) } );
+    }
+
+    Audio& remove_block_filter() {
+        return this->block_filter_with( nullptr );
     }
 
 };
 
 
 
+enum SOUND_FLAG : DWORD {
+    SOUND_FLAG_MAPPED = 1 << 0,
+
+    _SOUND_FLAG_FORCE_DWORD = 0x7F'FF'FF'FF
+};
+
 class Sound : public Wave {
 public:
     _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Sound" );
@@ -648,6 +1172,7 @@ public:
     Sound( 
         HVEC< Audio >      audio, 
         std::string_view   path, 
+        DWORD              flags = 0,
         _ENGINE_COMMS_ECHO_ARG 
     )
     : Wave{ std::move( audio ) }
@@ -655,7 +1180,23 @@ public:
         using namespace std::string_literals;
 
 
-        if( path.ends_with( ".wav" ) ) {
+        if( path.ends_with( ".wav" ) && ( flags & SOUND_FLAG_MAPPED ) ) {
+            _view = HVEC< Endec::WavView >::alloc( path, echo );
+
+            if( !*_view ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT map: \"" << path.data() << "\".";
+                _view = nullptr;
+                return;
+            }
+
+            _native       = ( const char* )_view->bytes().data();
+            _native_fmt   = _view->pcm_fmt();
+            _sample_rate  = _view->sample_rate();
+            _sample_count = _view->frame_count();
+            _tunnel_count = _view->tunnel_count();
+
+            echo( this, ECHO_LEVEL_OK ) << "Created, mapped, from: \"" << path.data() << "\".";
+        } else if( path.ends_with( ".wav" ) ) {
             Endec::Wav< double > wav{ path, echo };
 
             _stream       = std::move( wav.stream );
@@ -682,34 +1223,40 @@ public:
     Sound( 
         std::string_view   path,
         _ENGINE_COMMS_ECHO_ARG
-    ) : Sound{ nullptr, path, echo }
+    ) : Sound{ nullptr, path, 0, echo }
     {}
 
 
     ~Sound() {
-        stop();
+        this->_unvoice_wait();
     }
 
 _ENGINE_PROTECTED:
-    HVEC< double[] >      _stream         = nullptr;
+    HVEC< double[] >         _stream         = nullptr;
 
-    std::list< double >   _needles        = {};
+    HVEC< Endec::WavView >   _view           = nullptr;
+    const char*              _native         = nullptr;
+    PCM_FMT                  _native_fmt     = PCM_FMT_S16;
 
-    DWORD                 _sample_rate    = 0;
-    DWORD                 _sample_count   = 0;
-    WORD                  _tunnel_count   = 0;
+    std::vector< double >    _needles        = {};
+    std::vector< int64_t >   _gather         = {};
+
+    DWORD                    _sample_rate    = 0;
+    DWORD                    _sample_count   = 0;
+    WORD                     _tunnel_count   = 0;
 
 public:
-    virtual void set() override {
-        _needles.push_back( 0.0 );
+    virtual bool done() const override {
+        return _needles.empty();
     }
 
-    virtual void stop() override {
-        _needles.clear();
+_ENGINE_PROTECTED:
+    virtual void _set() override {
+        _needles.push_back( 0.0 );
     }
 
-    virtual bool done() const override {
-        return _needles.empty();
+    virtual void _stop() override {
+        _needles.clear();
     }
 
 _ENGINE_PROTECTED:
@@ -718,8 +1265,11 @@ _ENGINE_PROTECTED:
 
         if( _paused ) return amp;
 
-        _needles.remove_if( [ this, &amp, &tunnel, &advance ] ( double& at ) {
-            double raw = _stream[ static_cast< size_t >( at ) * _tunnel_count + tunnel ];
+        std::erase_if( _needles, [ this, &amp, &tunnel, &advance ] ( double& at ) {
+            size_t idx = static_cast< size_t >( at ) * _tunnel_count + tunnel;
+            double raw = _stream != nullptr 
+                         ? _stream[ idx ] 
+                         : Pcm::decode_one< double >( _native + idx * PCM_FMT_BYTES[ _native_fmt ], _native_fmt );
 
             amp +=  _filter ? _filter( raw, tunnel ) : raw
                     *
@@ -744,9 +1294,88 @@ _ENGINE_PROTECTED:
         return amp;
     }
 
+public:
+    /* 
+    Needle by needle, the source sample of every output sample goes into _gather, stepping the needle as _sample() 
+    would, then the block is gathered and scaled in one sweep.
+    */
+    virtual void render_block( double* out, size_t frames, WORD tunnels, [[maybe_unused]] double t0 ) override {
+        if( _paused ) return;
+
+        const double tweak = _velocity * _audio->velocity();
+
+        _gather.resize( frames * tunnels );
+
+        std::erase_if( _needles, [ & ] ( double& at ) -> bool {
+            size_t frame = 0;
+            bool   ended = false;
+
+            while( frame < frames && !ended ) {
+                const int64_t base = static_cast< int64_t >( at ) * _tunnel_count;
+
+                for( WORD tunnel = 0; tunnel < tunnels; ++tunnel )
+                    _gather[ frame * tunnels + tunnel ] = base + tunnel % _tunnel_count;
+
+                ++frame;
+                at += tweak;
+
+                if( at <= -1.0 || static_cast< size_t >( at ) >= _sample_count ) {
+                    at    = tweak >= 0.0 ? 0.0 : _sample_count - 1.0;
+                    ended = !_looping;
+                }
+            }
+
+            this->_gather_block( out, frame * tunnels, tunnels );
+            return ended;
+        } );
+    }
+
+_ENGINE_PROTECTED:
+    void _gather_block( double* out, size_t count, WORD tunnels ) {
+        const int64_t* idxs = _gather.data();
+
+        if( _filter ) {
+            for( size_t n = 0; n < count; ++n ) {
+                double raw = _stream != nullptr 
+                             ? _stream[ idxs[ n ] ] 
+                             : Pcm::decode_one< double >( _native + idxs[ n ] * PCM_FMT_BYTES[ _native_fmt ], _native_fmt );
+
+                out[ n ] += _filter( raw, n % tunnels );
+            }
+            return;
+        }
+
+        const double gain = _volume * !_muted;
+
+        if( _stream == nullptr ) {
+            for( size_t n = 0; n < count; ++n )
+                out[ n ] += Pcm::decode_one< double >( _native + idxs[ n ] * PCM_FMT_BYTES[ _native_fmt ], _native_fmt ) * gain;
+            return;
+        }
+
+        const double* src = _stream.get();
+        size_t        n   = 0;
+
+    #if defined( _ENGINE_AVX )
+        const __m256d avx_gain = _mm256_set1_pd( gain );
+
+        for( ; n + 4 <= count; n += 4 ) {
+            __m256d raw = _mm256_i64gather_pd( src, _mm256_loadu_si256( ( const __m256i* )( idxs + n ) ), sizeof( double ) );
+            _mm256_storeu_pd( out + n, _mm256_add_pd( _mm256_loadu_pd( out + n ), _mm256_mul_pd( raw, avx_gain ) ) );
+        }
+    #endif
+
+        for( ; n < count; ++n )
+            out[ n ] += src[ idxs[ n ] ] * gain;
+    }
+
 public:
     bool has_stream() const {
-        return _stream != nullptr;
+        return _stream != nullptr || _native != nullptr;
+    }
+
+    bool is_mapped() const {
+        return _view != nullptr;
     }
 
     operator bool () const {
@@ -770,17 +1399,198 @@ public:
         return static_cast< double >( _sample_count ) / _sample_rate;
     }
 
-#if defined( _ENGINE_AVX )
+};
+
+
+
+/*
+Plays a WAV straight off the disk. A feeder thread decodes fixed size chunks into a bounded ring,
+so memory stays at buffer_secs worth of samples regardless of the file's length, and playback can 
+begin as soon as the first chunk is decoded. Being a stream, only forward velocities are honored.
+*/
+class SoundStream : public Wave {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "SoundStream" );
+
 public:
-    virtual const DWORD waveid_assert_avx() const override {
-       return 0;
+    SoundStream() = default;
+
+    SoundStream( 
+        HVEC< Audio >      audio, 
+        std::string_view   path, 
+        double             buffer_secs = 1.0,
+        _ENGINE_COMMS_ECHO_ARG 
+    )
+    : Wave{ std::move( audio ) }, _wav{ path, 4096, echo }
+    {
+        if( !_wav ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Could NOT stream from: \"" << path.data() << "\".";
+            return;
+        }
+
+        _sample_rate  = _wav.sample_rate();
+        _tunnel_count = _wav.tunnel_count();
+        _chunk_frames = 4096;
+
+        size_t ring_frames = std::max< size_t >( buffer_secs * _sample_rate, _chunk_frames * 2 );
+        _ring.reserve( ring_frames * _tunnel_count );
+
+        _wav.pull( _ring, _chunk_frames );
+
+        _powered.store( true, std::memory_order_release );
+        _feeder = std::thread{ &SoundStream::_feed, this };
+
+        echo( this, ECHO_LEVEL_OK ) << "Created from: \"" << path.data() << "\", buffering " << ring_frames << " frames.";
+
+        if( !_audio ) return;
+
+        if( _sample_rate != _audio->sample_rate() )
+            echo( this, ECHO_LEVEL_WARNING ) << "Sample rate ( " << _sample_rate << " ) does not match with docked in audio's ( " << _audio->sample_rate() << " ).";
+
+        if( _tunnel_count != _audio->tunnel_count() )
+            echo( this, ECHO_LEVEL_WARNING ) << "Tunnel count ( " << _tunnel_count << " ) does not match with docked in audio's ( " << _audio->tunnel_count() << " ).";
+
+        echo( this, ECHO_LEVEL_OK ) << "Audio docked.";
+    }
+
+    SoundStream( 
+        std::string_view   path,
+        _ENGINE_COMMS_ECHO_ARG
+    ) : SoundStream{ nullptr, path, 1.0, echo }
+    {}
+
+    SoundStream( const SoundStream& ) = delete;
+    SoundStream( SoundStream&& ) = delete;
+
+    ~SoundStream() {
+        this->_unvoice_wait();
+
+        _powered.store( false, std::memory_order_release );
+        _ring.poke();
+
+        if( _feeder.joinable() )
+            _feeder.join();
+    }
+
+_ENGINE_PROTECTED:
+    Endec::WavStream< double >   _wav            = {};
+    SpscRing< double >           _ring           = {};
+    size_t                       _chunk_frames   = 0;
+
+    std::thread                  _feeder         = {};
+    std::atomic< bool >          _powered        = false;
+
+    std::atomic< bool >          _playing        = false;
+    std::atomic< bool >          _dirty          = false;
+    std::atomic< bool >          _seek_req       = false;
+    std::atomic< bool >          _eos            = false;
+    std::atomic< size_t >        _discard_to     = 0;
+
+    double                       _needle         = 0.0;
+
+    DWORD                        _sample_rate    = 0;
+    WORD                         _tunnel_count   = 0;
+
+_ENGINE_PROTECTED:
+    void _feed() {
+        while( _powered.load( std::memory_order_acquire ) ) {
+            if( _seek_req.load( std::memory_order_acquire ) ) {
+                _discard_to.store( _ring.head(), std::memory_order_release );
+                _wav.seek( 0 );
+                _eos.store( false, std::memory_order_release );
+                _seek_req.store( false, std::memory_order_release );
+            }
+
+            if( _wav.eos() ) {
+                if( _looping ) { _wav.seek( 0 ); continue; }
+
+                _eos.store( true, std::memory_order_release );
+                _ring.wait_space( _ring.capacity() + 1 );
+                continue;
+            }
+
+            if( !_ring.wait_space( _chunk_frames * _tunnel_count ) ) continue;
+
+            _wav.pull( _ring, _chunk_frames );
+        }
+    }
+
+public:
+    virtual bool done() const override {
+        return !_playing.load( std::memory_order_acquire );
     }
 
 _ENGINE_PROTECTED:
-    virtual _engine_audio__mAVXd _sample_avx( _engine_audio__mAVXd elapsed, _engine_audio__mAVXi tunnel, __mmask8 tunnel_end ) override {
-        return _engine_audio_mmAVX_set1_pd( 0.0 );
+    virtual void _set() override {
+        if( _dirty.exchange( false, std::memory_order_acq_rel ) ) {
+            _seek_req.store( true, std::memory_order_release );
+            _ring.poke();
+        }
+
+        _playing.store( true, std::memory_order_release );
+    }
+
+    virtual void _stop() override {
+        _playing.store( false, std::memory_order_release );
+    }
+
+_ENGINE_PROTECTED:
+    virtual double _sample( double elapsed, WORD tunnel, bool advance ) override {
+        if( _paused || !_playing.load( std::memory_order_relaxed ) ) return 0.0;
+
+        if( size_t discard_to = _discard_to.load( std::memory_order_acquire ); _ring.tail() < discard_to ) {
+            _ring.release( std::min( _ring.size(), discard_to - _ring.tail() ) );
+            _needle = 0.0;
+        }
+
+        auto frame = _ring.read_span( _tunnel_count );
+
+        if( frame.size() < _tunnel_count ) {
+            if( _eos.load( std::memory_order_acquire ) && !_seek_req.load( std::memory_order_acquire ) )
+                _playing.store( false, std::memory_order_release );
+
+            return 0.0;
+        }
+
+        double raw = frame[ tunnel % _tunnel_count ];
+        double amp = ( _filter ? _filter( raw, tunnel ) : raw ) * _volume * !_muted;
+
+        if( advance ) {
+            _needle += std::max( _velocity * _audio->velocity(), 0.0 );
+
+            size_t whole = std::min( static_cast< size_t >( _needle ), _ring.size() / _tunnel_count );
+
+            if( whole > 0 ) {
+                _ring.release( whole * _tunnel_count );
+                _needle -= whole;
+                _dirty.store( true, std::memory_order_relaxed );
+            }
+        }
+
+        return amp;
+    }
+
+public:
+    operator bool () const {
+        return this->is_docked() && _ring.capacity() != 0;
+    }
+
+public:
+    size_t sample_rate() const {
+        return _sample_rate;
+    }
+
+    size_t tunnel_count() const {
+        return _tunnel_count;
+    }
+
+    size_t sample_count() const {
+        return _wav.frame_count();
+    }
+
+    double duration() const {
+        return static_cast< double >( this->sample_count() ) / _sample_rate;
     }
-#endif
 
 };
 
@@ -822,6 +1632,10 @@ public:
     : Synth{ nullptr, generator, 0.0 }
     {}
 
+    ~Synth() {
+        this->_unvoice_wait();
+    }
+
 _ENGINE_PROTECTED:
     Generator   _generator    = {};
 
@@ -830,20 +1644,20 @@ _ENGINE_PROTECTED:
     double      _decay_step   = 0.0;
 
 public:
-    virtual void set() override {
+    virtual bool done() const override {
+        return _decay <= 1e-6;
+    }
+
+_ENGINE_PROTECTED:
+    virtual void _set() override {
         _elapsed = 0.0;
         _decay   = 1.0;
     }
 
-    virtual void stop() override {
+    virtual void _stop() override {
         _decay = 0.0;
     }
 
-    virtual bool done() const override {
-        return _decay <= 1e-6;
-    }
-
-
 _ENGINE_PROTECTED:
     virtual double _sample( double elapsed, WORD tunnel, bool advance ) override {
         if( _paused ) return 0.0;
@@ -855,7 +1669,7 @@ _ENGINE_PROTECTED:
         
         if( this->Synth::done() ) {
             if( _looping )
-                this->Synth::set();
+                this->Synth::_set();
             else
                 return 0.0;
         }
@@ -864,22 +1678,36 @@ _ENGINE_PROTECTED:
     }
 
 public:
-    Synth& decay_in( double secs ) {
-        _decay_step = 1.0 / ( secs * _audio->sample_rate() );
-        return *this;
-    }
+    /* _sample() over the block, with the per sample state reads hoisted out. */
+    virtual void render_block( double* out, size_t frames, WORD tunnels, [[maybe_unused]] double t0 ) override {
+        if( _paused ) return;
 
-#if defined( _ENGINE_AVX )
-public:
-    virtual const DWORD waveid_assert_avx() const override {
-        return 0;
+        const double step = _audio->time_step() * _velocity * _audio->velocity();
+        const double gain = _volume * !_muted;
+
+        for( size_t frame = 0; frame < frames; ++frame ) {
+            for( WORD tunnel = 0; tunnel < tunnels; ++tunnel, ++out ) {
+                if( tunnel == tunnels - 1 )
+                    _elapsed += step;
+
+                _decay -= _decay_step;
+
+                if( this->Synth::done() ) {
+                    if( !_looping ) return;
+
+                    this->Synth::_set();
+                }
+
+                *out += _decay * std::invoke( _generator, _elapsed, tunnel ) * gain;
+            }
+        }
     }
 
-_ENGINE_PROTECTED:
-    virtual _engine_audio__mAVXd _sample_avx( _engine_audio__mAVXd elapsed, _engine_audio__mAVXi tunnel, __mmask8 tunnel_end ) {
-        return _engine_audio_mmAVX_set1_pd( 0 );
+public:
+    Synth& decay_in( double secs ) {
+        _decay_step = 1.0 / ( secs * _audio->sample_rate() );
+        return *this;
     }
-#endif
 
 public:
     static Generator gen_sine( double amp, double freq ) {
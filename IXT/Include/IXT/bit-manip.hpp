@@ -4,6 +4,8 @@
 
 #include <IXT/descriptor.hpp>
 
+#include <bit>
+
 
 
 namespace _ENGINE_NAMESPACE {
@@ -15,83 +17,367 @@ enum BIT_END {
     BIT_END_BIG
 };
 
+/*
+Integers out of count raw bytes of either endianness, sign extended when T is signed. Loads go through memcpy
+and std::byteswap, no reinterpret_cast reads, and the sign extension is a shift pair, so no branches on the data.
+The compile time count overloads are constexpr. convert_n() runs the same conversion over arrays, in SIMD lanes
+for the byte orders that have a shuffle.
+*/
 class Bytes {
 public:
     template< typename T >
-    requires std::is_integral_v< T >
-    static T as( char* src, size_t count, BIT_END end ) {
-        char dst[ sizeof( T ) ];
+    static constexpr bool is_swappable_v = std::is_integral_v< T > && !std::is_same_v< T, bool >;
+
+    inline static constexpr BIT_END   NATIVE_END   = std::endian::native == std::endian::little ? BIT_END_LITTLE : BIT_END_BIG;
 
-        const bool is_negative =
-            ( *reinterpret_cast< char* >( src + ( end == BIT_END_LITTLE ? count - 1 : 0 ) ) ) >> 7
-            &&
-            std::is_signed_v< T >;
+_ENGINE_PROTECTED:
+    /* count raw bytes, 1 <= count <= sizeof( T ), into the low bytes of an unsigned T, value order. */
+    template< typename T >
+    static constexpr std::make_unsigned_t< T > _load( const char* src, size_t count, BIT_END end ) {
+        using U = std::make_unsigned_t< T >;
 
-        for( size_t n = count; n < sizeof( T ); ++n )
-            dst[ n ] = is_negative ? -1 : 0;
+        /* Partial words are assembled in registers, a short memcpy would stall on store forwarding. */
+        if !consteval {
+            if( count == sizeof( U ) ) {
+                U v; std::memcpy( &v, src, sizeof( U ) );
+                return end == NATIVE_END ? v : std::byteswap( v );
+            }
+        }
 
-        for( size_t n = 0; n < count && n < sizeof( T ); ++n )
-            dst[ n ] = src[ end == BIT_END_LITTLE ? n : count - n - 1 ];
+        U v = 0;
+        for( size_t n = 0; n < count; ++n )
+            v |= ( U )( ( U )( ubyte_t )src[ end == BIT_END_LITTLE ? n : count - n - 1 ] << ( 8 * n ) );
+        return v;
+    }
+
+    template< typename T >
+    static constexpr T _extend( std::make_unsigned_t< T > v, size_t count ) {
+        if constexpr( std::is_signed_v< T > ) {
+            const int shift = 8 * ( int )( sizeof( T ) - count );
+            return ( T )( v << shift ) >> shift;
+        } else {
+            return ( T )v;
+        }
+    }
+
+public:
+    /* Wider fields than T keep their least significant sizeof( T ) bytes. */
+    template< typename T >
+    requires is_swappable_v< T >
+    static constexpr T as( const char* src, size_t count, BIT_END end ) {
+        if( count > sizeof( T ) ) {
+            if( end == BIT_END_BIG ) src += count - sizeof( T );
+            count = sizeof( T );
+        }
 
-        return *reinterpret_cast< T* >( dst );
+        return _extend< T >( _load< T >( src, count, end ), count );
     }
 
     template< typename T, size_t count >
-    requires std::is_integral_v< T >
-    static T as( char* src, BIT_END end ) {
-        if constexpr( count != sizeof( T ) )
-            return as< T >( src, count, end );
-        else {
-            switch( end ) {
-                case BIT_END_LITTLE: return *reinterpret_cast< T* >( src );
-                case BIT_END_BIG: {
-                    char dst[ sizeof( T ) ];
-
-                    for( size_t n = 0; n < count; ++n ) 
-                        dst[ n ] = src[ count - n - 1 ];
-
-                    return *reinterpret_cast< T* >( dst );
+    requires is_swappable_v< T >
+    static constexpr T as( const char* src, BIT_END end ) {
+        return as< T >( src, count, end );
+    }
+
+    template< typename T, BIT_END end >
+    requires is_swappable_v< T >
+    static constexpr T as( const char* src, size_t count ) {
+        return as< T >( src, count, end );
+    }
+
+    template< typename T, size_t count, BIT_END end >
+    requires is_swappable_v< T >
+    static constexpr T as( const char* src ) {
+        if constexpr( count > sizeof( T ) ) {
+            return as< T, sizeof( T ), end >( src + ( end == BIT_END_BIG ? count - sizeof( T ) : 0 ) );
+        } else if constexpr( count == sizeof( T ) ) {
+            if consteval {
+                return _extend< T >( _load< T >( src, count, end ), count );
+            } else {
+                T v; std::memcpy( &v, src, sizeof( T ) );
+                if constexpr( end != NATIVE_END ) v = std::byteswap( v );
+                return v;
+            }
+        } else {
+            return _extend< T >( _load< T >( src, count, end ), count );
+        }
+    }
+
+    template< typename T, size_t count, BIT_END end >
+    requires is_swappable_v< T >
+    static T as( const ubyte_t* src ) {
+        return as< T, count, end >( ( const char* )src );
+    }
+
+public:
+    /* n fields of count bytes each, packed back to back in src, into dst. */
+    template< typename T, size_t count, BIT_END end >
+    requires is_swappable_v< T > && ( count >= 1 && count <= sizeof( T ) )
+    static void convert_n( const char* src, T* dst, size_t n ) {
+        size_t at = 0;
+
+        if constexpr( count == sizeof( T ) && end == NATIVE_END ) {
+            std::memcpy( dst, src, n * sizeof( T ) );
+            return;
+        }
+
+    #if defined( _ENGINE_AVX )
+        if constexpr( count == sizeof( T ) && count > 1 ) {
+            /* Whole words, reversed in place within each lane. */
+            alignas( 32 ) char mask[ 32 ];
+            for( int b = 0; b < 32; ++b )
+                mask[ b ] = ( char )( ( b / count ) * count + count - 1 - b % count ) & 0xF;
+
+            const __m256i shuf = _mm256_load_si256( ( const __m256i* )mask );
+
+            for( ; at + 32 / count <= n; at += 32 / count ) {
+                __m256i v = _mm256_loadu_si256( ( const __m256i* )( src + at * count ) );
+                _mm256_storeu_si256( ( __m256i* )( dst + at ), _mm256_shuffle_epi8( v, shuf ) );
+            }
+        } else if constexpr( count == 3 && sizeof( T ) == 4 ) {
+            /* Four 24 bit fields per 128 bit lane, placed in the top bytes of each word, then shifted down. */
+            alignas( 32 ) char mask[ 32 ];
+            for( int lane = 0; lane < 2; ++lane )
+                for( int w = 0; w < 4; ++w ) {
+                    char* m = mask + lane * 16 + w * 4;
+                    m[ 0 ] = ( char )0x80;
+                    for( int b = 0; b < 3; ++b )
+                        m[ 1 + b ] = ( char )( w * 3 + ( end == BIT_END_LITTLE ? b : 2 - b ) );
                 }
+
+            const __m256i shuf = _mm256_load_si256( ( const __m256i* )mask );
+
+            /* The 16 byte loads read 4 past the 12 used, so stop while that stays inside the source. */
+            for( ; at + 8 <= n && ( at + 8 ) * 3 + 4 <= n * 3; at += 8 ) {
+                __m256i v = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256( _mm_loadu_si128( ( const __m128i* )( src + at * 3 ) ) ),
+                    _mm_loadu_si128( ( const __m128i* )( src + at * 3 + 12 ) ),
+                    1
+                );
+                v = _mm256_shuffle_epi8( v, shuf );
+                v = std::is_signed_v< T > ? _mm256_srai_epi32( v, 8 ) : _mm256_srli_epi32( v, 8 );
+                _mm256_storeu_si256( ( __m256i* )( dst + at ), v );
             }
         }
+    #endif
+
+        for( ; at < n; ++at )
+            dst[ at ] = as< T, count, end >( src + at * count );
     }
 
-    template< typename T, BIT_END end >
-    requires std::is_integral_v< T >
-    static T as( char* src, size_t count ) {
-        char dst[ sizeof( T ) ];
+    /* Reverses the bytes of every element, in place. */
+    template< typename T >
+    requires is_swappable_v< T >
+    static void byteswap_n( T* data, size_t n ) {
+        convert_n< T, sizeof( T ), NATIVE_END == BIT_END_LITTLE ? BIT_END_BIG : BIT_END_LITTLE >( ( const char* )data, data, n );
+    }
 
-        const bool is_negative =
-            ( *reinterpret_cast< char* >( src + ( end == BIT_END_LITTLE ? count - 1 : 0 ) ) ) >> 7
-            &&
-            std::is_signed_v< T >;
+};
 
-        for( size_t n = count; n < sizeof( T ); ++n )
-            dst[ n ] = is_negative ? -1 : 0;
+/*
+Bit streams, least significant bit first, the DEFLATE order. Fields are up to 64 bits wide, varints are LEB128 groups
+of 8 bits, zigzag maps small signed values to small unsigned ones. The reader refills its 64 bit buffer with a single
+unaligned 8 byte load where the source allows, reading past the end yields zeros and sets overrun().
+*/
+class BitWriter {
+public:
+    BitWriter() = default;
+
+    BitWriter( size_t reserve_bytes ) {
+        _out.reserve( reserve_bytes + 8 );
+    }
 
-        for( size_t n = 0; n < count && n < sizeof( T ); ++n )
-            dst[ n ] = src[ end == BIT_END_LITTLE ? n : count - n - 1 ];
+_ENGINE_PROTECTED:
+    std::vector< ubyte_t >   _out     = {};
+    size_t                   _size    = 0;
+    uint64_t                 _buf     = 0;
+    uint32_t                 _count   = 0;
 
-        return *reinterpret_cast< T* >( dst );
+_ENGINE_PROTECTED:
+    /* Whole buffered bytes out, through one 8 byte store. */
+    void _flush() {
+        const uint32_t bytes = _count >> 3;
+        const uint64_t le    = Bytes::NATIVE_END == BIT_END_LITTLE ? _buf : std::byteswap( _buf );
+
+        if( _out.size() < _size + 8 ) _out.resize( std::max< size_t >( _out.size() * 2, _size + 8 ) );
+        std::memcpy( _out.data() + _size, &le, 8 );
+
+        _size  += bytes;
+        _buf    = bytes == 8 ? 0 : _buf >> ( bytes * 8 );
+        _count &= 7;
     }
 
-    template< typename T, size_t count, BIT_END end >
-    requires std::is_integral_v< T >
-    static T as( char* src ) {
-        if constexpr( count != sizeof( T ) )
-            return as< T, end >( src, count );
-        else {
-            if constexpr( end == BIT_END_LITTLE )
-                return *reinterpret_cast< T* >( src );
-            else {
-                char dst[ sizeof( T ) ];
-
-                for( size_t n = 0; n < count; ++n ) 
-                    dst[ n ] = src[ count - n - 1 ];
-
-                return *reinterpret_cast< T* >( dst );
-            }
+public:
+    size_t bit_count() const { return _size * 8 + _count; }
+
+    size_t byte_count() const { return _size + ( _count + 7 ) / 8; }
+
+    BitWriter& write( uint64_t value, uint32_t bits ) {
+        if( bits > 56 ) {
+            this->write( value & 0xFF'FF'FF, 24 );
+            return this->write( value >> 24, bits - 24 );
         }
+
+        if( bits == 0 ) return *this;
+        if( _count + bits > 64 ) this->_flush();
+
+        _buf   |= ( value & ( ~0ull >> ( 64 - bits ) ) ) << _count;
+        _count += bits;
+        return *this;
+    }
+
+    BitWriter& write_signed( int64_t value, uint32_t bits ) {
+        return this->write( ( uint64_t )value, bits );
+    }
+
+    BitWriter& write_bit( bool bit ) {
+        return this->write( bit, 1 );
+    }
+
+    BitWriter& write_varint( uint64_t value ) {
+        for( ; value >= 0x80; value >>= 7 )
+            this->write( ( value & 0x7F ) | 0x80, 8 );
+        return this->write( value, 8 );
+    }
+
+    static uint64_t zigzag( int64_t value ) {
+        return ( ( uint64_t )value << 1 ) ^ ( uint64_t )( value >> 63 );
+    }
+
+    BitWriter& write_zigzag( int64_t value ) {
+        return this->write_varint( zigzag( value ) );
+    }
+
+    /* Pads with zeros to the next byte boundary. */
+    BitWriter& align() {
+        _count = ( _count + 7 ) & ~7u;
+        if( _count >= 64 ) this->_flush();
+        return *this;
+    }
+
+    /* Aligns, then the whole stream so far. Writing may go on afterwards. */
+    std::span< const ubyte_t > bytes() {
+        this->align();
+        this->_flush();
+        return { _out.data(), _size };
+    }
+
+    std::vector< ubyte_t > release() {
+        this->bytes();
+        _out.resize( _size );
+        _size = 0;
+        return std::move( _out );
+    }
+
+};
+
+class BitReader {
+public:
+    BitReader() = default;
+
+    BitReader( std::span< const ubyte_t > src )
+    : _src{ src }
+    {}
+
+_ENGINE_PROTECTED:
+    std::span< const ubyte_t >   _src       = {};
+    size_t                       _at        = 0;
+    uint64_t                     _buf       = 0;
+    uint32_t                     _count     = 0;
+    bool                         _overrun   = false;
+
+_ENGINE_PROTECTED:
+    void _refill() {
+        if( _at + 8 <= _src.size() ) {
+            /* Bytes already in the buffer are loaded again, OR-ing them in twice is harmless. */
+            uint64_t v; std::memcpy( &v, _src.data() + _at, 8 );
+            if constexpr( Bytes::NATIVE_END != BIT_END_LITTLE ) v = std::byteswap( v );
+
+            _buf   |= v << _count;
+            _at    += ( 63 - _count ) >> 3;
+            _count |= 56;
+            return;
+        }
+
+        for( ; _count <= 56; _count += 8, ++_at )
+            if( _at < _src.size() ) _buf |= ( uint64_t )_src[ _at ] << _count;
+    }
+
+public:
+    size_t bit_count() const { return _src.size() * 8; }
+
+    /* Bits consumed so far. */
+    size_t bit_pos() const { return _at * 8 - _count; }
+
+    size_t bits_left() const { return this->bit_pos() < this->bit_count() ? this->bit_count() - this->bit_pos() : 0; }
+
+    bool overrun() const { return _overrun; }
+
+    /* Only up to 56 bits are guaranteed after a refill, read() and skip() split wider fields. */
+    uint64_t peek( uint32_t bits ) {
+        if( bits == 0 ) return 0;
+        if( _count < bits ) this->_refill();
+        return _buf & ( ~0ull >> ( 64 - bits ) );
+    }
+
+    void skip( uint32_t bits ) {
+        if( bits > 56 ) {
+            this->skip( 24 );
+            return this->skip( bits - 24 );
+        }
+
+        if( _count < bits ) this->_refill();
+        _buf   >>= bits;
+        _count  -= bits;
+        _overrun |= this->bit_pos() > this->bit_count();
+    }
+
+    uint64_t read( uint32_t bits ) {
+        if( bits > 56 ) {
+            const uint64_t lo = this->read( 24 );
+            return lo | this->read( bits - 24 ) << 24;
+        }
+
+        const uint64_t v = this->peek( bits );
+        this->skip( bits );
+        return v;
+    }
+
+    int64_t read_signed( uint32_t bits ) {
+        if( bits == 0 ) return 0;
+
+        const uint32_t shift = 64 - bits;
+        return ( int64_t )( this->read( bits ) << shift ) >> shift;
+    }
+
+    bool read_bit() {
+        return this->read( 1 );
+    }
+
+    uint64_t read_varint() {
+        uint64_t value = 0;
+
+        for( uint32_t shift = 0; shift < 64; shift += 7 ) {
+            const uint64_t group = this->read( 8 );
+            value |= ( group & 0x7F ) << shift;
+
+            if( !( group & 0x80 ) ) return value;
+        }
+
+        _overrun = true;
+        return value;
+    }
+
+    static int64_t unzigzag( uint64_t value ) {
+        return ( int64_t )( value >> 1 ) ^ -( int64_t )( value & 1 );
+    }
+
+    int64_t read_zigzag() {
+        return unzigzag( this->read_varint() );
+    }
+
+    void align() {
+        this->skip( _count & 7 );
     }
 
 };
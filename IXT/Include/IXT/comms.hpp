@@ -361,12 +361,17 @@ public:
             return nullptr;
         }
 
+        /* Echoes get built on any thread, pool workers included. */
+        std::unique_lock lock{ _out_mtx };
         return *_supervisor.emplace( dump ).first;
     }
 
     void delete_echo_dump( Echo::Dump* dump ) {
+        {
+            std::unique_lock lock{ _out_mtx };
+            _supervisor.erase( dump );
+        }
         delete dump;
-        _supervisor.erase( dump );
     }
 
 _ENGINE_PROTECTED:
@@ -0,0 +1,352 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/comms.hpp>
+#include <IXT/image.hpp>
+#include <IXT/thread-pool.hpp>
+#include <IXT/profiler.hpp>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+enum COMPOSITE_OP : BYTE {
+    COMPOSITE_OP_NONE = 0,
+    COMPOSITE_OP_COPY,
+    COMPOSITE_OP_FILL,
+    COMPOSITE_OP_DIFF_MASK
+};
+
+/* Holds when input lhs_src's lhs_ch and input rhs_src's rhs_ch differ by more than threshold. */
+struct CompositeTerm {
+    BYTE   lhs_src     = 0;
+    BYTE   lhs_ch      = 0;
+    BYTE   rhs_src     = 0;
+    BYTE   rhs_ch      = 0;
+    UBYTE  threshold   = 0;
+};
+
+
+
+/*
+Builds every output channel from the input images: copied from an input channel, filled with a constant,
+or set to 255 where all of a list of channel differences hold, 0 elsewhere. Rows are processed one at a time,
+each fully read before it is written, so the output may be one of the inputs. run_rows() works on any
+band of rows, which is what streaming callers feed it.
+*/
+class Compositor : public Descriptor {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Compositor" );
+
+public:
+    inline static constexpr uint16_t   MAX_CHANNELS   = 4;
+
+public:
+    Compositor() = default;
+
+    Compositor( uint16_t out_channels )
+    : _out_channels{ std::min( out_channels, MAX_CHANNELS ) }
+    {}
+
+_ENGINE_PROTECTED:
+    struct _Channel {
+        COMPOSITE_OP                   op      = COMPOSITE_OP_NONE;
+        BYTE                           src     = 0;
+        BYTE                           ch      = 0;
+        UBYTE                          value   = 0;
+        std::vector< CompositeTerm >   terms   = {};
+    };
+
+_ENGINE_PROTECTED:
+    uint16_t                           _out_channels   = 0;
+    _Channel                           _channels[ MAX_CHANNELS ];
+
+_ENGINE_PROTECTED:
+#if defined( _ENGINE_AVX )
+    /* 
+    The interleaved kernels go 8 pixels at a time, 4 in either 128 bit lane, as the byte shuffles do not cross lanes.
+    pick takes channel ch of the 4 pixels into the lane's first dword, put sends that dword back out to them, and
+    keep marks their channel bytes.
+    */
+    template< int C >
+    static void _quad_masks( int32_t ch, __m256i& pick, __m256i& put, __m256i& keep ) {
+        alignas( 32 ) char m_pick[ 32 ];
+        alignas( 32 ) char m_put[ 32 ];
+        alignas( 32 ) char m_keep[ 32 ];
+
+        for( int b = 0; b < 32; ++b ) {
+            const int at = b % 16;
+
+            m_pick[ b ] = at < 4 ? ( char )( at * C + ch ) : ( char )0x80;
+            m_put[ b ]  = ( char )0x80;
+            m_keep[ b ] = 0;
+
+            if( at % C == ch && at / C < 4 ) {
+                m_put[ b ]  = ( char )( at / C );
+                m_keep[ b ] = ( char )0xFF;
+            }
+        }
+
+        pick = _mm256_load_si256( ( const __m256i* )m_pick );
+        put  = _mm256_load_si256( ( const __m256i* )m_put );
+        keep = _mm256_load_si256( ( const __m256i* )m_keep );
+    }
+
+    /* Pixels [ 0, 4 ) in the low lane, [ 4, 8 ) in the high one. For 3 channels, either lane reads 4 bytes past its pixels. */
+    template< int C >
+    static __m256i _load_quads( const ubyte_t* px ) {
+        if constexpr( C == 4 ) 
+            return _mm256_loadu_si256( ( const __m256i* )px );
+        else
+            return _mm256_inserti128_si256( 
+                _mm256_castsi128_si256( _mm_loadu_si128( ( const __m128i* )px ) ), 
+                _mm_loadu_si128( ( const __m128i* )( px + 4 * C ) ), 1 
+            );
+    }
+
+    /* The high lane goes last, so where they overlap, for 3 channels, its bytes win, which are the untouched ones. */
+    template< int C >
+    static void _store_quads( ubyte_t* px, __m256i v ) {
+        if constexpr( C == 4 ) {
+            _mm256_storeu_si256( ( __m256i* )px, v );
+        } else {
+            _mm_storeu_si128( ( __m128i* )px, _mm256_castsi256_si128( v ) );
+            _mm_storeu_si128( ( __m128i* )( px + 4 * C ), _mm256_extracti128_si256( v, 1 ) );
+        }
+    }
+
+    /* Whether 32 pixels from x on, plus the overread of the last quad, fit in the row. */
+    template< int C >
+    static bool _fits_32( int32_t x, int32_t width ) {
+        return ( x + 28 ) * C + 16 <= width * C;
+    }
+#endif
+
+    template< int C >
+    static void _gather( const ubyte_t* row, int32_t ch, ubyte_t* plane, int32_t width ) {
+        int32_t x = 0;
+    #if defined( _ENGINE_AVX )
+        if constexpr( C >= 3 ) {
+            __m256i pick, put, keep;
+            _quad_masks< C >( ch, pick, put, keep );
+
+            /* The lanes hold pixels { 0, 8, 16, 24 } + [ 0, 4 ) and { 4, 12, 20, 28 } + [ 0, 4 ), a dword each. */
+            const __m256i order = _mm256_setr_epi32( 0, 4, 1, 5, 2, 6, 3, 7 );
+
+            for( ; _fits_32< C >( x, width ); x += 32 ) {
+                const ubyte_t* px = row + x * C;
+
+                __m256i v = _mm256_shuffle_epi8( _load_quads< C >( px ), pick );
+                v = _mm256_or_si256( v, _mm256_bslli_epi128( _mm256_shuffle_epi8( _load_quads< C >( px + 8 * C ), pick ), 4 ) );
+                v = _mm256_or_si256( v, _mm256_bslli_epi128( _mm256_shuffle_epi8( _load_quads< C >( px + 16 * C ), pick ), 8 ) );
+                v = _mm256_or_si256( v, _mm256_bslli_epi128( _mm256_shuffle_epi8( _load_quads< C >( px + 24 * C ), pick ), 12 ) );
+
+                _mm256_storeu_si256( ( __m256i* )( plane + x ), _mm256_permutevar8x32_epi32( v, order ) );
+            }
+        }
+    #endif
+        for( ; x < width; ++x )
+            plane[ x ] = row[ x * C + ch ];
+    }
+
+    static void _gather( const ubyte_t* row, int32_t C, int32_t ch, ubyte_t* plane, int32_t width ) {
+        switch( C ) {
+            case 1:  std::memcpy( plane, row, width ); break;
+            case 2:  _gather< 2 >( row, ch, plane, width ); break;
+            case 3:  _gather< 3 >( row, ch, plane, width ); break;
+            default: _gather< 4 >( row, ch, plane, width ); break;
+        }
+    }
+
+    template< int C >
+    static void _scatter( const ubyte_t* plane, ubyte_t* row, int32_t ch, int32_t width ) {
+        int32_t x = 0;
+    #if defined( _ENGINE_AVX )
+        if constexpr( C >= 3 ) {
+            __m256i pick, put, keep;
+            _quad_masks< C >( ch, pick, put, keep );
+
+            /* The inverse of the gather's order, every quad of pixels lands in the lane it is written from. */
+            const __m256i order = _mm256_setr_epi32( 0, 2, 4, 6, 1, 3, 5, 7 );
+
+            for( ; _fits_32< C >( x, width ); x += 32 ) {
+                ubyte_t*      px = row + x * C;
+                const __m256i v  = _mm256_permutevar8x32_epi32( _mm256_loadu_si256( ( const __m256i* )( plane + x ) ), order );
+
+                _store_quads< C >( px, _mm256_blendv_epi8( _load_quads< C >( px ), _mm256_shuffle_epi8( v, put ), keep ) );
+                _store_quads< C >( px + 8 * C, _mm256_blendv_epi8( _load_quads< C >( px + 8 * C ), _mm256_shuffle_epi8( _mm256_bsrli_epi128( v, 4 ), put ), keep ) );
+                _store_quads< C >( px + 16 * C, _mm256_blendv_epi8( _load_quads< C >( px + 16 * C ), _mm256_shuffle_epi8( _mm256_bsrli_epi128( v, 8 ), put ), keep ) );
+                _store_quads< C >( px + 24 * C, _mm256_blendv_epi8( _load_quads< C >( px + 24 * C ), _mm256_shuffle_epi8( _mm256_bsrli_epi128( v, 12 ), put ), keep ) );
+            }
+        }
+    #endif
+        for( ; x < width; ++x )
+            row[ x * C + ch ] = plane[ x ];
+    }
+
+    static void _scatter( const ubyte_t* plane, ubyte_t* row, int32_t C, int32_t ch, int32_t width ) {
+        switch( C ) {
+            case 1:  std::memcpy( row, plane, width ); break;
+            case 2:  _scatter< 2 >( plane, row, ch, width ); break;
+            case 3:  _scatter< 3 >( plane, row, ch, width ); break;
+            default: _scatter< 4 >( plane, row, ch, width ); break;
+        }
+    }
+
+    /* mask &= |lhs - rhs| > threshold, byte wise. */
+    static void _diff_mask( ubyte_t* mask, const ubyte_t* lhs, const ubyte_t* rhs, UBYTE threshold, int32_t width ) {
+        int32_t x = 0;
+    #if defined( _ENGINE_AVX )
+        const __m256i thr  = _mm256_set1_epi8( ( char )threshold );
+        const __m256i zero = _mm256_setzero_si256();
+
+        for( ; x + 32 <= width; x += 32 ) {
+            __m256i l = _mm256_loadu_si256( ( const __m256i* )( lhs + x ) );
+            __m256i r = _mm256_loadu_si256( ( const __m256i* )( rhs + x ) );
+            __m256i d = _mm256_or_si256( _mm256_subs_epu8( l, r ), _mm256_subs_epu8( r, l ) );
+            __m256i m = _mm256_loadu_si256( ( const __m256i* )( mask + x ) );
+
+            m = _mm256_andnot_si256( _mm256_cmpeq_epi8( _mm256_subs_epu8( d, thr ), zero ), m );
+            _mm256_storeu_si256( ( __m256i* )( mask + x ), m );
+        }
+    #endif
+        for( ; x < width; ++x )
+            mask[ x ] &= ( ( lhs[ x ] > rhs[ x ] ? lhs[ x ] - rhs[ x ] : rhs[ x ] - lhs[ x ] ) > threshold ) ? 0xFF : 0x00;
+    }
+
+    /* Every input channel read, against the inputs at hand. */
+    bool _sources_ok( std::span< const ImageView > inputs, _ENGINE_COMMS_ECHO_ARG ) const {
+        auto ok = [ & ] ( uint16_t oc, BYTE src, BYTE ch ) -> bool {
+            if( src >= 0 && ( size_t )src < inputs.size() && ch >= 0 && ch < inputs[ src ].channels ) return true;
+
+            echo( this, ECHO_LEVEL_ERROR ) << "Output channel " << oc << " reads channel " << ( int )ch << " of input " << ( int )src << ", out of the " << inputs.size() << " given.";
+            return false;
+        };
+
+        for( uint16_t oc = 0; oc < _out_channels; ++oc ) {
+            const _Channel& chan = _channels[ oc ];
+
+            if( chan.op == COMPOSITE_OP_COPY && !ok( oc, chan.src, chan.ch ) ) return false;
+
+            if( chan.op != COMPOSITE_OP_DIFF_MASK ) continue;
+
+            for( auto& term : chan.terms )
+                if( !ok( oc, term.lhs_src, term.lhs_ch ) || !ok( oc, term.rhs_src, term.rhs_ch ) ) return false;
+        }
+
+        return true;
+    }
+
+    bool _out_channel_ok( BYTE out_ch, _ENGINE_COMMS_ECHO_ARG ) const {
+        if( out_ch >= 0 && out_ch < _out_channels ) return true;
+
+        echo( this, ECHO_LEVEL_WARNING ) << "Output channel " << ( int )out_ch << " out of the " << _out_channels << " composed. Ignored.";
+        return false;
+    }
+
+public:
+    uint16_t out_channels() const { return _out_channels; }
+
+    Compositor& copy( BYTE out_ch, BYTE src, BYTE src_ch, _ENGINE_COMMS_ECHO_ARG ) {
+        if( !this->_out_channel_ok( out_ch, echo ) ) return *this;
+
+        _channels[ out_ch ] = _Channel{ op: COMPOSITE_OP_COPY, src: src, ch: src_ch };
+        return *this;
+    }
+
+    Compositor& fill( BYTE out_ch, UBYTE value, _ENGINE_COMMS_ECHO_ARG ) {
+        if( !this->_out_channel_ok( out_ch, echo ) ) return *this;
+
+        _channels[ out_ch ] = _Channel{ op: COMPOSITE_OP_FILL, value: value };
+        return *this;
+    }
+
+    Compositor& diff_mask( BYTE out_ch, std::initializer_list< CompositeTerm > terms, _ENGINE_COMMS_ECHO_ARG ) {
+        if( !this->_out_channel_ok( out_ch, echo ) ) return *this;
+
+        _channels[ out_ch ] = _Channel{ op: COMPOSITE_OP_DIFF_MASK, terms: terms };
+        return *this;
+    }
+
+public:
+    /* 
+    Rows [ y0, y1 ) of every view. The inputs and the output shall share width and the row range, and hold every
+    channel read, nothing is checked here, run() does that once for the whole view.
+    */
+    void run_rows( std::span< const ImageView > inputs, const ImageView& out, int32_t y0, int32_t y1 ) const {
+        const int32_t W = out.width;
+
+        /* Planes: one per output channel, plus two for diff terms. */
+        std::vector< ubyte_t > planes( ( size_t )W * ( MAX_CHANNELS + 2 ) );
+        ubyte_t*               lhs = planes.data() + ( size_t )W * MAX_CHANNELS;
+        ubyte_t*               rhs = lhs + W;
+
+        for( int32_t y = y0; y < y1; ++y ) {
+            for( uint16_t oc = 0; oc < _out_channels; ++oc ) {
+                const _Channel& chan  = _channels[ oc ];
+                ubyte_t*        plane = planes.data() + ( size_t )W * oc;
+
+                switch( chan.op ) {
+                    case COMPOSITE_OP_COPY: {
+                        const ImageView& in = inputs[ chan.src ];
+                        _gather( in.row( y ), in.channels, chan.ch, plane, W );
+                    break; }
+
+                    case COMPOSITE_OP_FILL: {
+                        std::memset( plane, chan.value, W );
+                    break; }
+
+                    case COMPOSITE_OP_DIFF_MASK: {
+                        std::memset( plane, 0xFF, W );
+
+                        for( auto& term : chan.terms ) {
+                            const ImageView& l = inputs[ term.lhs_src ];
+                            const ImageView& r = inputs[ term.rhs_src ];
+
+                            _gather( l.row( y ), l.channels, term.lhs_ch, lhs, W );
+                            _gather( r.row( y ), r.channels, term.rhs_ch, rhs, W );
+                            _diff_mask( plane, lhs, rhs, term.threshold, W );
+                        }
+                    break; }
+
+                    default: break;
+                }
+            }
+
+            for( uint16_t oc = 0; oc < _out_channels; ++oc )
+                if( _channels[ oc ].op != COMPOSITE_OP_NONE )
+                    _scatter( planes.data() + ( size_t )W * oc, out.row( y ), out.channels, oc, W );
+        }
+    }
+
+    /* Whole views, rows spread over the pool. */
+    bool run( std::span< const ImageView > inputs, const ImageView& out, ThreadPool& pool = ThreadPool::shared(), _ENGINE_COMMS_ECHO_ARG ) const {
+        IXT_ZONE( "Compositor::run" );
+
+        for( auto& in : inputs )
+            if( in.width != out.width || in.height != out.height ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Input and output shapes don't match.";
+                return false;
+            }
+
+        if( out.channels < _out_channels ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Output has fewer channels than composed.";
+            return false;
+        }
+
+        if( !this->_sources_ok( inputs, echo ) ) return false;
+
+        out.parallel_for_rows( [ & ] ( int32_t lo, int32_t hi ) -> void {
+            this->run_rows( inputs, out, lo, hi );
+        }, 32, pool );
+
+        return true;
+    }
+
+};
+
+
+
+};
@@ -7,6 +7,9 @@
 #include <IXT/comms.hpp>
 #include <IXT/file-manip.hpp>
 #include <IXT/hyper-vector.hpp>
+#include <IXT/image.hpp>
+#include <IXT/lock-free.hpp>
+#include <IXT/pcm.hpp>
 
 
 
@@ -32,83 +35,587 @@ public:
         WAV_FMT_DATA_OFS = 0x2C
     };
 
+    enum WAV_TAG : uint16_t {
+        WAV_TAG_PCM        = 0x0001,
+        WAV_TAG_IEEE_FLOAT = 0x0003,
+        WAV_TAG_EXTENSIBLE = 0xFFFE
+    };
+
+    struct WavFmt {
+        uint16_t   tag               = 0;
+        WORD       tunnel_count      = 0;
+        DWORD      sample_rate       = 0;
+        uint16_t   block_align       = 0;
+        uint16_t   bits_per_sample   = 0;
+
+        uint64_t   data_ofs          = 0;
+        uint64_t   data_size         = 0;
+
+        uint16_t bytes_per_sample() const {
+            return bits_per_sample / 8;
+        }
+
+        uint64_t frame_count() const {
+            return block_align == 0 ? 0 : data_size / block_align;
+        }
+
+        bool is_float() const {
+            return tag == WAV_TAG_IEEE_FLOAT;
+        }
+
+        PCM_FMT pcm_fmt() const {
+            return Pcm::fmt_of( bits_per_sample, this->is_float() );
+        }
+    };
+
+    /* 
+    Walks the RIFF chunks of a WAVE file, filling the "fmt " fields and locating the "data" chunk.
+    Unknown chunks ( LIST, fact, cue, ... ) are skipped. Leaves the stream positioned at the start of the samples.
+    */
+    static DWORD wav_riff_walk( std::istream& file, WavFmt& fmt, _ENGINE_COMMS_ECHO_ARG ) {
+        static struct _Invoker : Descriptor {
+            _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::wav_riff_walk" );
+        } invoker;
+
+        char riff[ 12 ];
+
+        if( !file.read( riff, sizeof( riff ) ) || memcmp( riff, "RIFF", 4 ) != 0 || memcmp( riff + 8, "WAVE", 4 ) != 0 ) {
+            echo( invoker, ECHO_LEVEL_ERROR ) << "Not a RIFF/WAVE stream.";
+            return -1;
+        }
+
+        bool has_fmt  = false;
+        bool has_data = false;
+
+        for( char head[ 8 ]; !has_data && file.read( head, sizeof( head ) ); ) {
+            uint64_t size = Bytes::as< udword_t, 4, BIT_END_LITTLE >( head + 4 );
+
+            if( memcmp( head, "fmt ", 4 ) == 0 ) {
+                char body[ 40 ] = {};
+
+                if( size < 16 || !file.read( body, std::min< uint64_t >( size, sizeof( body ) ) ) ) {
+                    echo( invoker, ECHO_LEVEL_ERROR ) << "Ill-formed \"fmt \" chunk.";
+                    return -1;
+                }
+
+                fmt.tag             = Bytes::as< uint16_t, 2, BIT_END_LITTLE >( body + 0x0 );
+                fmt.tunnel_count    = Bytes::as< WORD, 2, BIT_END_LITTLE >( body + 0x2 );
+                fmt.sample_rate     = Bytes::as< DWORD, 4, BIT_END_LITTLE >( body + 0x4 );
+                fmt.block_align     = Bytes::as< uint16_t, 2, BIT_END_LITTLE >( body + 0xC );
+                fmt.bits_per_sample = Bytes::as< uint16_t, 2, BIT_END_LITTLE >( body + 0xE );
+
+                if( fmt.tag == WAV_TAG_EXTENSIBLE && size >= 26 )
+                    fmt.tag = Bytes::as< uint16_t, 2, BIT_END_LITTLE >( body + 0x18 );
+
+                if( size > sizeof( body ) )
+                    file.seekg( size - sizeof( body ), std::ios_base::cur );
+
+                has_fmt = true;
+            } else if( memcmp( head, "data", 4 ) == 0 ) {
+                fmt.data_ofs  = file.tellg();
+                fmt.data_size = size;
+
+                has_data = true;
+                break;
+            } else {
+                file.seekg( size, std::ios_base::cur );
+            }
+
+            if( size & 1 ) file.seekg( 1, std::ios_base::cur );
+        }
+
+        if( !has_fmt || !has_data ) {
+            echo( invoker, ECHO_LEVEL_ERROR ) << "Missing " << ( has_fmt ? "\"data\"" : "\"fmt \"" ) << " chunk.";
+            return -1;
+        }
+
+        if( fmt.tag != WAV_TAG_PCM && fmt.tag != WAV_TAG_IEEE_FLOAT ) {
+            echo( invoker, ECHO_LEVEL_ERROR ) << "Unsupported format tag: " << fmt.tag << ".";
+            return -1;
+        }
+
+        if( fmt.tunnel_count == 0 || fmt.bits_per_sample % 8 != 0 || fmt.bits_per_sample == 0 || fmt.bits_per_sample > 32 ) {
+            echo( invoker, ECHO_LEVEL_ERROR ) << "Unsupported layout: " << fmt.tunnel_count << " tunnels of " << fmt.bits_per_sample << " bits.";
+            return -1;
+        }
+
+        if( fmt.is_float() && fmt.bits_per_sample != 32 ) {
+            echo( invoker, ECHO_LEVEL_ERROR ) << "Unsupported float layout of " << fmt.bits_per_sample << " bits.";
+            return -1;
+        }
+
+        if( fmt.block_align != fmt.tunnel_count * fmt.bytes_per_sample() ) {
+            echo( invoker, ECHO_LEVEL_WARNING ) << "Reported block align ( " << fmt.block_align << " ) mismatches the tunnel layout. Recomputed.";
+            fmt.block_align = fmt.tunnel_count * fmt.bytes_per_sample();
+        }
+
+        if( fmt.data_size % fmt.block_align != 0 )
+            echo( invoker, ECHO_LEVEL_WARNING ) << "Sample count does not distribute evenly on channel count.";
+
+        return 0;
+    }
+
+    /* Converts count raw little endian samples, of the given format, into T, normalized to [ -1, 1 ) if T is floating point. */
     template< typename T >
-    class Wav : public Descriptor {
+    static void wav_decode( const char* src, T* dst, size_t count, const WavFmt& fmt ) {
+        if constexpr( std::is_floating_point_v< T > ) {
+            Pcm::decode( src, dst, count, fmt.pcm_fmt() );
+        } else {
+            const uint16_t bps = fmt.bytes_per_sample();
+
+            if( fmt.is_float() ) {
+                for( size_t n = 0; n < count; ++n, src += bps ) {
+                    float raw; memcpy( &raw, src, sizeof( raw ) );
+                    dst[ n ] = static_cast< T >( raw );
+                }
+            } else if( bps == 1 ) {
+                for( size_t n = 0; n < count; ++n )
+                    dst[ n ] = static_cast< T >( static_cast< int >( ( ubyte_t )src[ n ] ) - 128 );
+            } else if constexpr( std::is_signed_v< T > && sizeof( T ) == 4 ) {
+                switch( bps ) {
+                    case 2:  Bytes::convert_n< T, 2, BIT_END_LITTLE >( src, dst, count ); break;
+                    case 3:  Bytes::convert_n< T, 3, BIT_END_LITTLE >( src, dst, count ); break;
+                    default: Bytes::convert_n< T, 4, BIT_END_LITTLE >( src, dst, count ); break;
+                }
+            } else {
+                for( size_t n = 0; n < count; ++n, src += bps )
+                    dst[ n ] = static_cast< T >( Bytes::as< int, BIT_END_LITTLE >( src, bps ) );
+            }
+        }
+    }
+
+    /*
+    Chunked WAV decoder. Holds only a fixed staging buffer of chunk_frame_count frames, 
+    decoding on demand, either into plain memory or into a SpscRing.
+    */
+    template< typename T >
+    class WavStream : public Descriptor {
     public:
-        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::Wav<T>" );
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::WavStream<T>" );
+
     public:
-        Wav() = default;
+        WavStream() = default;
 
-        Wav( std::string_view path, _ENGINE_COMMS_ECHO_ARG ) {
-            using namespace std::string_literals;
+        WavStream( std::string_view path, size_t chunk_frame_count = 4096, _ENGINE_COMMS_ECHO_ARG )
+        : _file{ path.data(), std::ios_base::binary }
+        {
+            if( !_file ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.data() << "\".";
+                return;
+            }
+
+            if( wav_riff_walk( _file, _fmt, echo ) != 0 ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT parse RIFF chunks of: \"" << path.data() << "\".";
+                _file.close();
+                return;
+            }
 
+            _chunk_frame_count = std::max< size_t >( chunk_frame_count, 1 );
+            _staging.reset( new char[ _chunk_frame_count * _fmt.block_align ] );
 
-            std::ifstream file{ path.data(), std::ios_base::binary };
+            echo( this, ECHO_LEVEL_OK ) << "Streaming from: \"" << path.data() << "\".";
+        }
 
-            if( !file ) {
-                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.data() << "\".";
-                return;
+        WavStream( const WavStream& ) = delete;
+        WavStream( WavStream&& ) = default;
+
+    _ENGINE_PROTECTED:
+        std::ifstream    _file                = {};
+        WavFmt           _fmt                 = {};
+
+        size_t           _chunk_frame_count   = 0;
+        UPtr< char[] >   _staging             = nullptr;
+
+        uint64_t         _frame_at            = 0;
+
+    public:
+        operator bool () const {
+            return _staging != nullptr;
+        }
+
+        const WavFmt& fmt() const {
+            return _fmt;
+        }
+
+        DWORD sample_rate() const { return _fmt.sample_rate; }
+        WORD tunnel_count() const { return _fmt.tunnel_count; }
+        uint64_t frame_count() const { return _fmt.frame_count(); }
+
+        uint64_t frame_at() const { return _frame_at; }
+        bool eos() const { return _frame_at >= _fmt.frame_count(); }
+
+    public:
+        WavStream& seek( uint64_t frame ) {
+            _frame_at = std::min( frame, _fmt.frame_count() );
+
+            _file.clear();
+            _file.seekg( _fmt.data_ofs + _frame_at * _fmt.block_align, std::ios_base::beg );
+
+            return *this;
+        }
+
+        /* Decodes up to frame_count interleaved frames into dst. Returns the decoded frame count. */
+        size_t pull( T* dst, size_t frame_count ) {
+            size_t done = 0;
+
+            while( done < frame_count && !this->eos() ) {
+                size_t frames = std::min< uint64_t >( { frame_count - done, _chunk_frame_count, _fmt.frame_count() - _frame_at } );
+
+                if( !_file.read( _staging.get(), frames * _fmt.block_align ) ) {
+                    frames = _file.gcount() / _fmt.block_align;
+                    _fmt.data_size = ( _frame_at + frames ) * _fmt.block_align;
+                }
+
+                wav_decode< T >( _staging.get(), dst + done * _fmt.tunnel_count, frames * _fmt.tunnel_count, _fmt );
+
+                _frame_at += frames;
+                done      += frames;
+
+                if( frames == 0 ) break;
+            }
+
+            return done;
+        }
+
+        /* Decodes whole frames into the free space of ring, at most one chunk per span. Returns the decoded frame count. */
+        size_t pull( SpscRing< T >& ring, size_t frame_count = ~size_t{ 0 } ) {
+            size_t done = 0;
+
+            while( done < frame_count && !this->eos() ) {
+                auto   span   = ring.write_span( ( frame_count - done ) * _fmt.tunnel_count );
+                size_t frames = std::min( span.size() / _fmt.tunnel_count, _chunk_frame_count );
+
+                if( frames == 0 ) break;
+
+                frames = this->pull( span.data(), frames );
+                ring.commit( frames * _fmt.tunnel_count );
+
+                done += frames;
+
+                if( frames == 0 ) break;
             }
-        
 
-            size_t byte_count = File::byte_count( file );
+            return done;
+        }
+
+    };
+
+    /*
+    Zero-copy WAV access. Maps the file read-only, validates its chunks and exposes the samples in their native format.
+    The mapping is shared with the OS page cache, so resident cost is little more than the file itself.
+    */
+    class WavView : public Descriptor {
+    public:
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::WavView" );
+
+    public:
+        WavView() = default;
 
-            UPtr< char[] > raw_stream{ new char[ byte_count ] };
+        WavView( std::string_view path, _ENGINE_COMMS_ECHO_ARG )
+        : _map{ path, FILE_MAP_MODE_READ, FILE_MAP_HINT_RANDOM, echo }
+        {
+            if( !_map ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT map file: \"" << path.data() << "\".";
+                return;
+            }
 
+            std::ispanstream in{ std::span< const char >{ this->_base(), _map.size() } };
 
-            if( !raw_stream ) {
-                echo( this, ECHO_LEVEL_ERROR ) << "Bad alloc for file read buffer.";
+            if( wav_riff_walk( in, _fmt, echo ) != 0 ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT parse RIFF chunks of: \"" << path.data() << "\".";
+                _map = {};
                 return;
             }
 
+            if( _fmt.data_ofs + _fmt.data_size > _map.size() ) {
+                echo( this, ECHO_LEVEL_WARNING ) << "Data chunk overruns the file. Truncated.";
+                _fmt.data_size = ( _map.size() - _fmt.data_ofs ) / _fmt.block_align * _fmt.block_align;
+            }
+
+            _pcm_fmt = _fmt.pcm_fmt();
 
-            file.read( raw_stream.get(), byte_count );
+            echo( this, ECHO_LEVEL_OK ) << "Mapped from: \"" << path.data() << "\".";
+        }
 
+        WavView( const WavView& ) = delete;
+        WavView( WavView&& ) = default;
 
-            tunnel_count = Bytes::as< WORD, WAV_FMT_CHANNEL_COUNT_SZ, BIT_END_LITTLE >( &WAV_FMT_CHANNEL_COUNT_OFS[ raw_stream.get() ] );
+    _ENGINE_PROTECTED:
+        File::Map     _map       = {};
 
-            sample_rate = Bytes::as< DWORD, WAV_FMT_SAMPLE_RATE_SZ, BIT_END_LITTLE >( &WAV_FMT_SAMPLE_RATE_OFS[ raw_stream.get() ] );
+        WavFmt        _fmt       = {};
+        PCM_FMT       _pcm_fmt   = PCM_FMT_S16;
 
-            bits_per_sample = Bytes::as< uint16_t, WAV_FMT_BITS_PER_SAMPLE_SZ, BIT_END_LITTLE >( &WAV_FMT_BITS_PER_SAMPLE_OFS[ raw_stream.get() ] );
+    _ENGINE_PROTECTED:
+        const char* _base() const {
+            return ( const char* )_map.data();
+        }
 
-            uint16_t bytes_per_sample = bits_per_sample / 8;
+    public:
+        operator bool () const {
+            return ( bool )_map;
+        }
 
-            sample_count = Bytes::as< uint64_t, WAV_FMT_SAMPLE_COUNT_SZ, BIT_END_LITTLE >( &WAV_FMT_SAMPLE_COUNT_OFS[ raw_stream.get() ] ) / bytes_per_sample;
+        const WavFmt& fmt() const { return _fmt; }
+        PCM_FMT pcm_fmt() const { return _pcm_fmt; }
 
+        DWORD sample_rate() const { return _fmt.sample_rate; }
+        WORD tunnel_count() const { return _fmt.tunnel_count; }
+        uint64_t frame_count() const { return _fmt.frame_count(); }
 
-            stream.vector( ( T* )malloc( sample_count * sizeof( T ) ) );
+    public:
+        /* Access pattern hint for the data chunk, see File::Map::advise. */
+        WavView& advise( FILE_MAP_HINT hint ) {
+            _map.advise( hint, _fmt.data_ofs, _fmt.data_size );
+            return *this;
+        }
 
-            if( !stream ) {
-                echo( this, ECHO_LEVEL_ERROR ) << "Bad alloc for stream buffer.";
+        std::span< const ubyte_t > bytes() const {
+            return { _map.data() + _fmt.data_ofs, _fmt.data_size };
+        }
+
+        /* 
+        Interleaved samples as their native type: uint8_t, int16_t, int32_t or float. 
+        Empty if S does not match the format, or if the data chunk is misaligned for S. 24 bit data has no native type, go through bytes().
+        */
+        template< typename S >
+        std::span< const S > samples() const {
+            constexpr PCM_FMT want = std::is_same_v< S, uint8_t > ? PCM_FMT_U8
+                                   : std::is_same_v< S, int16_t > ? PCM_FMT_S16
+                                   : std::is_same_v< S, int32_t > ? PCM_FMT_S32
+                                   : std::is_same_v< S, float > ? PCM_FMT_F32
+                                   : _PCM_FMT_COUNT;
+
+            if( want != _pcm_fmt || ( ( uintptr_t )( this->_base() + _fmt.data_ofs ) % alignof( S ) ) != 0 )
+                return {};
+
+            return { ( const S* )( this->_base() + _fmt.data_ofs ), _fmt.data_size / sizeof( S ) };
+        }
+
+        template< typename T > requires std::is_floating_point_v< T >
+        T sample( uint64_t idx ) const {
+            return Pcm::decode_one< T >( this->_base() + _fmt.data_ofs + idx * PCM_FMT_BYTES[ _pcm_fmt ], _pcm_fmt );
+        }
+
+        template< typename T > requires std::is_floating_point_v< T >
+        T sample( uint64_t frame, WORD tunnel ) const {
+            return this->sample< T >( frame * _fmt.tunnel_count + tunnel );
+        }
+
+    };
+
+    /* 
+    Streams interleaved frames out to a RIFF WAV file, in any of the PCM formats. The sizes in the header are patched on close(). 
+    */
+    class WavWriter : public Descriptor {
+    public:
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::WavWriter" );
+
+    public:
+        inline static constexpr size_t   HEADER_SIZE   = 44;
+        inline static constexpr size_t   CHUNK_FRAMES  = 4096;
+
+    public:
+        WavWriter() = default;
+
+        WavWriter( 
+            std::string_view   path, 
+            DWORD              sample_rate, 
+            WORD               tunnel_count, 
+            PCM_FMT            fmt           = PCM_FMT_S16, 
+            _ENGINE_COMMS_ECHO_ARG 
+        )
+        : _file{ path.data(), std::ios_base::binary | std::ios_base::trunc },
+          _sample_rate{ sample_rate }, _tunnel_count{ tunnel_count }, _fmt{ fmt }
+        {
+            if( !_file ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.data() << "\".";
+                return;
+            }
+
+            if( tunnel_count == 0 || fmt >= _PCM_FMT_COUNT ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Bad format.";
+                _file.close();
+                return;
+            }
+
+            this->_write_header( 0 );
+
+            if( !_file ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT write header.";
                 return;
             }
 
+            echo( this, ECHO_LEVEL_OK ) << "Created for: \"" << path.data() << "\".";
+        }
 
-            if constexpr( std::is_floating_point_v< T > ) {
-                T max_sample = static_cast< T >( 1 << ( bits_per_sample - 1 ) );
+        WavWriter( const WavWriter& ) = delete;
+        WavWriter( WavWriter&& ) = delete;
 
-                for( size_t n = 0; n < sample_count; ++n )
-                    stream[ n ] = static_cast< T >(
-                                    Bytes::as< int, BIT_END_LITTLE >( &WAV_FMT_DATA_OFS[ raw_stream.get() ] + n * bytes_per_sample, bytes_per_sample )
-                                ) / max_sample;
-            } else {
-                for( size_t n = 0; n < sample_count; ++n )
-                    stream[ n ] = static_cast< T >(
-                                    Bytes::as< int, BIT_END_LITTLE >( &WAV_FMT_DATA_OFS[ raw_stream.get() ] + n * bytes_per_sample, bytes_per_sample ) );
+        ~WavWriter() {
+            this->close();
+        }
+
+    _ENGINE_PROTECTED:
+        std::ofstream        _file           = {};
+        DWORD                _sample_rate    = 0;
+        WORD                 _tunnel_count   = 0;
+        PCM_FMT              _fmt            = PCM_FMT_S16;
+        uint64_t             _frame_count    = 0;
+        UPtr< char[] >       _staging        = nullptr;
+        UPtr< double[] >     _staging_f64    = nullptr;
+
+    _ENGINE_PROTECTED:
+        void _put( uint32_t value, size_t byte_count ) {
+            char bytes[ 4 ];
+            for( size_t n = 0; n < byte_count; ++n )
+                bytes[ n ] = ( char )( ( value >> ( n * 8 ) ) & 0xFF );
+            _file.write( bytes, byte_count );
+        }
+
+        void _write_header( uint64_t data_size ) {
+            const uint32_t block_align = this->block_align();
+
+            _file.write( "RIFF", 4 ); this->_put( ( uint32_t )( HEADER_SIZE - 8 + data_size ), 4 );
+            _file.write( "WAVE", 4 );
+            _file.write( "fmt ", 4 ); this->_put( 16, 4 );
+            this->_put( _fmt == PCM_FMT_F32 ? WAV_TAG_IEEE_FLOAT : WAV_TAG_PCM, 2 );
+            this->_put( _tunnel_count, 2 );
+            this->_put( _sample_rate, 4 );
+            this->_put( _sample_rate * block_align, 4 );
+            this->_put( block_align, 2 );
+            this->_put( PCM_FMT_BYTES[ _fmt ] * 8, 2 );
+            _file.write( "data", 4 ); this->_put( ( uint32_t )data_size, 4 );
+        }
+
+        char* _staging_bytes() {
+            if( !_staging ) _staging.reset( new char[ CHUNK_FRAMES * this->block_align() ] );
+            return _staging.get();
+        }
+
+    public:
+        operator bool () const {
+            return _file.is_open() && _file.good();
+        }
+
+        PCM_FMT fmt() const { return _fmt; }
+
+        DWORD sample_rate() const { return _sample_rate; }
+
+        WORD tunnel_count() const { return _tunnel_count; }
+
+        uint32_t block_align() const { return PCM_FMT_BYTES[ _fmt ] * _tunnel_count; }
+
+        uint64_t frame_count() const { return _frame_count; }
+
+    public:
+        /* Frames already laid out in the file format. */
+        WavWriter& push_raw( const void* frames, size_t frame_count ) {
+            _file.write( ( const char* )frames, frame_count * this->block_align() );
+            _frame_count += frame_count;
+            return *this;
+        }
+
+        /* Normalized samples, clamped on the way out. */
+        template< typename T > requires std::is_floating_point_v< T >
+        WavWriter& push( const T* frames, size_t frame_count ) {
+            for( size_t at = 0; at < frame_count; ) {
+                size_t count = std::min( CHUNK_FRAMES, frame_count - at );
+                char*  dst   = this->_staging_bytes();
+
+                Pcm::encode( frames + at * _tunnel_count, dst, count * _tunnel_count, _fmt );
+                this->push_raw( dst, count );
+
+                at += count;
+            }
+            return *this;
+        }
+
+        /* Frames in some other PCM format, converted through double when the formats differ. */
+        WavWriter& push_pcm( const void* frames, size_t frame_count, PCM_FMT src_fmt ) {
+            if( src_fmt == _fmt ) return this->push_raw( frames, frame_count );
+
+            if( !_staging_f64 ) _staging_f64.reset( new double[ CHUNK_FRAMES * _tunnel_count ] );
+
+            const size_t src_align = PCM_FMT_BYTES[ src_fmt ] * _tunnel_count;
+
+            for( size_t at = 0; at < frame_count; ) {
+                size_t count = std::min( CHUNK_FRAMES, frame_count - at );
+
+                Pcm::decode( ( const char* )frames + at * src_align, _staging_f64.get(), count * _tunnel_count, src_fmt );
+                this->push( _staging_f64.get(), count );
+
+                at += count;
+            }
+            return *this;
+        }
+
+        void close() {
+            if( !_file.is_open() ) return;
+
+            uint64_t data_size = _frame_count * this->block_align();
+            if( data_size & 1 ) _file.put( 0 );
+
+            _file.seekp( 0 );
+            this->_write_header( data_size );
+            _file.close();
+        }
+
+    };
+
+    template< typename T >
+    class Wav : public Descriptor {
+    public:
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::Wav<T>" );
+    public:
+        Wav() = default;
+
+        Wav( std::string_view path, _ENGINE_COMMS_ECHO_ARG ) {
+            WavView view{ path, echo };
+
+            if( !view ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT map file: \"" << path.data() << "\".";
+                return;
             }
 
+            const WavFmt& fmt = view.advise( FILE_MAP_HINT_SEQUENTIAL ).fmt();
 
-            if( sample_count % tunnel_count != 0 )
-                echo( this, ECHO_LEVEL_WARNING ) << "Sample count does not distribute evenly on channel count.";
+            tunnel_count    = fmt.tunnel_count;
+            sample_rate     = fmt.sample_rate;
+            bits_per_sample = fmt.bits_per_sample;
+            sample_count    = fmt.frame_count();
 
-            
-            sample_count /= tunnel_count;
+
+            stream.vector( ( T* )malloc( sample_count * tunnel_count * sizeof( T ) ) );
+
+            if( !stream ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Bad alloc for stream buffer.";
+                return;
+            }
+
+            wav_decode< T >( ( const char* )view.bytes().data(), stream.get(), sample_count * tunnel_count, fmt );
 
 
             echo( this, ECHO_LEVEL_OK ) << "Created from: \"" << path.data() << "\".";
         }
 
-    
+    public:
+        bool write_file( std::string_view path, PCM_FMT fmt = PCM_FMT_S16, _ENGINE_COMMS_ECHO_ARG ) const requires std::is_floating_point_v< T > {
+            WavWriter writer{ path, sample_rate, tunnel_count, fmt, echo };
+
+            if( !writer ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT write file: \"" << path.data() << "\".";
+                return false;
+            }
+
+            writer.push( stream.get(), sample_count );
+            writer.close();
+
+            echo( this, ECHO_LEVEL_OK ) << "Written to: \"" << path.data() << "\".";
+            return true;
+        }
+
+    public:
         HVEC< T[] >   stream            = nullptr;
 
         DWORD         sample_rate       = 0;
@@ -118,6 +625,51 @@ public:
 
     };
 
+public:
+    enum PIXEL_ORDER : BYTE {
+        PIXEL_ORDER_RGBA = 0,
+        PIXEL_ORDER_BGRA = 1
+    };
+
+    /* What every image decoder hands back: 8 bit, 4 channels, top row first. */
+    struct Image {
+        std::vector< ubyte_t >   pixels   = {};
+        int32_t                  width    = 0;
+        int32_t                  height   = 0;
+        PIXEL_ORDER              order    = PIXEL_ORDER_RGBA;
+
+        explicit operator bool () const {
+            return !pixels.empty();
+        }
+
+        void reset( int32_t w, int32_t h, PIXEL_ORDER o = PIXEL_ORDER_RGBA ) {
+            width  = w;
+            height = h;
+            order  = o;
+            pixels.resize( ( size_t )w * h * 4 );
+        }
+
+        ImageView view() {
+            return ImageView{
+                .base     = pixels.data(),
+                .stride   = ( ptrdiff_t )width * 4,
+                .width    = width,
+                .height   = height,
+                .channels = 4
+            };
+        }
+
+        Image& reorder( PIXEL_ORDER to ) {
+            if( to == order ) return *this;
+
+            for( size_t n = 0; n < pixels.size(); n += 4 )
+                std::swap( pixels[ n ], pixels[ n + 2 ] );
+
+            order = to;
+            return *this;
+        }
+    };
+
 public:
     enum BMP_FMT {
         BMP_FMT_FILE_SIZE_OFS = 0x2,
@@ -132,7 +684,20 @@ public:
         BMP_FMT_HEIGHT_SZ = 4,
 
         BMP_FMT_BITS_PER_PIXEL_OFS = 0x1C,
-        BMP_FMT_BITS_PER_PIXEL_SZ = 2
+        BMP_FMT_BITS_PER_PIXEL_SZ = 2,
+
+        BMP_FMT_COMPRESSION_OFS = 0x1E,
+        BMP_FMT_COMPRESSION_SZ = 4,
+
+        BMP_FMT_INFO_HEADER_SZ = 40,
+        BMP_FMT_HEADER_SZ = 54,
+
+        /* BI_BITFIELDS only, right past the info header, or inside the larger ones at the same place. */
+        BMP_FMT_RED_MASK_OFS = 0x36,
+        BMP_FMT_GREEN_MASK_OFS = 0x3A,
+        BMP_FMT_BLUE_MASK_OFS = 0x3E,
+        BMP_FMT_MASK_SZ = 4,
+        BMP_FMT_MASKS_SZ = 12
     };
 
 
@@ -143,19 +708,19 @@ public:
     public:
         Bmp() = default;
 
-        Bmp( std::string_view path, _ENGINE_COMMS_ECHO_ARG ) {
-            std::ifstream file{ path.data(), std::ios_base::binary };
-
-            if( !file ) {
-                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.data() << "\".";
+        /* Copy-on-write mapped, pixels can be edited in place and only the touched pages leave the OS cache. */
+        Bmp( std::string_view path, _ENGINE_COMMS_ECHO_ARG )
+        : _map{ path, FILE_MAP_MODE_COPY_ON_WRITE, FILE_MAP_HINT_WILLNEED, echo }
+        {
+            if( !_map || _map.size() < BMP_FMT_HEADER_SZ ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT map file: \"" << path.data() << "\".";
+                _map = {};
                 return;
             }
-        
-            buf_size = File::byte_count( file );
 
-            buffer.vector( ( ubyte_t* )malloc( buf_size * sizeof( ubyte_t ) ) );
+            buf_size = _map.size();
 
-            file.read( ( char* )buffer.get(), buf_size );
+            buffer.vector( *_map.mutable_data() );
 
             udword_t in_file_reported_file_size = Bytes::as< udword_t, BMP_FMT_FILE_SIZE_SZ, BIT_END_LITTLE >( ( char* )&buffer[ BMP_FMT_FILE_SIZE_OFS ] );
 
@@ -170,6 +735,7 @@ public:
 
             char mod = ( width * bytes_ps ) % 4;
             padding = ( 4 - mod ) * ( mod != 0 );
+            stride  = width * bytes_ps + padding;
 
             echo( this, ECHO_LEVEL_OK ) 
             << "Created | W( " << width 
@@ -183,6 +749,9 @@ public:
             data_ofs = 0;
         }
 
+    _ENGINE_PROTECTED:
+        File::Map           _map       = {};
+
     public:
         HVEC< ubyte_t[] >   buffer     = nullptr;
         size_t              buf_size   = 0;
@@ -190,6 +759,7 @@ public:
         udword_t            data_ofs   = 0;
 
         int8_t              padding    = 0;
+        ptrdiff_t           stride     = 0;
         int32_t             width      = 0;
         int32_t             height     = 0;
 
@@ -198,11 +768,99 @@ public:
 
     public:
         ubyte_t* operator [] ( size_t row ) {
-            return buffer + ( ptrdiff_t )( data_ofs + row * ( width * bytes_ps + padding ) );
+            return buffer.get() + data_ofs + row * stride;
+        }
+
+        /* Rows in file order, bottom-up for positive heights. */
+        ImageView view() {
+            return ImageView{
+                .base     = buffer.get() + data_ofs,
+                .stride   = stride,
+                .width    = width,
+                .height   = std::abs( height ),
+                .channels = bytes_ps
+            };
+        }
+
+    public:
+        /* 24 and 32 bit bitmaps, straight from memory, into BGRA. Alpha is kept only for BI_BITFIELDS files. */
+        static bool decode( std::span< const ubyte_t > bytes, Image& img, _ENGINE_COMMS_ECHO_ARG ) {
+            static struct _Invoker : Descriptor {
+                _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::Bmp::decode" );
+            } invoker;
+
+            if( bytes.size() < BMP_FMT_HEADER_SZ || bytes[ 0 ] != 'B' || bytes[ 1 ] != 'M' ) {
+                echo( invoker, ECHO_LEVEL_ERROR ) << "Not a bitmap.";
+                return false;
+            }
+
+            char* header = ( char* )bytes.data();
+
+            udword_t data_ofs    = Bytes::as< udword_t, BMP_FMT_DATA_OFS_SZ, BIT_END_LITTLE >( header + BMP_FMT_DATA_OFS_OFS );
+            int32_t  w           = Bytes::as< int32_t, BMP_FMT_WIDTH_SZ, BIT_END_LITTLE >( header + BMP_FMT_WIDTH_OFS );
+            int32_t  h           = Bytes::as< int32_t, BMP_FMT_HEIGHT_SZ, BIT_END_LITTLE >( header + BMP_FMT_HEIGHT_OFS );
+            uint16_t bps         = Bytes::as< uint16_t, BMP_FMT_BITS_PER_PIXEL_SZ, BIT_END_LITTLE >( header + BMP_FMT_BITS_PER_PIXEL_OFS ) / 8;
+            udword_t compression = Bytes::as< udword_t, BMP_FMT_COMPRESSION_SZ, BIT_END_LITTLE >( header + BMP_FMT_COMPRESSION_OFS );
+
+            const bool top_down = h < 0;
+            h = std::abs( h );
+
+            if( w <= 0 || h == 0 || ( bps != 3 && bps != 4 ) || ( compression != 0 && compression != 3 ) ) {
+                echo( invoker, ECHO_LEVEL_ERROR ) << "Only uncompressed 24 and 32 bit bitmaps are decoded.";
+                return false;
+            }
+
+            const size_t stride = ( ( ( size_t )w * bps + 3 ) / 4 ) * 4;
+
+            if( data_ofs + stride * h > bytes.size() ) {
+                echo( invoker, ECHO_LEVEL_ERROR ) << "Truncated pixel data.";
+                return false;
+            }
+
+            img.reset( w, h, PIXEL_ORDER_BGRA );
+
+            for( int32_t y = 0; y < h; ++y ) {
+                const ubyte_t* src = bytes.data() + data_ofs + ( top_down ? y : h - 1 - y ) * stride;
+                ubyte_t*       dst = img.pixels.data() + ( size_t )y * w * 4;
+
+                if( bps == 4 && compression == 3 ) {
+                    std::memcpy( dst, src, ( size_t )w * 4 );
+                    continue;
+                }
+
+                for( int32_t x = 0; x < w; ++x, src += bps, dst += 4 ) {
+                    dst[ 0 ] = src[ 0 ]; dst[ 1 ] = src[ 1 ]; dst[ 2 ] = src[ 2 ];
+                    dst[ 3 ] = 0xFF;
+                }
+            }
+
+            return true;
+        }
+
+    _ENGINE_PROTECTED:
+        /* Moves the pixels off the map, into memory of their own, leaving the source file free to be overwritten. */
+        bool _detach( _ENGINE_COMMS_ECHO_ARG ) {
+            if( !_map ) return true;
+
+            auto owned = HVEC< ubyte_t[] >::allocv( buf_size );
+
+            if( !owned ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT detach pixels from the mapped file, bad alloc.";
+                return false;
+            }
+
+            std::memcpy( owned.get(), buffer.get(), buf_size );
+            buffer = std::move( owned );
+            _map   = {};
+
+            return true;
         }
 
     public:
+        /* Detaches from the mapped source first, which may well be the file written to. */
         dword_t write_file( std::string_view path, _ENGINE_COMMS_ECHO_ARG ) {
+            if( !this->_detach( echo ) ) return 0;
+
             std::ofstream file{ path.data(), std::ios_base::binary };
 
             if( !file ) {
@@ -212,7 +870,7 @@ public:
 
             file.write( ( char* )buffer.get(), buf_size );
 
-            if( file.badbit ) {
+            if( file.bad() ) {
                 echo( this, ECHO_LEVEL_WARNING ) << "Bad bit set during write to: \"" << path.data() << "\".";
             }
 
@@ -225,6 +883,1029 @@ public:
 
     };
 
+    /*
+    Bands of rows, top of the image first, whatever the file layout. Only one band is held in memory.
+    Bottom-up files are read backwards, one seek and one contiguous read per band, and handed out
+    through a negative stride.
+    */
+    class BmpReader : public Descriptor {
+    public:
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::BmpReader" );
+
+    public:
+        BmpReader() = default;
+
+        BmpReader( std::string_view path, int32_t band_rows = 256, _ENGINE_COMMS_ECHO_ARG )
+        : _file{ path.data(), std::ios_base::binary }
+        {
+            if( !_file ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.data() << "\".";
+                return;
+            }
+
+            char header[ BMP_FMT_HEADER_SZ ];
+            _file.read( header, BMP_FMT_HEADER_SZ );
+
+            if( !_file || header[ 0 ] != 'B' || header[ 1 ] != 'M' ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Bad header in: \"" << path.data() << "\".";
+                _file.close();
+                return;
+            }
+
+            _data_ofs = Bytes::as< udword_t, BMP_FMT_DATA_OFS_SZ, BIT_END_LITTLE >( &header[ BMP_FMT_DATA_OFS_OFS ] );
+            _width    = Bytes::as< int32_t, BMP_FMT_WIDTH_SZ, BIT_END_LITTLE >( &header[ BMP_FMT_WIDTH_OFS ] );
+            _height   = Bytes::as< int32_t, BMP_FMT_HEIGHT_SZ, BIT_END_LITTLE >( &header[ BMP_FMT_HEIGHT_OFS ] );
+            _bytes_ps = Bytes::as< uint16_t, BMP_FMT_BITS_PER_PIXEL_SZ, BIT_END_LITTLE >( &header[ BMP_FMT_BITS_PER_PIXEL_OFS ] ) / 8;
+
+            const udword_t compression = Bytes::as< udword_t, BMP_FMT_COMPRESSION_SZ, BIT_END_LITTLE >( &header[ BMP_FMT_COMPRESSION_OFS ] );
+
+            _top_down = _height < 0;
+            _height   = std::abs( _height );
+
+            /* 
+            BI_RGB, or BI_BITFIELDS on 32 bits laid out as plain BGRA, the bands are raw pixels either way. Anything
+            compressed or with other masks would be read as garbage.
+            */
+            bool raw = compression == 0;
+
+            if( compression == 3 && _bytes_ps == 4 ) {
+                char masks[ BMP_FMT_MASKS_SZ ];
+                _file.read( masks, BMP_FMT_MASKS_SZ );
+
+                raw = _file
+                      && Bytes::as< udword_t, BMP_FMT_MASK_SZ, BIT_END_LITTLE >( &masks[ BMP_FMT_RED_MASK_OFS - BMP_FMT_HEADER_SZ ] ) == 0x00FF0000
+                      && Bytes::as< udword_t, BMP_FMT_MASK_SZ, BIT_END_LITTLE >( &masks[ BMP_FMT_GREEN_MASK_OFS - BMP_FMT_HEADER_SZ ] ) == 0x0000FF00
+                      && Bytes::as< udword_t, BMP_FMT_MASK_SZ, BIT_END_LITTLE >( &masks[ BMP_FMT_BLUE_MASK_OFS - BMP_FMT_HEADER_SZ ] ) == 0x000000FF;
+            }
+
+            if( _width <= 0 || _height == 0 || ( _bytes_ps != 3 && _bytes_ps != 4 ) || !raw ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Only uncompressed 24 and 32 bit bitmaps, or 32 bit BGRA bitfields, are streamed, in: \"" << path.data() << "\".";
+                _file.close();
+                return;
+            }
+
+            _stride    = ( ( ( ptrdiff_t )_width * _bytes_ps + 3 ) / 4 ) * 4;
+            _band_rows = std::clamp( band_rows, 1, _height );
+            _band.reset( new ubyte_t[ _stride * _band_rows ] );
+
+            echo( this, ECHO_LEVEL_OK )
+            << "Created | W( " << _width
+            << " ) | H( " << _height
+            << " ) | BPS( " << _bytes_ps
+            << " ) | " << ( _top_down ? "top-down" : "bottom-up" )
+            << " | from: \"" << path.data() << "\".";
+        }
+
+    _ENGINE_PROTECTED:
+        std::ifstream        _file        = {};
+        UPtr< ubyte_t[] >    _band        = nullptr;
+
+        udword_t             _data_ofs    = 0;
+        ptrdiff_t            _stride      = 0;
+        int32_t              _width       = 0;
+        int32_t              _height      = 0;
+        uint16_t             _bytes_ps    = 0;
+        bool                 _top_down    = false;
+
+        int32_t              _band_rows   = 0;
+        int32_t              _next_row    = 0;
+
+    public:
+        operator bool () const {
+            return _file.is_open() && _band != nullptr;
+        }
+
+        int32_t width() const { return _width; }
+        int32_t height() const { return _height; }
+        uint16_t bytes_ps() const { return _bytes_ps; }
+        bool top_down() const { return _top_down; }
+        ptrdiff_t file_stride() const { return _stride; }
+        int32_t band_rows() const { return _band_rows; }
+
+        /* Image row at which the next band starts. */
+        int32_t next_row() const { return _next_row; }
+        int32_t rows_left() const { return _height - _next_row; }
+
+        void rewind() { _next_row = 0; }
+
+    public:
+        /* The next band, valid until the following call. Empty once every row was handed out, or on a read error. */
+        ImageView next( _ENGINE_COMMS_ECHO_ARG ) {
+            if( !*this || _next_row >= _height ) return {};
+
+            const int32_t rows     = std::min( _band_rows, _height - _next_row );
+            const int32_t file_row = _top_down ? _next_row : _height - _next_row - rows;
+
+            _file.seekg( _data_ofs + file_row * _stride );
+            _file.read( ( char* )_band.get(), rows * _stride );
+
+            if( !_file ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT read rows [ " << _next_row << ", " << _next_row + rows << " ).";
+                _file.close();
+                return {};
+            }
+
+            _next_row += rows;
+
+            return ImageView{
+                .base     = _top_down ? _band.get() : _band.get() + ( rows - 1 ) * _stride,
+                .stride   = _top_down ? _stride : -_stride,
+                .width    = _width,
+                .height   = rows,
+                .channels = _bytes_ps
+            };
+        }
+
+    };
+
+    /*
+    Takes bands top of the image first and places them where the chosen layout wants them. The file is sized
+    up front, so bottom-up output costs one seek per band, not a buffered image. Bands of 3 or 4 channels are
+    converted to the file's, a missing alpha is written opaque.
+    */
+    class BmpWriter : public Descriptor {
+    public:
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::BmpWriter" );
+
+    public:
+        BmpWriter() = default;
+
+        BmpWriter(
+            std::string_view   path,
+            int32_t            width,
+            int32_t            height,
+            uint16_t           bytes_ps   = 3,
+            bool               top_down   = false,
+            _ENGINE_COMMS_ECHO_ARG
+        )
+        : _file{ path.data(), std::ios_base::binary | std::ios_base::trunc },
+          _width{ width }, _height{ height }, _bytes_ps{ bytes_ps }, _top_down{ top_down }
+        {
+            if( !_file ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.data() << "\".";
+                return;
+            }
+
+            if( width <= 0 || height <= 0 || ( bytes_ps != 3 && bytes_ps != 4 ) ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Only 24 and 32 bit bitmaps are streamed.";
+                _file.close();
+                return;
+            }
+
+            _stride = ( ( ( ptrdiff_t )_width * _bytes_ps + 3 ) / 4 ) * 4;
+
+            this->_write_header();
+
+            /* Extend to the full size now, bands may land anywhere. */
+            _file.seekp( BMP_FMT_HEADER_SZ + _stride * _height - 1 );
+            _file.put( 0 );
+
+            if( !_file ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT size file: \"" << path.data() << "\".";
+                _file.close();
+                return;
+            }
+
+            echo( this, ECHO_LEVEL_OK ) << "Created for: \"" << path.data() << "\".";
+        }
+
+        BmpWriter( const BmpWriter& ) = delete;
+        BmpWriter( BmpWriter&& ) = delete;
+
+        ~BmpWriter() {
+            this->close();
+        }
+
+    _ENGINE_PROTECTED:
+        std::ofstream        _file        = {};
+        std::vector< char >  _staging     = {};
+
+        ptrdiff_t            _stride      = 0;
+        int32_t              _width       = 0;
+        int32_t              _height      = 0;
+        uint16_t             _bytes_ps    = 0;
+        bool                 _top_down    = false;
+
+        int32_t              _next_row    = 0;
+
+    _ENGINE_PROTECTED:
+        void _put( uint32_t value, size_t byte_count ) {
+            char bytes[ 4 ];
+            for( size_t n = 0; n < byte_count; ++n )
+                bytes[ n ] = ( char )( ( value >> ( n * 8 ) ) & 0xFF );
+            _file.write( bytes, byte_count );
+        }
+
+        void _write_header() {
+            const uint32_t data_size = ( uint32_t )( _stride * _height );
+
+            _file.write( "BM", 2 );
+            this->_put( BMP_FMT_HEADER_SZ + data_size, 4 );
+            this->_put( 0, 4 );
+            this->_put( BMP_FMT_HEADER_SZ, 4 );
+
+            this->_put( BMP_FMT_INFO_HEADER_SZ, 4 );
+            this->_put( ( uint32_t )_width, 4 );
+            this->_put( ( uint32_t )( _top_down ? -_height : _height ), 4 );
+            this->_put( 1, 2 );
+            this->_put( _bytes_ps * 8, 2 );
+            this->_put( 0, 4 );
+            this->_put( data_size, 4 );
+            this->_put( 2835, 4 );
+            this->_put( 2835, 4 );
+            this->_put( 0, 4 );
+            this->_put( 0, 4 );
+        }
+
+        void _pack_row( const ubyte_t* src, uint16_t src_channels, char* dst ) const {
+            if( src_channels == _bytes_ps ) {
+                std::memcpy( dst, src, ( size_t )_width * _bytes_ps );
+            } else {
+                for( int32_t x = 0; x < _width; ++x ) {
+                    const ubyte_t* s = src + x * src_channels;
+                    char*          d = dst + x * _bytes_ps;
+
+                    d[ 0 ] = s[ 0 ]; d[ 1 ] = s[ 1 ]; d[ 2 ] = s[ 2 ];
+                    if( _bytes_ps == 4 ) d[ 3 ] = ( char )0xFF;
+                }
+            }
+
+            std::memset( dst + ( size_t )_width * _bytes_ps, 0, _stride - ( size_t )_width * _bytes_ps );
+        }
+
+    public:
+        operator bool () const {
+            return _file.is_open() && _file.good();
+        }
+
+        int32_t width() const { return _width; }
+        int32_t height() const { return _height; }
+        uint16_t bytes_ps() const { return _bytes_ps; }
+        bool top_down() const { return _top_down; }
+
+        int32_t next_row() const { return _next_row; }
+        int32_t rows_left() const { return _height - _next_row; }
+
+    public:
+        BmpWriter& push( const ImageView& band, _ENGINE_COMMS_ECHO_ARG ) {
+            if( !*this ) return *this;
+
+            if( band.width != _width || ( band.channels != 3 && band.channels != 4 ) ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Band shape doesn't match the file.";
+                return *this;
+            }
+
+            const int32_t rows = std::min( band.height, _height - _next_row );
+            if( rows < band.height )
+                echo( this, ECHO_LEVEL_WARNING ) << "Band overruns the image, " << band.height - rows << " rows dropped.";
+
+            if( rows <= 0 ) return *this;
+
+            _staging.resize( rows * _stride );
+
+            /* Staged in file order, so the band goes out in one write. */
+            for( int32_t y = 0; y < rows; ++y )
+                this->_pack_row( band.row( y ), band.channels, _staging.data() + ( _top_down ? y : rows - 1 - y ) * _stride );
+
+            const int32_t file_row = _top_down ? _next_row : _height - _next_row - rows;
+
+            _file.seekp( BMP_FMT_HEADER_SZ + file_row * _stride );
+            _file.write( _staging.data(), rows * _stride );
+
+            if( !_file )
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT write rows [ " << _next_row << ", " << _next_row + rows << " ).";
+
+            _next_row += rows;
+            return *this;
+        }
+
+        void close( _ENGINE_COMMS_ECHO_ARG ) {
+            if( !_file.is_open() ) return;
+
+            if( _next_row < _height )
+                echo( this, ECHO_LEVEL_WARNING ) << "Closed with " << _height - _next_row << " rows never pushed.";
+
+            _file.close();
+        }
+
+    };
+
+public:
+    /* DEFLATE ( RFC 1951 ), raw or zlib wrapped ( RFC 1950 ). Decode only, table driven Huffman. */
+    class Inflate : public Descriptor {
+    public:
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::Inflate" );
+
+    public:
+        Inflate() = default;
+
+        Inflate( std::span< const ubyte_t > src )
+        : _src{ src }
+        {}
+
+    _ENGINE_PROTECTED:
+        struct _Huffman {
+            /* sym << 4 | length, indexed by the next bits bit-reversed. A zero length marks an unused code. */
+            std::vector< uint16_t >   table   = {};
+            uint32_t                  bits    = 0;
+        };
+
+    _ENGINE_PROTECTED:
+        std::span< const ubyte_t >   _src      = {};
+        size_t                       _at       = 0;
+        size_t                       _pad      = 0;
+        uint64_t                     _buf      = 0;
+        uint32_t                     _count    = 0;
+
+    _ENGINE_PROTECTED:
+        void _refill() {
+            while( _count <= 56 ) {
+                if( _at < _src.size() ) _buf |= ( uint64_t )_src[ _at++ ] << _count;
+                else                    ++_pad;
+                _count += 8;
+            }
+        }
+
+        uint32_t _bits( uint32_t n ) {
+            if( n == 0 ) return 0;
+            if( _count < n ) this->_refill();
+
+            uint32_t v = ( uint32_t )( _buf & ( ( 1ull << n ) - 1 ) );
+            _buf   >>= n;
+            _count  -= n;
+            return v;
+        }
+
+        bool _overrun() const {
+            /* Zeros fed past the end are fine as long as no whole byte of them was consumed. */
+            return _pad * 8 > _count + 7;
+        }
+
+        static bool _build( const ubyte_t* lengths, uint32_t n, _Huffman& huff ) {
+            uint32_t count[ 16 ] = {};
+            uint32_t max_len     = 0;
+
+            for( uint32_t s = 0; s < n; ++s ) {
+                ++count[ lengths[ s ] ];
+                max_len = std::max< uint32_t >( max_len, lengths[ s ] );
+            }
+
+            huff.bits = std::max< uint32_t >( max_len, 1 );
+            huff.table.assign( 1u << huff.bits, 0 );
+
+            count[ 0 ] = 0;
+            uint32_t next[ 16 ] = {};
+            for( uint32_t len = 1, code = 0; len < 16; ++len ) {
+                code = ( code + count[ len - 1 ] ) << 1;
+                next[ len ] = code;
+            }
+
+            for( uint32_t s = 0; s < n; ++s ) {
+                const uint32_t len = lengths[ s ];
+                if( len == 0 ) continue;
+
+                uint32_t code = next[ len ]++, rev = 0;
+                if( code >= ( 1u << len ) ) return false;
+
+                for( uint32_t b = 0; b < len; ++b )
+                    rev |= ( ( code >> b ) & 1 ) << ( len - 1 - b );
+
+                for( uint32_t idx = rev; idx < huff.table.size(); idx += 1u << len )
+                    huff.table[ idx ] = ( uint16_t )( s << 4 | len );
+            }
+
+            return true;
+        }
+
+        int32_t _decode( const _Huffman& huff ) {
+            if( _count < huff.bits ) this->_refill();
+
+            const uint16_t entry = huff.table[ _buf & ( ( 1ull << huff.bits ) - 1 ) ];
+            const uint32_t len   = entry & 0xF;
+
+            if( len == 0 ) return -1;
+
+            _buf   >>= len;
+            _count  -= len;
+            return entry >> 4;
+        }
+
+        bool _stored( std::vector< ubyte_t >& out ) {
+            /* Drop to the byte boundary, then hand the buffered whole bytes back to the source. */
+            this->_bits( _count % 8 );
+            const size_t buffered = _count / 8 - std::min< size_t >( _pad, _count / 8 );
+            _at -= buffered; _buf = 0; _count = 0; _pad = 0;
+
+            if( _at + 4 > _src.size() ) return false;
+
+            const uint32_t len  = _src[ _at ] | _src[ _at + 1 ] << 8;
+            const uint32_t nlen = _src[ _at + 2 ] | _src[ _at + 3 ] << 8;
+            _at += 4;
+
+            if( ( len ^ 0xFFFF ) != nlen || _at + len > _src.size() ) return false;
+
+            out.insert( out.end(), _src.begin() + _at, _src.begin() + _at + len );
+            _at += len;
+            return true;
+        }
+
+        bool _codes( std::vector< ubyte_t >& out, const _Huffman& lit, const _Huffman& dist ) {
+            static constexpr uint16_t LEN_BASE[]   = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+            static constexpr uint8_t  LEN_EXTRA[]  = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+            static constexpr uint16_t DIST_BASE[]  = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+            static constexpr uint8_t  DIST_EXTRA[] = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+            for(;;) {
+                int32_t sym = this->_decode( lit );
+
+                if( sym < 0 || this->_overrun() ) return false;
+
+                if( sym < 256 ) {
+                    out.push_back( ( ubyte_t )sym );
+                    continue;
+                }
+
+                if( sym == 256 ) return true;
+
+                sym -= 257;
+                if( sym >= 29 ) return false;
+
+                const uint32_t len = LEN_BASE[ sym ] + this->_bits( LEN_EXTRA[ sym ] );
+                const int32_t  ds  = this->_decode( dist );
+
+                if( ds < 0 || ds >= 30 ) return false;
+
+                const size_t d = DIST_BASE[ ds ] + this->_bits( DIST_EXTRA[ ds ] );
+                if( d > out.size() ) return false;
+
+                size_t from = out.size() - d;
+                out.resize( out.size() + len );
+                ubyte_t* base = out.data();
+
+                for( size_t n = 0, to = out.size() - len; n < len; ++n )
+                    base[ to + n ] = base[ from + n ];
+            }
+        }
+
+        bool _dynamic( std::vector< ubyte_t >& out ) {
+            static constexpr uint8_t ORDER[ 19 ] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
+
+            const uint32_t hlit  = this->_bits( 5 ) + 257;
+            const uint32_t hdist = this->_bits( 5 ) + 1;
+            const uint32_t hclen = this->_bits( 4 ) + 4;
+
+            ubyte_t  cl_lengths[ 19 ] = {};
+            for( uint32_t n = 0; n < hclen; ++n )
+                cl_lengths[ ORDER[ n ] ] = ( ubyte_t )this->_bits( 3 );
+
+            _Huffman cl;
+            if( !_build( cl_lengths, 19, cl ) ) return false;
+
+            ubyte_t lengths[ 320 ] = {};
+            for( uint32_t n = 0; n < hlit + hdist; ) {
+                int32_t sym = this->_decode( cl );
+                if( sym < 0 || this->_overrun() ) return false;
+
+                if( sym < 16 ) { lengths[ n++ ] = ( ubyte_t )sym; continue; }
+
+                ubyte_t  fill   = 0;
+                uint32_t repeat = 0;
+
+                switch( sym ) {
+                    case 16: if( n == 0 ) return false; fill = lengths[ n - 1 ]; repeat = 3 + this->_bits( 2 ); break;
+                    case 17: repeat = 3 + this->_bits( 3 ); break;
+                    default: repeat = 11 + this->_bits( 7 ); break;
+                }
+
+                if( n + repeat > hlit + hdist ) return false;
+                while( repeat-- ) lengths[ n++ ] = fill;
+            }
+
+            _Huffman lit, dist;
+            if( !_build( lengths, hlit, lit ) || !_build( lengths + hlit, hdist, dist ) ) return false;
+
+            return this->_codes( out, lit, dist );
+        }
+
+    public:
+        /* Appends to out. Returns false on malformed or truncated input. */
+        bool raw( std::vector< ubyte_t >& out ) {
+            static const auto [ fixed_lit, fixed_dist ] = [] () -> std::pair< _Huffman, _Huffman > {
+                ubyte_t lengths[ 288 + 30 ];
+                std::fill( lengths,       lengths + 144, 8 );
+                std::fill( lengths + 144, lengths + 256, 9 );
+                std::fill( lengths + 256, lengths + 280, 7 );
+                std::fill( lengths + 280, lengths + 288, 8 );
+                std::fill( lengths + 288, lengths + 318, 5 );
+
+                std::pair< _Huffman, _Huffman > tables;
+                _build( lengths, 288, tables.first );
+                _build( lengths + 288, 30, tables.second );
+                return tables;
+            }();
+
+            for( bool last = false; !last; ) {
+                last = this->_bits( 1 );
+
+                bool ok = false;
+                switch( this->_bits( 2 ) ) {
+                    case 0: ok = this->_stored( out ); break;
+                    case 1: ok = this->_codes( out, fixed_lit, fixed_dist ); break;
+                    case 2: ok = this->_dynamic( out ); break;
+                    default: break;
+                }
+
+                if( !ok || this->_overrun() ) return false;
+            }
+
+            return true;
+        }
+
+        bool zlib( std::vector< ubyte_t >& out ) {
+            if( _src.size() < 6 ) return false;
+
+            const uint32_t cmf = _src[ 0 ], flg = _src[ 1 ];
+            if( ( cmf & 0xF ) != 8 || ( cmf << 8 | flg ) % 31 != 0 || ( flg & 0x20 ) ) return false;
+
+            _at = 2;
+            return this->raw( out );
+        }
+
+    };
+
+    /* Non-interlaced and Adam7 PNG, every color type and bit depth, tRNS included. Into RGBA. */
+    class Png : public Descriptor {
+    public:
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::Png" );
+
+    public:
+        inline static constexpr ubyte_t   SIGNATURE[ 8 ]   = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    _ENGINE_PROTECTED:
+        static uint32_t _be32( const ubyte_t* p ) {
+            return ( uint32_t )p[ 0 ] << 24 | ( uint32_t )p[ 1 ] << 16 | ( uint32_t )p[ 2 ] << 8 | p[ 3 ];
+        }
+
+        static int _paeth( int a, int b, int c ) {
+            const int p = a + b - c, pa = std::abs( p - a ), pb = std::abs( p - b ), pc = std::abs( p - c );
+            return ( pa <= pb && pa <= pc ) ? a : ( pb <= pc ? b : c );
+        }
+
+        /* In place, prev is the unfiltered row above or nullptr. */
+        static bool _unfilter( ubyte_t filter, ubyte_t* row, const ubyte_t* prev, size_t size, size_t bpp ) {
+            switch( filter ) {
+                case 0: break;
+                case 1: for( size_t n = bpp; n < size; ++n ) row[ n ] += row[ n - bpp ]; break;
+                case 2: if( prev ) for( size_t n = 0; n < size; ++n ) row[ n ] += prev[ n ]; break;
+                case 3:
+                    for( size_t n = 0; n < size; ++n )
+                        row[ n ] += ( ( n >= bpp ? row[ n - bpp ] : 0 ) + ( prev ? prev[ n ] : 0 ) ) >> 1;
+                break;
+                case 4:
+                    for( size_t n = 0; n < size; ++n )
+                        row[ n ] += ( ubyte_t )_paeth( n >= bpp ? row[ n - bpp ] : 0, prev ? prev[ n ] : 0, ( prev && n >= bpp ) ? prev[ n - bpp ] : 0 );
+                break;
+                default: return false;
+            }
+            return true;
+        }
+
+    public:
+        static bool sniff( std::span< const ubyte_t > bytes ) {
+            return bytes.size() >= 8 && std::memcmp( bytes.data(), SIGNATURE, 8 ) == 0;
+        }
+
+        static bool decode( std::span< const ubyte_t > bytes, Image& img, _ENGINE_COMMS_ECHO_ARG ) {
+            static struct _Invoker : Descriptor {
+                _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::Png::decode" );
+            } invoker;
+
+            if( !sniff( bytes ) ) {
+                echo( invoker, ECHO_LEVEL_ERROR ) << "Not a PNG.";
+                return false;
+            }
+
+            uint32_t w = 0, h = 0;
+            ubyte_t  depth = 0, color = 0, interlace = 0;
+
+            ubyte_t  palette[ 256 ][ 4 ] = {};
+            bool     has_key = false;
+            uint16_t key[ 3 ] = {};
+
+            std::vector< ubyte_t > idat;
+
+            for( size_t at = 8; at + 12 <= bytes.size(); ) {
+                const uint32_t       len  = _be32( bytes.data() + at );
+                const ubyte_t*       type = bytes.data() + at + 4;
+                const ubyte_t*       data = type + 4;
+
+                if( at + 12 + len > bytes.size() ) {
+                    echo( invoker, ECHO_LEVEL_ERROR ) << "Truncated chunk.";
+                    return false;
+                }
+
+                if( std::memcmp( type, "IHDR", 4 ) == 0 && len >= 13 ) {
+                    w = _be32( data ); h = _be32( data + 4 );
+                    depth = data[ 8 ]; color = data[ 9 ]; interlace = data[ 12 ];
+                } else if( std::memcmp( type, "PLTE", 4 ) == 0 ) {
+                    for( uint32_t n = 0; n < len / 3 && n < 256; ++n )
+                        palette[ n ][ 0 ] = data[ n * 3 ], palette[ n ][ 1 ] = data[ n * 3 + 1 ], palette[ n ][ 2 ] = data[ n * 3 + 2 ], palette[ n ][ 3 ] = 0xFF;
+                } else if( std::memcmp( type, "tRNS", 4 ) == 0 ) {
+                    if( color == 3 ) {
+                        for( uint32_t n = 0; n < len && n < 256; ++n ) palette[ n ][ 3 ] = data[ n ];
+                    } else if( len >= 2 ) {
+                        has_key = true;
+                        for( uint32_t n = 0; n < 3 && n * 2 + 1 < len; ++n ) key[ n ] = data[ n * 2 ] << 8 | data[ n * 2 + 1 ];
+                    }
+                } else if( std::memcmp( type, "IDAT", 4 ) == 0 ) {
+                    idat.insert( idat.end(), data, data + len );
+                } else if( std::memcmp( type, "IEND", 4 ) == 0 ) {
+                    break;
+                }
+
+                at += 12 + len;
+            }
+
+            static constexpr ubyte_t CHANNELS[ 7 ] = { 1, 0, 3, 1, 2, 0, 4 };
+
+            if( w == 0 || h == 0 || w > 0x7FFFFFFF || h > 0x7FFFFFFF || color > 6 || CHANNELS[ color ] == 0 || interlace > 1
+                || ( depth != 1 && depth != 2 && depth != 4 && depth != 8 && depth != 16 )
+            ) {
+                echo( invoker, ECHO_LEVEL_ERROR ) << "Unsupported or ill-formed header.";
+                return false;
+            }
+
+            const uint32_t channels = CHANNELS[ color ];
+            const uint32_t bits     = channels * depth;
+            const size_t   bpp      = std::max< size_t >( 1, bits / 8 );
+
+            std::vector< ubyte_t > raw;
+            raw.reserve( ( size_t )h * ( ( ( size_t )w * bits + 7 ) / 8 + 1 ) + ( interlace ? h * 8 : 0 ) );
+
+            if( !Inflate{ idat }.zlib( raw ) ) {
+                echo( invoker, ECHO_LEVEL_ERROR ) << "Corrupt image data.";
+                return false;
+            }
+
+            img.reset( ( int32_t )w, ( int32_t )h, PIXEL_ORDER_RGBA );
+
+            struct Pass { uint32_t x0, y0, dx, dy; };
+            static constexpr Pass ADAM7[ 7 ] = { { 0,0,8,8 }, { 4,0,8,8 }, { 0,4,4,8 }, { 2,0,4,4 }, { 0,2,2,4 }, { 1,0,2,2 }, { 0,1,1,2 } };
+            static constexpr Pass WHOLE[ 1 ] = { { 0,0,1,1 } };
+
+            const Pass*   passes     = interlace ? ADAM7 : WHOLE;
+            const int     pass_count = interlace ? 7 : 1;
+            const int     max_val    = ( 1 << std::min< int >( depth, 8 ) ) - 1;
+            size_t        at         = 0;
+
+            auto sample = [ & ] ( const ubyte_t* row, uint32_t idx ) -> uint32_t {
+                switch( depth ) {
+                    case 16: return row[ idx * 2 ] << 8 | row[ idx * 2 + 1 ];
+                    case 8:  return row[ idx ];
+                    default: {
+                        const uint32_t bit = idx * depth;
+                        return ( row[ bit / 8 ] >> ( 8 - depth - bit % 8 ) ) & max_val;
+                    }
+                }
+            };
+
+            auto to8 = [ & ] ( uint32_t v ) -> ubyte_t {
+                return depth == 16 ? ( ubyte_t )( v >> 8 ) : ( ubyte_t )( v * 255 / max_val );
+            };
+
+            for( int p = 0; p < pass_count; ++p ) {
+                const Pass&    pass = passes[ p ];
+                const uint32_t pw   = ( w > pass.x0 ) ? ( w - pass.x0 + pass.dx - 1 ) / pass.dx : 0;
+                const uint32_t ph   = ( h > pass.y0 ) ? ( h - pass.y0 + pass.dy - 1 ) / pass.dy : 0;
+
+                if( pw == 0 || ph == 0 ) continue;
+
+                const size_t row_size = ( ( size_t )pw * bits + 7 ) / 8;
+
+                if( at + ph * ( row_size + 1 ) > raw.size() ) {
+                    echo( invoker, ECHO_LEVEL_ERROR ) << "Image data too short.";
+                    return false;
+                }
+
+                const ubyte_t* prev = nullptr;
+
+                for( uint32_t py = 0; py < ph; ++py ) {
+                    ubyte_t* row = raw.data() + at + 1;
+
+                    if( !_unfilter( raw[ at ], row, prev, row_size, bpp ) ) {
+                        echo( invoker, ECHO_LEVEL_ERROR ) << "Bad row filter.";
+                        return false;
+                    }
+
+                    prev = row;
+                    at  += row_size + 1;
+
+                    ubyte_t* dst = img.pixels.data() + ( ( size_t )( pass.y0 + py * pass.dy ) * w + pass.x0 ) * 4;
+                    const size_t dst_step = ( size_t )pass.dx * 4;
+
+                    /* The common cases first, straight byte moves. */
+                    if( depth == 8 && color == 6 && pass.dx == 1 ) {
+                        std::memcpy( dst, row, ( size_t )pw * 4 );
+                        continue;
+                    }
+
+                    if( depth == 8 && color == 2 && !has_key ) {
+                        for( uint32_t px = 0; px < pw; ++px, dst += dst_step )
+                            dst[ 0 ] = row[ px * 3 ], dst[ 1 ] = row[ px * 3 + 1 ], dst[ 2 ] = row[ px * 3 + 2 ], dst[ 3 ] = 0xFF;
+                        continue;
+                    }
+
+                    for( uint32_t px = 0; px < pw; ++px, dst += dst_step ) {
+                        switch( color ) {
+                            case 0: {
+                                const uint32_t g = sample( row, px );
+                                dst[ 0 ] = dst[ 1 ] = dst[ 2 ] = to8( g );
+                                dst[ 3 ] = ( has_key && g == key[ 0 ] ) ? 0 : 0xFF;
+                            break; }
+
+                            case 2: {
+                                const uint32_t r = sample( row, px * 3 ), g = sample( row, px * 3 + 1 ), b = sample( row, px * 3 + 2 );
+                                dst[ 0 ] = to8( r ); dst[ 1 ] = to8( g ); dst[ 2 ] = to8( b );
+                                dst[ 3 ] = ( has_key && r == key[ 0 ] && g == key[ 1 ] && b == key[ 2 ] ) ? 0 : 0xFF;
+                            break; }
+
+                            case 3: {
+                                std::memcpy( dst, palette[ sample( row, px ) & 0xFF ], 4 );
+                            break; }
+
+                            case 4: {
+                                dst[ 0 ] = dst[ 1 ] = dst[ 2 ] = to8( sample( row, px * 2 ) );
+                                dst[ 3 ] = to8( sample( row, px * 2 + 1 ) );
+                            break; }
+
+                            default: {
+                                for( uint32_t c = 0; c < 4; ++c ) dst[ c ] = to8( sample( row, px * 4 + c ) );
+                            break; }
+                        }
+                    }
+                }
+            }
+
+            return true;
+        }
+
+    };
+
+    /* Truecolor, grayscale and color-mapped TGA, plain or RLE, either origin. Into BGRA. */
+    class Tga : public Descriptor {
+    public:
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::Tga" );
+
+    public:
+        inline static constexpr size_t   HEADER_SIZE   = 18;
+
+    _ENGINE_PROTECTED:
+        static uint16_t _le16( const ubyte_t* p ) {
+            return p[ 0 ] | p[ 1 ] << 8;
+        }
+
+        static void _expand( const ubyte_t* src, uint32_t bytes_pp, bool gray, ubyte_t* dst ) {
+            switch( bytes_pp ) {
+                case 1:
+                    dst[ 0 ] = dst[ 1 ] = dst[ 2 ] = src[ 0 ]; dst[ 3 ] = 0xFF;
+                break;
+                case 2: {
+                    if( gray ) { dst[ 0 ] = dst[ 1 ] = dst[ 2 ] = src[ 0 ]; dst[ 3 ] = src[ 1 ]; break; }
+                    const uint16_t v = _le16( src );
+                    dst[ 0 ] = ( ubyte_t )( ( v & 0x1F ) * 255 / 31 );
+                    dst[ 1 ] = ( ubyte_t )( ( ( v >> 5 ) & 0x1F ) * 255 / 31 );
+                    dst[ 2 ] = ( ubyte_t )( ( ( v >> 10 ) & 0x1F ) * 255 / 31 );
+                    dst[ 3 ] = 0xFF;
+                break; }
+                case 3:
+                    dst[ 0 ] = src[ 0 ]; dst[ 1 ] = src[ 1 ]; dst[ 2 ] = src[ 2 ]; dst[ 3 ] = 0xFF;
+                break;
+                default:
+                    std::memcpy( dst, src, 4 );
+                break;
+            }
+        }
+
+    public:
+        /* TGA has no magic, the header fields are checked for sanity instead. */
+        static bool sniff( std::span< const ubyte_t > bytes ) {
+            if( bytes.size() < HEADER_SIZE ) return false;
+
+            const ubyte_t cmap = bytes[ 1 ], type = bytes[ 2 ], depth = bytes[ 16 ];
+
+            return cmap <= 1
+                   && ( type == 1 || type == 2 || type == 3 || type == 9 || type == 10 || type == 11 )
+                   && ( depth == 8 || depth == 15 || depth == 16 || depth == 24 || depth == 32 )
+                   && _le16( bytes.data() + 12 ) > 0 && _le16( bytes.data() + 14 ) > 0;
+        }
+
+        static bool decode( std::span< const ubyte_t > bytes, Image& img, _ENGINE_COMMS_ECHO_ARG ) {
+            static struct _Invoker : Descriptor {
+                _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::Tga::decode" );
+            } invoker;
+
+            if( !sniff( bytes ) ) {
+                echo( invoker, ECHO_LEVEL_ERROR ) << "Not a TGA.";
+                return false;
+            }
+
+            const ubyte_t* head       = bytes.data();
+            const ubyte_t  type       = head[ 2 ];
+            const uint16_t cmap_first = _le16( head + 3 ), cmap_len = _le16( head + 5 );
+            const uint32_t cmap_bpp   = ( head[ 7 ] + 7 ) / 8;
+            const int32_t  w          = _le16( head + 12 ), h = _le16( head + 14 );
+            const uint32_t bytes_pp   = ( head[ 16 ] + 7 ) / 8;
+            const bool     top_down   = head[ 17 ] & 0x20;
+            const bool     right_left = head[ 17 ] & 0x10;
+            const bool     mapped     = ( type & 3 ) == 1;
+            const bool     gray       = ( type & 3 ) == 3;
+            const bool     rle        = type & 8;
+
+            size_t at = HEADER_SIZE + head[ 0 ];
+
+            std::vector< ubyte_t > cmap;
+            if( head[ 1 ] ) {
+                const size_t size = ( size_t )cmap_len * cmap_bpp;
+                if( at + size > bytes.size() ) { echo( invoker, ECHO_LEVEL_ERROR ) << "Truncated color map."; return false; }
+
+                cmap.resize( ( size_t )cmap_len * 4 );
+                for( uint32_t n = 0; n < cmap_len; ++n )
+                    _expand( bytes.data() + at + n * cmap_bpp, cmap_bpp, false, cmap.data() + n * 4 );
+                at += size;
+            }
+
+            if( mapped && ( cmap.empty() || bytes_pp > 2 ) ) {
+                echo( invoker, ECHO_LEVEL_ERROR ) << "Color-mapped image without a usable map.";
+                return false;
+            }
+
+            img.reset( w, h, PIXEL_ORDER_BGRA );
+
+            auto put = [ & ] ( const ubyte_t* src, ubyte_t* dst ) -> void {
+                if( mapped ) {
+                    const uint32_t idx = ( bytes_pp == 1 ? src[ 0 ] : _le16( src ) ) - cmap_first;
+                    if( idx < cmap_len ) std::memcpy( dst, cmap.data() + idx * 4, 4 );
+                    else                 std::memset( dst, 0, 4 );
+                } else {
+                    _expand( src, bytes_pp, gray, dst );
+                }
+            };
+
+            const size_t total = ( size_t )w * h;
+            ubyte_t*     out   = img.pixels.data();
+
+            size_t n = 0;
+
+            /* Decoded in file order, rows and columns fixed up below. */
+            while( n < total ) {
+                if( !rle ) {
+                    if( at + bytes_pp > bytes.size() ) break;
+                    put( bytes.data() + at, out + n * 4 );
+                    at += bytes_pp; ++n;
+                    continue;
+                }
+
+                if( at >= bytes.size() ) break;
+                const ubyte_t packet = bytes[ at++ ];
+                const size_t  count  = std::min< size_t >( ( packet & 0x7F ) + 1, total - n );
+
+                if( packet & 0x80 ) {
+                    if( at + bytes_pp > bytes.size() ) break;
+                    put( bytes.data() + at, out + n * 4 );
+                    for( size_t k = 1; k < count; ++k ) std::memcpy( out + ( n + k ) * 4, out + n * 4, 4 );
+                    at += bytes_pp;
+                } else {
+                    if( at + count * bytes_pp > bytes.size() ) break;
+                    for( size_t k = 0; k < count; ++k, at += bytes_pp ) put( bytes.data() + at, out + ( n + k ) * 4 );
+                }
+
+                n += count;
+            }
+
+            if( n < total ) {
+                echo( invoker, ECHO_LEVEL_ERROR ) << "Truncated pixel data, " << n << " of " << total << " pixels.";
+                img = {};
+                return false;
+            }
+
+            if( !top_down )
+                for( int32_t y = 0; y < h / 2; ++y )
+                    std::swap_ranges( out + ( size_t )y * w * 4, out + ( size_t )( y + 1 ) * w * 4, out + ( size_t )( h - 1 - y ) * w * 4 );
+
+            if( right_left )
+                for( int32_t y = 0; y < h; ++y )
+                    for( int32_t x = 0; x < w / 2; ++x )
+                        std::swap_ranges( out + ( ( size_t )y * w + x ) * 4, out + ( ( size_t )y * w + x + 1 ) * 4, out + ( ( size_t )y * w + w - 1 - x ) * 4 );
+
+            return true;
+        }
+
+    };
+
+    /*
+    Picks a decoder by content, not by extension. BMP, PNG and TGA are there from the start, add() lets other
+    components plug theirs in, tried before the built-ins so they may override them. decode_async() runs on the
+    thread pool, so a batch of textures decodes in parallel on any platform.
+    */
+    class ImageDecoders {
+    public:
+        struct Entry {
+            std::string_view   name     = {};
+            bool            ( *sniff )( std::span< const ubyte_t > )                    = nullptr;
+            bool            ( *decode )( std::span< const ubyte_t >, Image&, Echo )     = nullptr;
+        };
+
+    _ENGINE_PROTECTED:
+        struct _Invoker : Descriptor {
+            _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Endec::ImageDecoders" );
+        };
+
+        inline static _Invoker   _invoker   = {};
+
+        static std::vector< Entry >& _entries() {
+            static std::vector< Entry > entries{
+                Entry{ name: "PNG", sniff: &Png::sniff, decode: &Png::decode },
+                Entry{ name: "BMP", sniff: [] ( std::span< const ubyte_t > b ) -> bool { return b.size() >= 2 && b[ 0 ] == 'B' && b[ 1 ] == 'M'; }, decode: &Bmp::decode },
+                Entry{ name: "TGA", sniff: &Tga::sniff, decode: &Tga::decode }
+            };
+            return entries;
+        }
+
+        static std::mutex& _mtx() {
+            static std::mutex mtx;
+            return mtx;
+        }
+
+    public:
+        static void add( const Entry& entry ) {
+            std::unique_lock< std::mutex > lock{ _mtx() };
+            _entries().insert( _entries().begin(), entry );
+        }
+
+        /* A copy, add() may move the entries around while the caller decodes. */
+        static std::optional< Entry > find( std::span< const ubyte_t > bytes ) {
+            std::unique_lock< std::mutex > lock{ _mtx() };
+
+            for( auto& entry : _entries() )
+                if( entry.sniff( bytes ) ) return entry;
+
+            return std::nullopt;
+        }
+
+    public:
+        static Image decode( std::span< const ubyte_t > bytes, PIXEL_ORDER order = PIXEL_ORDER_RGBA, _ENGINE_COMMS_ECHO_ARG ) {
+            Image img;
+
+            const std::optional< Entry > entry = find( bytes );
+
+            if( !entry ) {
+                echo( _invoker, ECHO_LEVEL_ERROR ) << "No decoder recognizes the data.";
+                return img;
+            }
+
+            if( !entry->decode( bytes, img, echo ) ) {
+                img = {};
+                return img;
+            }
+
+            img.reorder( order );
+            return img;
+        }
+
+        static Image decode( const std::filesystem::path& path, PIXEL_ORDER order = PIXEL_ORDER_RGBA, _ENGINE_COMMS_ECHO_ARG ) {
+            File::Map map{ path, FILE_MAP_MODE_READ, FILE_MAP_HINT_SEQUENTIAL, echo };
+
+            if( !map ) {
+                echo( _invoker, ECHO_LEVEL_ERROR ) << "Could NOT map file: \"" << path.string() << "\".";
+                return {};
+            }
+
+            Image img = decode( map.bytes(), order, echo );
+
+            if( !img )
+                echo( _invoker, ECHO_LEVEL_ERROR ) << "Could NOT decode: \"" << path.string() << "\".";
+
+            return img;
+        }
+
+        static std::future< Image > decode_async( std::filesystem::path path, PIXEL_ORDER order = PIXEL_ORDER_RGBA, ThreadPool& pool = ThreadPool::shared() ) {
+            return pool.submit( [ path = std::move( path ), order ] () -> Image {
+                return decode( path, order );
+            } );
+        }
+
+        static std::vector< std::future< Image > > decode_async( std::span< const std::filesystem::path > paths, PIXEL_ORDER order = PIXEL_ORDER_RGBA, ThreadPool& pool = ThreadPool::shared() ) {
+            std::vector< std::future< Image > > futures;
+            futures.reserve( paths.size() );
+
+            for( auto& path : paths )
+                futures.emplace_back( decode_async( path, order, pool ) );
+
+            return futures;
+        }
+
+    };
+
 };
 
 
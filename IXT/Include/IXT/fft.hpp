@@ -0,0 +1,118 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+
+#include <complex>
+#include <numbers>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+/*
+Radix-2, in place, for one power of two size. The twiddles and the bit reversal are computed once,
+so a plan is meant to be kept around and reused. Inverse transforms are scaled by 1 / n.
+*/
+template< typename T = float >
+class FftPlan {
+public:
+    using Cplx = std::complex< T >;
+
+public:
+    FftPlan() = default;
+
+    FftPlan( size_t n ) {
+        this->reset( n );
+    }
+
+_ENGINE_PROTECTED:
+    size_t                   _n          = 0;
+    std::vector< Cplx >      _twiddles   = {};
+    std::vector< uint32_t >  _reversed   = {};
+
+public:
+    static size_t next_pow2( size_t n ) {
+        size_t p = 1;
+        while( p < n ) p <<= 1;
+        return p;
+    }
+
+    FftPlan& reset( size_t n ) {
+        _n = next_pow2( std::max< size_t >( n, 1 ) );
+
+        _twiddles.resize( _n / 2 );
+        for( size_t k = 0; k < _n / 2; ++k )
+            _twiddles[ k ] = std::polar< T >( 1, -2.0 * std::numbers::pi * k / _n );
+
+        size_t bits = 0;
+        while( ( size_t{ 1 } << bits ) < _n ) ++bits;
+
+        _reversed.resize( _n );
+        for( size_t k = 0; k < _n; ++k ) {
+            uint32_t r = 0;
+            for( size_t b = 0; b < bits; ++b )
+                r |= ( ( k >> b ) & 1 ) << ( bits - 1 - b );
+            _reversed[ k ] = r;
+        }
+
+        return *this;
+    }
+
+    size_t size() const { return _n; }
+
+_ENGINE_PROTECTED:
+    template< bool inverse >
+    void _run( Cplx* data, size_t step ) const {
+        for( size_t k = 0; k < _n; ++k )
+            if( k < _reversed[ k ] )
+                std::swap( data[ k * step ], data[ _reversed[ k ] * step ] );
+
+        for( size_t len = 2; len <= _n; len <<= 1 ) {
+            const size_t half   = len / 2;
+            const size_t stride = _n / len;
+
+            for( size_t at = 0; at < _n; at += len ) {
+                for( size_t k = 0; k < half; ++k ) {
+                    Cplx w = _twiddles[ k * stride ];
+                    if constexpr( inverse ) w = std::conj( w );
+
+                    Cplx& a = data[ ( at + k ) * step ];
+                    Cplx& b = data[ ( at + k + half ) * step ];
+                    Cplx  t = b * w;
+
+                    b = a - t;
+                    a = a + t;
+                }
+            }
+        }
+
+        if constexpr( inverse ) {
+            const T scale = T{ 1 } / _n;
+            for( size_t k = 0; k < _n; ++k )
+                data[ k * step ] *= scale;
+        }
+    }
+
+public:
+    /* step is the distance, in elements, between consecutive samples. */
+    void forward( Cplx* data, size_t step = 1 ) const { this->_run< false >( data, step ); }
+    void inverse( Cplx* data, size_t step = 1 ) const { this->_run< true >( data, step ); }
+
+    /* Row-major n x n block, rows then columns. */
+    void forward_2d( Cplx* data ) const {
+        for( size_t r = 0; r < _n; ++r ) this->forward( data + r * _n );
+        for( size_t c = 0; c < _n; ++c ) this->forward( data + c, _n );
+    }
+
+    void inverse_2d( Cplx* data ) const {
+        for( size_t r = 0; r < _n; ++r ) this->inverse( data + r * _n );
+        for( size_t c = 0; c < _n; ++c ) this->inverse( data + c, _n );
+    }
+
+};
+
+
+
+};
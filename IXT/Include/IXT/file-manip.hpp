@@ -3,6 +3,14 @@
 */
 
 #include <IXT/descriptor.hpp>
+#include <IXT/thread-pool.hpp>
+
+#if !defined( _ENGINE_OS_WINDOWS )
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 
 
@@ -13,6 +21,7 @@ namespace _ENGINE_NAMESPACE {
 enum FILE_FEIDM_RESULT : DWORD {
     FILE_FEIDM_RESULT_DONE,
     FILE_FEIDM_RESULT_ABORTED,
+    FILE_FEIDM_RESULT_ERROR,
 
     FILE_FEIDM_RESULT_ITR_CONTINUE,
     FILE_FEIDM_RESULT_ITR_ABORT,
@@ -20,6 +29,18 @@ enum FILE_FEIDM_RESULT : DWORD {
     _FILE_FEIDM_OP_RESULTFORCE_DWORD = 0x7F'FF'FF'FF
 };
 
+enum FILE_MAP_MODE : BYTE {
+    FILE_MAP_MODE_READ,
+    FILE_MAP_MODE_COPY_ON_WRITE
+};
+
+enum FILE_MAP_HINT : BYTE {
+    FILE_MAP_HINT_NORMAL,
+    FILE_MAP_HINT_SEQUENTIAL,
+    FILE_MAP_HINT_RANDOM,
+    FILE_MAP_HINT_WILLNEED
+};
+
 class File {
 public:
     static std::string dir_of( std::string_view path ) {
@@ -44,11 +65,200 @@ public:
     }
 
     static size_t byte_count( std::string_view path ) {
-        std::ifstream file( path.data(), std::ios_base::binary );
+        std::error_code ec;
+        size_t          bc = std::filesystem::file_size( path, ec );
 
-        return byte_count( file );
+        return ec ? 0 : bc;
     }
 
+public:
+    /*
+    A whole file, mapped into memory. Read-only maps share their pages with the OS cache. Copy-on-write maps
+    are writable, each page written becomes private to the map, and nothing ever reaches the file.
+    */
+    class Map : public Descriptor {
+    public:
+        _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "File::Map" );
+
+    public:
+        Map() = default;
+
+        Map(
+            const std::filesystem::path& path,
+            FILE_MAP_MODE                mode   = FILE_MAP_MODE_READ,
+            FILE_MAP_HINT                hint   = FILE_MAP_HINT_NORMAL,
+            _ENGINE_COMMS_ECHO_ARG
+        ) : _mode{ mode } {
+        #if defined( _ENGINE_OS_WINDOWS )
+            DWORD flags = FILE_ATTRIBUTE_NORMAL;
+            if( hint == FILE_MAP_HINT_SEQUENTIAL ) flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+            else if( hint == FILE_MAP_HINT_RANDOM ) flags |= FILE_FLAG_RANDOM_ACCESS;
+
+            _file = CreateFileW( path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL );
+
+            if( _file == INVALID_HANDLE_VALUE ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.string() << "\".";
+                return;
+            }
+
+            LARGE_INTEGER size;
+            GetFileSizeEx( _file, &size );
+            _size = size.QuadPart;
+        #else
+            _file = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+
+            if( _file < 0 ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.string() << "\".";
+                return;
+            }
+
+            struct stat st;
+            ::fstat( _file, &st );
+            _size = st.st_size;
+        #endif
+
+            if( _size == 0 ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Empty file, nothing to map: \"" << path.string() << "\".";
+                this->_unmap();
+                return;
+            }
+
+        #if defined( _ENGINE_OS_WINDOWS )
+            const bool cow = mode == FILE_MAP_MODE_COPY_ON_WRITE;
+
+            _mapping = CreateFileMappingA( _file, NULL, cow ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL );
+            _base    = _mapping != NULL ? ( ubyte_t* )MapViewOfFile( _mapping, cow ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0 ) : nullptr;
+        #else
+            const int prot = PROT_READ | ( mode == FILE_MAP_MODE_COPY_ON_WRITE ? PROT_WRITE : 0 );
+
+            void* base = ::mmap( nullptr, _size, prot, MAP_PRIVATE, _file, 0 );
+            _base = base != MAP_FAILED ? ( ubyte_t* )base : nullptr;
+        #endif
+
+            if( _base == nullptr ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Could NOT map file: \"" << path.string() << "\".";
+                this->_unmap();
+                return;
+            }
+
+            if( hint != FILE_MAP_HINT_NORMAL ) this->advise( hint );
+        }
+
+        Map( const Map& ) = delete;
+
+        Map( Map&& other ) noexcept
+        : _file{ std::exchange( other._file, _INVALID_FILE ) },
+        #if defined( _ENGINE_OS_WINDOWS )
+          _mapping{ std::exchange( other._mapping, ( HANDLE )NULL ) },
+        #endif
+          _base{ std::exchange( other._base, nullptr ) },
+          _size{ std::exchange( other._size, 0 ) },
+          _mode{ other._mode }
+        {}
+
+        Map& operator = ( Map&& other ) noexcept {
+            if( this == &other ) return *this;
+
+            this->_unmap();
+
+            _file    = std::exchange( other._file, _INVALID_FILE );
+        #if defined( _ENGINE_OS_WINDOWS )
+            _mapping = std::exchange( other._mapping, ( HANDLE )NULL );
+        #endif
+            _base    = std::exchange( other._base, nullptr );
+            _size    = std::exchange( other._size, 0 );
+            _mode    = other._mode;
+
+            return *this;
+        }
+
+        ~Map() {
+            this->_unmap();
+        }
+
+    _ENGINE_PROTECTED:
+    #if defined( _ENGINE_OS_WINDOWS )
+        inline static const HANDLE   _INVALID_FILE   = INVALID_HANDLE_VALUE;
+
+        HANDLE          _file      = INVALID_HANDLE_VALUE;
+        HANDLE          _mapping   = NULL;
+    #else
+        inline static constexpr int  _INVALID_FILE   = -1;
+
+        int             _file      = -1;
+    #endif
+        ubyte_t*        _base      = nullptr;
+        size_t          _size      = 0;
+        FILE_MAP_MODE   _mode      = FILE_MAP_MODE_READ;
+
+    _ENGINE_PROTECTED:
+        void _unmap() {
+        #if defined( _ENGINE_OS_WINDOWS )
+            if( _base != nullptr ) UnmapViewOfFile( _base );
+            if( _mapping != NULL ) CloseHandle( _mapping );
+            if( _file != INVALID_HANDLE_VALUE ) CloseHandle( _file );
+
+            _mapping = NULL;
+        #else
+            if( _base != nullptr ) ::munmap( _base, _size );
+            if( _file >= 0 ) ::close( _file );
+        #endif
+            _file = _INVALID_FILE;
+            _base = nullptr;
+            _size = 0;
+        }
+
+    public:
+        operator bool () const {
+            return _base != nullptr;
+        }
+
+        FILE_MAP_MODE mode() const { return _mode; }
+
+        size_t size() const { return _size; }
+
+        const ubyte_t* data() const { return _base; }
+
+        /* Only for copy-on-write maps, nullptr otherwise. */
+        ubyte_t* mutable_data() { return _mode == FILE_MAP_MODE_COPY_ON_WRITE ? _base : nullptr; }
+
+        std::span< const ubyte_t > bytes() const { return { _base, _size }; }
+
+        std::span< ubyte_t > mutable_bytes() { return { this->mutable_data(), _mode == FILE_MAP_MODE_COPY_ON_WRITE ? _size : 0 }; }
+
+        std::string_view view() const { return { ( const char* )_base, _size }; }
+
+    public:
+        /*
+        Access pattern hint for [ ofs, ofs + count ). Windows has no advice for mapped views, there both
+        sequential and willneed prefetch the range, the rest only count when passed at construction.
+        */
+        Map& advise( FILE_MAP_HINT hint, size_t ofs = 0, size_t count = ~size_t{ 0 } ) {
+            if( _base == nullptr || ofs >= _size ) return *this;
+
+            count = std::min( count, _size - ofs );
+
+        #if defined( _ENGINE_OS_WINDOWS )
+            #if defined( _WIN32_WINNT ) && _WIN32_WINNT >= 0x0602
+            if( hint == FILE_MAP_HINT_SEQUENTIAL || hint == FILE_MAP_HINT_WILLNEED ) {
+                WIN32_MEMORY_RANGE_ENTRY range{ _base + ofs, count };
+                PrefetchVirtualMemory( GetCurrentProcess(), 1, &range, 0 );
+            }
+            #endif
+        #else
+            /* madvise wants a page aligned start. */
+            const size_t page = ( size_t )::sysconf( _SC_PAGESIZE );
+            const size_t lead = ofs % page;
+
+            static constexpr int ADVICE[] = { MADV_NORMAL, MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED };
+            ::madvise( _base + ofs - lead, count + lead, ADVICE[ hint ] );
+        #endif
+
+            return *this;
+        }
+
+    };
+
 public:
     static std::string browse( std::string_view title ) {
         char path[ MAX_PATH ];
@@ -90,15 +300,199 @@ public:
         return path;
     }
 
+public:
+    /*
+    A file name pattern, compiled once. Regexes and globs that reduce to a literal, a prefix, a suffix or an exact
+    name are matched with plain string compares, only the rest go through std::regex.
+    */
+    class Pattern {
+    public:
+        enum KIND : BYTE {
+            KIND_ANY,
+            KIND_CONTAINS,
+            KIND_PREFIX,
+            KIND_SUFFIX,
+            KIND_EXACT,
+            KIND_GLOB,
+            KIND_REGEX
+        };
+
+    public:
+        Pattern() = default;
+
+    _ENGINE_PROTECTED:
+        KIND                                 _kind   = KIND_ANY;
+        std::string                          _text   = {};
+        std::shared_ptr< const std::regex >  _rgx    = nullptr;
+
+    _ENGINE_PROTECTED:
+        static bool _glob_match( std::string_view glob, std::string_view name ) {
+            size_t g = 0, n = 0, star = std::string_view::npos, mark = 0;
+
+            while( n < name.size() ) {
+                if( g < glob.size() && ( glob[ g ] == '?' || glob[ g ] == name[ n ] ) ) { ++g; ++n; }
+                else if( g < glob.size() && glob[ g ] == '*' ) { star = g++; mark = n; }
+                else if( star != std::string_view::npos ) { g = star + 1; n = ++mark; }
+                else return false;
+            }
+
+            while( g < glob.size() && glob[ g ] == '*' ) ++g;
+            return g == glob.size();
+        }
+
+    public:
+        static Pattern regex( std::string_view rgx ) {
+            Pattern pattern;
+
+            const bool anchored_front = !rgx.empty() && rgx.front() == '^';
+            const bool anchored_back  = rgx.size() >= size_t{ 2 } + anchored_front && rgx.back() == '$' && rgx[ rgx.size() - 2 ] != '\\';
+
+            std::string_view body    = rgx.substr( anchored_front, rgx.size() - anchored_front - anchored_back );
+            bool             literal = true;
+
+            for( size_t n = 0; n < body.size() && literal; ++n ) {
+                if( body[ n ] == '\\' && n + 1 < body.size() && std::strchr( ".^$|()[]{}*+?\\/-", body[ n + 1 ] ) ) {
+                    pattern._text += body[ ++n ];
+                } else if( std::strchr( ".^$|()[]{}*+?\\", body[ n ] ) ) {
+                    literal = false;
+                } else {
+                    pattern._text += body[ n ];
+                }
+            }
+
+            if( !literal ) {
+                pattern._kind = KIND_REGEX;
+                pattern._text = rgx;
+                pattern._rgx  = std::make_shared< const std::regex >( pattern._text, std::regex::ECMAScript | std::regex::optimize );
+            } else if( pattern._text.empty() && !( anchored_front && anchored_back ) ) {
+                pattern._kind = KIND_ANY;
+            } else {
+                pattern._kind = anchored_front ? ( anchored_back ? KIND_EXACT : KIND_PREFIX ) : ( anchored_back ? KIND_SUFFIX : KIND_CONTAINS );
+            }
+
+            return pattern;
+        }
+
+        /* '*' and '?' wildcards, matched against the whole name. */
+        static Pattern glob( std::string_view glob ) {
+            Pattern pattern;
+
+            const size_t first = glob.find_first_of( "*?" );
+            const size_t last  = glob.find_last_of( "*?" );
+
+            if( first == std::string_view::npos ) {
+                pattern._kind = KIND_EXACT;
+                pattern._text = glob;
+            } else if( glob.find( '?' ) != std::string_view::npos ) {
+                pattern._kind = KIND_GLOB;
+                pattern._text = glob;
+            } else if( glob.find_first_not_of( '*' ) == std::string_view::npos ) {
+                pattern._kind = KIND_ANY;
+            } else if( first == 0 && last == glob.size() - 1 && glob.substr( 1, glob.size() - 2 ).find( '*' ) == std::string_view::npos ) {
+                pattern._kind = KIND_CONTAINS;
+                pattern._text = glob.substr( 1, glob.size() - 2 );
+            } else if( first == 0 && glob.substr( 1 ).find( '*' ) == std::string_view::npos ) {
+                pattern._kind = KIND_SUFFIX;
+                pattern._text = glob.substr( 1 );
+            } else if( first == glob.size() - 1 ) {
+                pattern._kind = KIND_PREFIX;
+                pattern._text = glob.substr( 0, first );
+            } else {
+                pattern._kind = KIND_GLOB;
+                pattern._text = glob;
+            }
+
+            return pattern;
+        }
+
+    public:
+        KIND kind() const { return _kind; }
+
+        bool operator () ( std::string_view name ) const {
+            switch( _kind ) {
+                case KIND_ANY:      return true;
+                case KIND_CONTAINS: return name.find( _text ) != std::string_view::npos;
+                case KIND_PREFIX:   return name.starts_with( _text );
+                case KIND_SUFFIX:   return name.ends_with( _text );
+                case KIND_EXACT:    return name == _text;
+                case KIND_GLOB:     return _glob_match( _text, name );
+                default:            return std::regex_search( name.begin(), name.end(), *_rgx );
+            }
+        }
+
+    };
+
+_ENGINE_PROTECTED:
+    /* The file name part, without a copy where paths are narrow. */
+    static std::string_view _name_of( const std::filesystem::path& path, std::string& scratch ) {
+        if constexpr( std::is_same_v< std::filesystem::path::value_type, char > ) {
+            std::string_view full = path.native();
+            size_t           pos  = full.find_last_of( '/' );
+            return pos == std::string_view::npos ? full : full.substr( pos + 1 );
+        } else {
+            scratch = path.filename().string();
+            return scratch;
+        }
+    }
+
+    template< typename Op >
+    struct _ScanState {
+        Op*                                 op        = nullptr;
+        std::mutex                          mtx       = {};
+        std::condition_variable             idle      = {};
+        std::deque< std::filesystem::path > queue     = {};
+        size_t                              depth     = 0;
+        size_t                              helpers   = 0;
+        size_t                              running   = 0;
+        std::exception_ptr                  error     = nullptr;
+        std::atomic< bool >                 aborted   = { false };
+
+        /* A throwing op aborts the scan, the first exception is kept for the walking thread to rethrow. */
+        void run( const std::filesystem::path& path ) {
+            if( aborted.load( std::memory_order_relaxed ) ) return;
+
+            try {
+                if( std::invoke( *op, path ) == FILE_FEIDM_RESULT_ITR_ABORT )
+                    aborted.store( true, std::memory_order_relaxed );
+            } catch( ... ) {
+                std::unique_lock< std::mutex > lock{ mtx };
+                if( !error ) error = std::current_exception();
+                aborted.store( true, std::memory_order_relaxed );
+            }
+        }
+
+        /*
+        Worker side. Returns as soon as the queue is empty, the walk posts a new helper when work arrives again.
+        Does not touch op once the scan is over, the caller may be gone by then.
+        */
+        void drain() {
+            std::unique_lock< std::mutex > lock{ mtx };
+
+            while( !queue.empty() ) {
+                auto path = std::move( queue.front() );
+                queue.pop_front();
+                ++running;
+
+                lock.unlock();
+                this->run( path );
+                lock.lock();
+
+                if( --running == 0 ) idle.notify_all();
+            }
+
+            --helpers;
+        }
+    };
+
 public:
     static DWORD for_each_in_dir_matching( const char* dir, const char* rgx_c_str, std::function< DWORD( std::string_view ) > op ) {
-        std::regex rgx{ rgx_c_str };
+        const Pattern pattern = Pattern::regex( rgx_c_str );
+        std::string   scratch = {};
 
-        for( auto entry : std::filesystem::directory_iterator{ dir } ) {
-            auto file_name    = entry.path().filename().string();
-            std::smatch match = {};
+        for( auto& entry : std::filesystem::directory_iterator{ dir } ) {
+            std::string_view file_name = _name_of( entry.path(), scratch );
 
-            if( !std::regex_search( file_name, match, rgx ) ) continue;
+            if( !pattern( file_name ) ) continue;
 
             DWORD result = std::invoke( op, file_name );
 
@@ -111,6 +505,101 @@ public:
         return FILE_FEIDM_RESULT_DONE;
     }
 
+    /*
+    Walks dir, optionally recursively, and hands every file whose name matches to op( const std::filesystem::path& )
+    on the pool's workers, through a queue of at most queue_depth paths. The walking thread runs matches itself when
+    the queue is full. Matches run concurrently and in no particular order. Returning FILE_FEIDM_RESULT_ITR_ABORT
+    stops the walk, matches already queued are dropped. An exception out of op does the same, and is rethrown here
+    once no worker is inside op anymore. A walk that fails to open or step through dir yields FILE_FEIDM_RESULT_ERROR.
+    */
+    template< typename Op >
+    static DWORD scan(
+        const std::filesystem::path& dir,
+        const Pattern&               pattern,
+        Op&&                         op,
+        bool                         recursive     = false,
+        ThreadPool&                  pool          = ThreadPool::shared(),
+        size_t                       queue_depth   = 1024,
+        _ENGINE_COMMS_ECHO_ARG
+    ) {
+        static struct _Invoker : Descriptor {
+            _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "File::scan" );
+        } invoker;
+
+        using Opr = std::remove_reference_t< Op >;
+
+        auto state = std::make_shared< _ScanState< Opr > >();
+        state->op    = &op;
+        state->depth = std::max< size_t >( queue_depth, 1 );
+
+        /* Helpers hold a worker only while there is something queued, and at most half of the pool. */
+        const size_t max_helpers = std::max< size_t >( pool.thread_count() / 2, 1 );
+
+        std::string scratch = {};
+
+        auto offer = [ & ] ( const std::filesystem::directory_entry& entry ) -> bool {
+            std::error_code ec;
+            if( entry.is_directory( ec ) ) return true;
+
+            if( !pattern( _name_of( entry.path(), scratch ) ) ) return true;
+
+            std::unique_lock< std::mutex > lock{ state->mtx };
+
+            while( state->queue.size() >= state->depth ) {
+                auto path = std::move( state->queue.front() );
+                state->queue.pop_front();
+
+                lock.unlock();
+                state->run( path );
+                lock.lock();
+            }
+
+            state->queue.emplace_back( entry.path() );
+
+            const bool spawn = state->helpers < max_helpers;
+            if( spawn ) ++state->helpers;
+            lock.unlock();
+
+            if( spawn ) pool.post( [ state ] () -> void { state->drain(); } );
+
+            return !state->aborted.load( std::memory_order_relaxed );
+        };
+
+        std::error_code ec;
+        const auto      opts = std::filesystem::directory_options::skip_permission_denied;
+
+        if( recursive ) {
+            for( std::filesystem::recursive_directory_iterator itr{ dir, opts, ec }, end; !ec && itr != end; itr.increment( ec ) )
+                if( !offer( *itr ) ) break;
+        } else {
+            for( std::filesystem::directory_iterator itr{ dir, opts, ec }, end; !ec && itr != end; itr.increment( ec ) )
+                if( !offer( *itr ) ) break;
+        }
+
+        /* Help with what is left, then wait for the workers still inside op. */
+        std::unique_lock< std::mutex > lock{ state->mtx };
+
+        while( !state->queue.empty() ) {
+            auto path = std::move( state->queue.front() );
+            state->queue.pop_front();
+
+            lock.unlock();
+            state->run( path );
+            lock.lock();
+        }
+
+        state->idle.wait( lock, [ &state ] () -> bool { return state->running == 0; } );
+
+        if( state->error ) std::rethrow_exception( state->error );
+
+        if( ec ) {
+            echo( invoker, ECHO_LEVEL_ERROR ) << "Could NOT walk directory: \"" << dir.string() << "\", " << ec.message() << ".";
+            return FILE_FEIDM_RESULT_ERROR;
+        }
+
+        return state->aborted.load() ? FILE_FEIDM_RESULT_ABORTED : FILE_FEIDM_RESULT_DONE;
+    }
+
 public:
     template< typename Itr >
     static std::optional< ptrdiff_t > next_idx(
@@ -93,8 +93,11 @@ public:
     }
 
 _ENGINE_PROTECTED:
+    /* Sits right before the payload. The block starts head bytes before the payload, aligned to align. */
     struct _ALLOC_INFO_SCALAR {
         std::atomic< QWORD >   ref_count   = { 0 };
+        DWORD                  align       = 0;
+        DWORD                  head        = 0;
     };
     struct _ALLOC_INFO_VECTOR : _ALLOC_INFO_SCALAR {
         QWORD   count   = 0;
@@ -109,11 +112,17 @@ _ENGINE_PROTECTED:
 public:
     template< typename ...Args > requires( !std::is_abstract_v< T > )
     static HYPER_VECTOR< _T > allocv( QWORD count, Args&&... args ) {
-        void* base = malloc( sizeof( _ALLOC_INFO ) + sizeof( T ) * count );
+        constexpr DWORD align = std::max( alignof( T ), alignof( _ALLOC_INFO ) );
+        constexpr DWORD head  = ( sizeof( _ALLOC_INFO ) + align - 1 ) / align * align;
+
+        void* base = ::operator new( head + sizeof( T ) * count, std::align_val_t{ align }, std::nothrow );
         if( base == nullptr ) return HYPER_VECTOR< _T >{ nullptr, ( WORD )0 };
 
-        _ALLOC_INFO& info = *( _ALLOC_INFO* )base;
-        T* ptr = ( T* )( ( BYTE* )base + sizeof( _ALLOC_INFO ) );
+        T* ptr = ( T* )( ( BYTE* )base + head );
+        _ALLOC_INFO& info = *new( ( BYTE* )ptr - sizeof( _ALLOC_INFO ) ) _ALLOC_INFO{};
+
+        info.align = align;
+        info.head  = head;
 
         if constexpr( _is_array ) {
             for( QWORD idx = 0; idx < count; ++idx )
@@ -158,7 +167,8 @@ _ENGINE_PROTECTED:
             _ptr->~T();
         }
 
-        free_ptr = ( void* )info;
+        ::operator delete( ( BYTE* )_ptr - info->head, std::align_val_t{ static_cast< std::size_t >( info->align ) } );
+        goto l_reset;
     }
     }
 
@@ -0,0 +1,376 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/comms.hpp>
+#include <IXT/fft.hpp>
+#include <IXT/image.hpp>
+#include <IXT/thread-pool.hpp>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+enum IMAGE_KERNEL_MODE : BYTE {
+    IMAGE_KERNEL_MODE_AUTO = 0,
+    IMAGE_KERNEL_MODE_SEPARABLE,
+    IMAGE_KERNEL_MODE_DIRECT,
+    IMAGE_KERNEL_MODE_FFT,
+
+    _IMAGE_KERNEL_MODE_FORCE_BYTE = 0x7F
+};
+
+
+
+/*
+Odd sized correlation kernel, centered, applied to every channel. Taps that fall outside the image
+contribute nothing. Results are rounded and clamped into the byte range.
+Rank one kernels are split into a row and a column pass, large ones go through tiled FFTs.
+*/
+class ImageKernel : public Descriptor {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "ImageKernel" );
+
+public:
+    inline static constexpr int32_t   FFT_TAP_THRESHOLD    = 25 * 25;
+    inline static constexpr int32_t   DIRECT_TILE_WIDTH    = 512;
+    inline static constexpr float     SEPARABLE_EPSILON    = 1e-6f;
+
+public:
+    ImageKernel() = default;
+
+    ImageKernel( int32_t width, int32_t height, std::vector< float > taps, _ENGINE_COMMS_ECHO_ARG )
+    : _width{ width }, _height{ height }, _taps{ std::move( taps ) }
+    {
+        if( _width <= 0 || _height <= 0 || !( _width & 1 ) || !( _height & 1 ) || _taps.size() != ( size_t )_width * _height ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Kernel shall be odd sized and have width * height taps.";
+            _width = _height = 0; _taps.clear();
+            return;
+        }
+
+        this->_split();
+    }
+
+_ENGINE_PROTECTED:
+    int32_t                _width       = 0;
+    int32_t                _height      = 0;
+    std::vector< float >   _taps        = {};
+
+    bool                   _separable   = false;
+    std::vector< float >   _row         = {};
+    std::vector< float >   _col         = {};
+
+_ENGINE_PROTECTED:
+    /* Rank one check around the largest tap. */
+    void _split() {
+        size_t pivot = 0;
+        for( size_t n = 1; n < _taps.size(); ++n )
+            if( std::abs( _taps[ n ] ) > std::abs( _taps[ pivot ] ) ) pivot = n;
+
+        const float p = _taps[ pivot ];
+        if( p == 0.0f ) return;
+
+        const int32_t py = pivot / _width;
+        const int32_t px = pivot % _width;
+
+        _row.assign( _taps.begin() + py * _width, _taps.begin() + ( py + 1 ) * _width );
+        _col.resize( _height );
+        for( int32_t y = 0; y < _height; ++y )
+            _col[ y ] = _taps[ y * _width + px ] / p;
+
+        const float tolerance = SEPARABLE_EPSILON * std::abs( p );
+
+        for( int32_t y = 0; y < _height; ++y )
+            for( int32_t x = 0; x < _width; ++x )
+                if( std::abs( _col[ y ] * _row[ x ] - _taps[ y * _width + x ] ) > tolerance ) {
+                    _row.clear(); _col.clear();
+                    return;
+                }
+
+        _separable = true;
+    }
+
+public:
+    static ImageKernel box( int32_t n ) {
+        return ImageKernel{ n, n, std::vector< float >( n * n, 1.0f / ( n * n ) ) };
+    }
+
+    static ImageKernel gaussian( int32_t n, float sigma ) {
+        std::vector< float > taps( n * n );
+        float                sum = 0.0f;
+
+        for( int32_t y = 0; y < n; ++y )
+            for( int32_t x = 0; x < n; ++x ) {
+                float dy = y - n / 2, dx = x - n / 2;
+                sum += ( taps[ y * n + x ] = std::exp( -( dx * dx + dy * dy ) / ( 2.0f * sigma * sigma ) ) );
+            }
+
+        for( auto& t : taps ) t /= sum;
+
+        return ImageKernel{ n, n, std::move( taps ) };
+    }
+
+    /* Legacy image_filtering's Filter::gaussian_high. */
+    static ImageKernel gaussian_high( int32_t n, float sigma ) {
+        std::vector< float > taps( n * n );
+        float                sum = 0.0f;
+
+        for( int32_t y = 0; y < n; ++y )
+            for( int32_t x = 0; x < n; ++x ) {
+                float dy = y - n / 2, dx = x - n / 2;
+                sum += ( taps[ y * n + x ] = 1.0f - std::exp( -dy * dy / ( 2.0f * sigma * sigma ) - dx * dx / ( 2.0f * sigma * sigma ) ) );
+            }
+
+        for( auto& t : taps ) t /= sum;
+
+        return ImageKernel{ n, n, std::move( taps ) };
+    }
+
+public:
+    explicit operator bool () const { return !_taps.empty(); }
+
+    int32_t width() const { return _width; }
+    int32_t height() const { return _height; }
+
+    bool is_separable() const { return _separable; }
+
+    float operator () ( int32_t y, int32_t x ) const {
+        return _taps[ ( y + _height / 2 ) * _width + ( x + _width / 2 ) ];
+    }
+
+    IMAGE_KERNEL_MODE auto_mode() const {
+        if( _separable ) return IMAGE_KERNEL_MODE_SEPARABLE;
+        if( _width * _height >= FFT_TAP_THRESHOLD ) return IMAGE_KERNEL_MODE_FFT;
+        return IMAGE_KERNEL_MODE_DIRECT;
+    }
+
+_ENGINE_PROTECTED:
+    /* acc[ 0, n ) += w * src[ 0, n ) */
+    static void _axpy( float* acc, const ubyte_t* src, size_t n, float w ) {
+        size_t at = 0;
+    #if defined( _ENGINE_AVX )
+        const __m256 vw = _mm256_set1_ps( w );
+        for( ; at + 8 <= n; at += 8 ) {
+            __m256 s = _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i* )( src + at ) ) ) );
+            _mm256_storeu_ps( acc + at, _mm256_fmadd_ps( s, vw, _mm256_loadu_ps( acc + at ) ) );
+        }
+    #endif
+        for( ; at < n; ++at ) acc[ at ] += w * src[ at ];
+    }
+
+    static void _axpy( float* acc, const float* src, size_t n, float w ) {
+        size_t at = 0;
+    #if defined( _ENGINE_AVX )
+        const __m256 vw = _mm256_set1_ps( w );
+        for( ; at + 8 <= n; at += 8 )
+            _mm256_storeu_ps( acc + at, _mm256_fmadd_ps( _mm256_loadu_ps( src + at ), vw, _mm256_loadu_ps( acc + at ) ) );
+    #endif
+        for( ; at < n; ++at ) acc[ at ] += w * src[ at ];
+    }
+
+    static void _store( ubyte_t* dst, const float* acc, size_t n ) {
+        size_t at = 0;
+    #if defined( _ENGINE_AVX )
+        for( ; at + 8 <= n; at += 8 ) {
+            __m256i q = _mm256_cvtps_epi32( _mm256_loadu_ps( acc + at ) );
+            __m128i w = _mm_packus_epi32( _mm256_castsi256_si128( q ), _mm256_extracti128_si256( q, 1 ) );
+            _mm_storel_epi64( ( __m128i* )( dst + at ), _mm_packus_epi16( w, w ) );
+        }
+    #endif
+        for( ; at < n; ++at ) dst[ at ] = ( ubyte_t )std::clamp( std::nearbyint( acc[ at ] ), 0.0f, 255.0f );
+    }
+
+    /* Row pass: acc[ x ] = sum_k taps[ k ] * src[ x + k - r ], over the valid part of the row. */
+    template< typename S >
+    static void _correlate_row( float* acc, const S* src, int32_t width, int32_t C, const float* taps, int32_t tap_count ) {
+        const int32_t r = tap_count / 2;
+
+        for( int32_t k = 0; k < tap_count; ++k ) {
+            const int32_t dx = k - r;
+            const int32_t lo = std::max( 0, -dx );
+            const int32_t hi = std::min( width, width - dx );
+
+            if( lo < hi && taps[ k ] != 0.0f )
+                _axpy( acc + lo * C, src + ( lo + dx ) * C, ( size_t )( hi - lo ) * C, taps[ k ] );
+        }
+    }
+
+    void _separable_pass( const ImageView& src, const ImageView& dst, ThreadPool& pool ) const {
+        const int32_t W  = src.width, H = src.height, C = src.channels;
+        const size_t  RS = src.row_size();
+
+        std::vector< float > tmp( RS * H, 0.0f );
+
+        src.parallel_for_rows( [ & ] ( int32_t lo, int32_t hi ) -> void {
+            for( int32_t y = lo; y < hi; ++y )
+                _correlate_row( tmp.data() + y * RS, src.row( y ), W, C, _row.data(), _width );
+        }, 8, pool );
+
+        const int32_t r = _height / 2;
+
+        src.parallel_for_rows( [ & ] ( int32_t lo, int32_t hi ) -> void {
+            std::vector< float > acc( RS );
+
+            for( int32_t y = lo; y < hi; ++y ) {
+                std::fill( acc.begin(), acc.end(), 0.0f );
+
+                for( int32_t k = 0; k < _height; ++k ) {
+                    const int32_t sy = y + k - r;
+                    if( sy < 0 || sy >= H || _col[ k ] == 0.0f ) continue;
+
+                    _axpy( acc.data(), tmp.data() + sy * RS, RS, _col[ k ] );
+                }
+
+                _store( dst.row( y ), acc.data(), RS );
+            }
+        }, 8, pool );
+    }
+
+    /* Tap-outer over column tiles of the row, so the accumulator and the source stay in cache. */
+    void _direct_pass( const ImageView& src, const ImageView& dst, ThreadPool& pool ) const {
+        const int32_t W  = src.width, H = src.height, C = src.channels;
+        const int32_t rx = _width / 2, ry = _height / 2;
+
+        src.parallel_for_rows( [ & ] ( int32_t lo, int32_t hi ) -> void {
+            std::vector< float > acc( ( size_t )DIRECT_TILE_WIDTH * C );
+
+            for( int32_t y = lo; y < hi; ++y ) {
+                for( int32_t x0 = 0; x0 < W; x0 += DIRECT_TILE_WIDTH ) {
+                    const int32_t x1 = std::min( x0 + DIRECT_TILE_WIDTH, W );
+
+                    std::fill( acc.begin(), acc.end(), 0.0f );
+
+                    for( int32_t ky = 0; ky < _height; ++ky ) {
+                        const int32_t sy = y + ky - ry;
+                        if( sy < 0 || sy >= H ) continue;
+
+                        const ubyte_t* row  = src.row( sy );
+                        const float*   taps = _taps.data() + ky * _width;
+
+                        for( int32_t kx = 0; kx < _width; ++kx ) {
+                            const int32_t dx  = kx - rx;
+                            const int32_t xlo = std::max( x0, -dx );
+                            const int32_t xhi = std::min( x1, W - dx );
+
+                            if( xlo < xhi && taps[ kx ] != 0.0f )
+                                _axpy( acc.data() + ( xlo - x0 ) * C, row + ( xlo + dx ) * C, ( size_t )( xhi - xlo ) * C, taps[ kx ] );
+                        }
+                    }
+
+                    _store( dst.row( y ) + x0 * C, acc.data(), ( size_t )( x1 - x0 ) * C );
+                }
+            }
+        }, 4, pool );
+    }
+
+    /*
+    Overlap-save over square tiles. Channels go through the transform two at a time, as the real and
+    the imaginary part, which the real kernel keeps apart.
+    */
+    void _fft_pass( const ImageView& src, const ImageView& dst, ThreadPool& pool ) const {
+        using Cplx = FftPlan< float >::Cplx;
+
+        const int32_t W  = src.width, H = src.height, C = src.channels;
+        const int32_t rx = _width / 2, ry = _height / 2;
+        const int32_t k  = std::max( _width, _height );
+
+        const FftPlan< float > plan{ ( size_t )std::max( 64, 4 * k ) };
+        const int32_t          P    = plan.size();
+        const int32_t          T    = P - k + 1;
+
+        std::vector< Cplx > spectrum( ( size_t )P * P, Cplx{} );
+        for( int32_t dy = -ry; dy <= ry; ++dy )
+            for( int32_t dx = -rx; dx <= rx; ++dx )
+                spectrum[ ( ( P - dy ) % P ) * P + ( P - dx ) % P ] = this->operator()( dy, dx );
+        plan.forward_2d( spectrum.data() );
+
+        const int64_t tiles_x = ( W + T - 1 ) / T;
+        const int64_t tiles_y = ( H + T - 1 ) / T;
+
+        pool.parallel_for( 0, tiles_x * tiles_y, 1, [ & ] ( int64_t lo, int64_t hi ) -> void {
+            std::vector< Cplx > block( ( size_t )P * P );
+
+            for( int64_t t = lo; t < hi; ++t ) {
+                const int32_t x0 = ( t % tiles_x ) * T;
+                const int32_t y0 = ( t / tiles_x ) * T;
+                const int32_t tw = std::min( T, W - x0 );
+                const int32_t th = std::min( T, H - y0 );
+
+                for( int32_t c = 0; c < C; c += 2 ) {
+                    const bool pair = c + 1 < C;
+
+                    for( int32_t i = 0; i < P; ++i ) {
+                        const int32_t sy = y0 - ry + i;
+                        Cplx*         out = block.data() + i * P;
+
+                        if( sy < 0 || sy >= H ) { std::fill_n( out, P, Cplx{} ); continue; }
+
+                        const ubyte_t* row = src.row( sy );
+                        for( int32_t j = 0; j < P; ++j ) {
+                            const int32_t sx = x0 - rx + j;
+
+                            if( sx < 0 || sx >= W ) { out[ j ] = Cplx{}; continue; }
+
+                            out[ j ] = Cplx{ ( float )row[ sx * C + c ], pair ? ( float )row[ sx * C + c + 1 ] : 0.0f };
+                        }
+                    }
+
+                    plan.forward_2d( block.data() );
+                    for( size_t n = 0; n < block.size(); ++n )
+                        block[ n ] *= spectrum[ n ];
+                    plan.inverse_2d( block.data() );
+
+                    for( int32_t i = 0; i < th; ++i ) {
+                        ubyte_t*    row = dst.row( y0 + i ) + x0 * C;
+                        const Cplx* in  = block.data() + ( i + ry ) * P + rx;
+
+                        for( int32_t j = 0; j < tw; ++j ) {
+                            row[ j * C + c ] = ( ubyte_t )std::clamp( std::nearbyint( in[ j ].real() ), 0.0f, 255.0f );
+                            if( pair )
+                                row[ j * C + c + 1 ] = ( ubyte_t )std::clamp( std::nearbyint( in[ j ].imag() ), 0.0f, 255.0f );
+                        }
+                    }
+                }
+            }
+        } );
+    }
+
+public:
+    /* src and dst shall not overlap and shall have the same shape. Returns the mode that ran. */
+    IMAGE_KERNEL_MODE apply(
+        const ImageView&    src,
+        const ImageView&    dst,
+        IMAGE_KERNEL_MODE   mode   = IMAGE_KERNEL_MODE_AUTO,
+        ThreadPool&         pool   = ThreadPool::shared()
+    ) const {
+        if( !*this || !src || !src.same_shape( dst ) ) return IMAGE_KERNEL_MODE_AUTO;
+
+        if( mode == IMAGE_KERNEL_MODE_AUTO || ( mode == IMAGE_KERNEL_MODE_SEPARABLE && !_separable ) )
+            mode = this->auto_mode();
+
+        switch( mode ) {
+            case IMAGE_KERNEL_MODE_SEPARABLE: this->_separable_pass( src, dst, pool ); break;
+            case IMAGE_KERNEL_MODE_FFT:       this->_fft_pass( src, dst, pool ); break;
+            default:                          this->_direct_pass( src, dst, pool ); mode = IMAGE_KERNEL_MODE_DIRECT; break;
+        }
+
+        return mode;
+    }
+
+    /* Through a copy of img. */
+    IMAGE_KERNEL_MODE apply( const ImageView& img, IMAGE_KERNEL_MODE mode = IMAGE_KERNEL_MODE_AUTO, ThreadPool& pool = ThreadPool::shared() ) const {
+        std::vector< ubyte_t > copy( img.row_size() * img.height );
+        ImageView              src{ .base = copy.data(), .stride = ( ptrdiff_t )img.row_size(), .width = img.width, .height = img.height, .channels = img.channels };
+
+        for( int32_t y = 0; y < img.height; ++y )
+            std::memcpy( src.row( y ), img.row( y ), img.row_size() );
+
+        return this->apply( src, img, mode, pool );
+    }
+
+};
+
+
+
+};
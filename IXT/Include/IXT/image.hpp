@@ -0,0 +1,104 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/thread-pool.hpp>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+/*
+Non-owning window over interleaved 8 bit pixels. Rows are stride bytes apart, which may be more than
+width * channels ( padding ), or negative ( rows stored bottom-up ). Row 0 is the row at base.
+*/
+struct ImageView {
+    ubyte_t*    base       = nullptr;
+    ptrdiff_t   stride     = 0;
+    int32_t     width      = 0;
+    int32_t     height     = 0;
+    uint16_t    channels   = 0;
+
+    explicit operator bool () const {
+        return base != nullptr && width > 0 && height > 0;
+    }
+
+    size_t pixel_count() const { return ( size_t )width * height; }
+
+    size_t row_size() const { return ( size_t )width * channels; }
+
+    ubyte_t* row( int32_t y ) const {
+        return base + y * stride;
+    }
+
+    ubyte_t* operator [] ( int32_t y ) const {
+        return this->row( y );
+    }
+
+    ubyte_t* at( int32_t x, int32_t y ) const {
+        return this->row( y ) + x * channels;
+    }
+
+    /* Sub-rectangle, clamped to this view. */
+    ImageView sub( int32_t x, int32_t y, int32_t w, int32_t h ) const {
+        x = std::clamp( x, 0, width );
+        y = std::clamp( y, 0, height );
+        w = std::clamp( w, 0, width - x );
+        h = std::clamp( h, 0, height - y );
+
+        return ImageView{
+            .base     = this->at( x, y ),
+            .stride   = stride,
+            .width    = w,
+            .height   = h,
+            .channels = channels
+        };
+    }
+
+    bool same_shape( const ImageView& other ) const {
+        return width == other.width && height == other.height && channels == other.channels;
+    }
+
+public:
+    /* op( ImageView tile, int32_t x, int32_t y ), tiles in row-major order, edge tiles cut to the view. Empty tiles visit nothing. */
+    template< typename Op >
+    void for_each_tile( int32_t tile_width, int32_t tile_height, Op&& op ) const {
+        if( tile_width <= 0 || tile_height <= 0 ) return;
+
+        for( int32_t y = 0; y < height; y += tile_height )
+            for( int32_t x = 0; x < width; x += tile_width )
+                std::invoke( op, this->sub( x, y, tile_width, tile_height ), x, y );
+    }
+
+    /* op( int32_t y_begin, int32_t y_end ), bands of at least grain rows, spread over the pool. */
+    template< typename Op >
+    void parallel_for_rows( Op&& op, int32_t grain = 16, ThreadPool& pool = ThreadPool::shared() ) const {
+        pool.parallel_for( 0, height, grain, [ &op ] ( int64_t lo, int64_t hi ) -> void {
+            std::invoke( op, ( int32_t )lo, ( int32_t )hi );
+        } );
+    }
+
+    /* op( ImageView tile, int32_t x, int32_t y ), the tiles spread over the pool. */
+    template< typename Op >
+    void parallel_for_tiles( int32_t tile_width, int32_t tile_height, Op&& op, ThreadPool& pool = ThreadPool::shared() ) const {
+        if( tile_width <= 0 || tile_height <= 0 ) return;
+
+        const int64_t tiles_x = ( width + tile_width - 1 ) / tile_width;
+        const int64_t tiles_y = ( height + tile_height - 1 ) / tile_height;
+
+        pool.parallel_for( 0, tiles_x * tiles_y, 1, [ & ] ( int64_t lo, int64_t hi ) -> void {
+            for( int64_t t = lo; t < hi; ++t ) {
+                int32_t x = ( t % tiles_x ) * tile_width;
+                int32_t y = ( t / tiles_x ) * tile_height;
+
+                std::invoke( op, this->sub( x, y, tile_width, tile_height ), x, y );
+            }
+        } );
+    }
+
+};
+
+
+
+};
@@ -0,0 +1,259 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+
+#include <bit>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+inline constexpr size_t LOCK_FREE_CACHE_LINE = 64;
+
+
+
+/*
+Single producer, single consumer ring of fixed capacity.
+The producer claims free space through write_span() and publishes it with commit().
+The consumer claims filled space through read_span() and hands it back with release().
+Spans never wrap, so a full sweep may take two span calls. Keep the capacity a multiple of 
+whatever record size the ends exchange, so that spans never split a record.
+*/
+template< typename T >
+class SpscRing {
+public:
+    SpscRing() = default;
+
+    SpscRing( size_t capacity ) {
+        this->reserve( capacity );
+    }
+
+    SpscRing( const SpscRing& ) = delete;
+    SpscRing( SpscRing&& ) = delete;
+
+_ENGINE_PROTECTED:
+    UPtr< T[] >   _buffer     = nullptr;
+    size_t        _capacity   = 0;
+
+    alignas( LOCK_FREE_CACHE_LINE ) std::atomic< size_t >     _head          = { 0 };
+    alignas( LOCK_FREE_CACHE_LINE ) std::atomic< size_t >     _tail          = { 0 };
+
+    std::atomic< uint32_t >                                   _head_wakes    = { 0 };
+    std::atomic< uint32_t >                                   _tail_wakes    = { 0 };
+
+public:
+    SpscRing& reserve( size_t capacity ) {
+        _buffer.reset( new T[ capacity ] );
+        _capacity = capacity;
+
+        _head.store( 0, std::memory_order_relaxed );
+        _tail.store( 0, std::memory_order_relaxed );
+
+        return *this;
+    }
+
+    /* Not thread safe, both ends shall be idle. */
+    SpscRing& clear() {
+        _head.store( 0, std::memory_order_relaxed );
+        _tail.store( 0, std::memory_order_relaxed );
+        return *this;
+    }
+
+public:
+    size_t capacity() const { return _capacity; }
+
+    size_t size() const {
+        return _head.load( std::memory_order_acquire ) - _tail.load( std::memory_order_acquire );
+    }
+
+    size_t space() const { return this->capacity() - this->size(); }
+
+    bool empty() const { return this->size() == 0; }
+
+    /* Total counts ever committed, respectively released. */
+    size_t head() const { return _head.load( std::memory_order_acquire ); }
+    size_t tail() const { return _tail.load( std::memory_order_acquire ); }
+
+public:
+    std::span< T > write_span( size_t max_count = ~size_t{ 0 } ) {
+        size_t head = _head.load( std::memory_order_relaxed );
+        size_t free = this->capacity() - ( head - _tail.load( std::memory_order_acquire ) );
+        size_t at   = head % _capacity;
+
+        return { _buffer.get() + at, std::min( { free, this->capacity() - at, max_count } ) };
+    }
+
+    void commit( size_t count ) {
+        _head.fetch_add( count, std::memory_order_release );
+        _head_wakes.fetch_add( 1, std::memory_order_release );
+        _head_wakes.notify_one();
+    }
+
+    std::span< const T > read_span( size_t max_count = ~size_t{ 0 } ) const {
+        size_t tail = _tail.load( std::memory_order_relaxed );
+        size_t used = _head.load( std::memory_order_acquire ) - tail;
+        size_t at   = tail % _capacity;
+
+        return { _buffer.get() + at, std::min( { used, this->capacity() - at, max_count } ) };
+    }
+
+    void release( size_t count ) {
+        _tail.fetch_add( count, std::memory_order_release );
+        _tail_wakes.fetch_add( 1, std::memory_order_release );
+        _tail_wakes.notify_one();
+    }
+
+public:
+    bool push( const T& value ) {
+        auto span = this->write_span( 1 );
+        if( span.empty() ) return false;
+
+        span[ 0 ] = value;
+        this->commit( 1 );
+        return true;
+    }
+
+    bool pop( T& value ) {
+        auto span = this->read_span( 1 );
+        if( span.empty() ) return false;
+
+        value = std::move( const_cast< T& >( span[ 0 ] ) );
+        this->release( 1 );
+        return true;
+    }
+
+public:
+    /* Producer side. Blocks until count slots are free, or until poke(). Returns whether the slots are free. */
+    bool wait_space( size_t count ) {
+        uint32_t wakes = _tail_wakes.load( std::memory_order_acquire );
+        if( this->space() >= count ) return true;
+
+        _tail_wakes.wait( wakes, std::memory_order_acquire );
+        return this->space() >= count;
+    }
+
+    /* Consumer side. Blocks until count slots are filled, or until poke(). Returns whether the slots are filled. */
+    bool wait_size( size_t count ) {
+        uint32_t wakes = _head_wakes.load( std::memory_order_acquire );
+        if( this->size() >= count ) return true;
+
+        _head_wakes.wait( wakes, std::memory_order_acquire );
+        return this->size() >= count;
+    }
+
+    /* Wakes both ends out of their waits, e.g. during shutdown. */
+    void poke() {
+        _tail_wakes.fetch_add( 1, std::memory_order_release );
+        _tail_wakes.notify_all();
+        _head_wakes.fetch_add( 1, std::memory_order_release );
+        _head_wakes.notify_all();
+    }
+
+};
+
+
+
+/*
+Multiple producers, single consumer queue of fixed capacity, rounded up to a power of two. Every cell carries a 
+sequence number telling whose turn it is on it, so producers only race each other on claiming the head, and the
+consumer never waits on anyone. Pushing into a full queue fails, rather than waiting for the consumer.
+*/
+template< typename T >
+class MpscQueue {
+public:
+    MpscQueue() = default;
+
+    MpscQueue( size_t capacity ) {
+        this->reserve( capacity );
+    }
+
+    MpscQueue( const MpscQueue& ) = delete;
+    MpscQueue( MpscQueue&& ) = delete;
+
+_ENGINE_PROTECTED:
+    struct _Cell {
+        std::atomic< size_t >   seq     = { 0 };
+        T                       value   = {};
+    };
+
+_ENGINE_PROTECTED:
+    UPtr< _Cell[] >   _cells   = nullptr;
+    size_t            _mask    = 0;
+
+    alignas( LOCK_FREE_CACHE_LINE ) std::atomic< size_t >   _head   = { 0 };
+    alignas( LOCK_FREE_CACHE_LINE ) size_t                  _tail   = 0;
+
+public:
+    /* Not thread safe, both ends shall be idle. */
+    MpscQueue& reserve( size_t capacity ) {
+        capacity = std::bit_ceil( std::max< size_t >( capacity, 2 ) );
+
+        _cells.reset( new _Cell[ capacity ] );
+        _mask = capacity - 1;
+
+        for( size_t idx = 0; idx < capacity; ++idx )
+            _cells[ idx ].seq.store( idx, std::memory_order_relaxed );
+
+        _head.store( 0, std::memory_order_relaxed );
+        _tail = 0;
+
+        return *this;
+    }
+
+public:
+    size_t capacity() const { return _mask + 1; }
+
+    /* Consumer side. */
+    bool empty() const {
+        return _cells[ _tail & _mask ].seq.load( std::memory_order_acquire ) != _tail + 1;
+    }
+
+public:
+    /* Any thread. Returns false if the queue is full, value is then left untouched. */
+    bool push( T&& value ) {
+        size_t head = _head.load( std::memory_order_relaxed );
+
+        for(;;) {
+            _Cell&         cell = _cells[ head & _mask ];
+            const size_t   seq  = cell.seq.load( std::memory_order_acquire );
+            const intptr_t diff = ( intptr_t )seq - ( intptr_t )head;
+
+            if( diff == 0 ) {
+                if( _head.compare_exchange_weak( head, head + 1, std::memory_order_relaxed ) ) {
+                    cell.value = std::move( value );
+                    cell.seq.store( head + 1, std::memory_order_release );
+                    return true;
+                }
+            } else if( diff < 0 ) {
+                return false;
+            } else {
+                head = _head.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    bool push( const T& value ) {
+        T copy = value;
+        return this->push( std::move( copy ) );
+    }
+
+    /* Consumer side. */
+    bool pop( T& value ) {
+        _Cell& cell = _cells[ _tail & _mask ];
+
+        if( cell.seq.load( std::memory_order_acquire ) != _tail + 1 ) return false;
+
+        value = std::move( cell.value );
+        cell.seq.store( _tail + _mask + 1, std::memory_order_release );
+        ++_tail;
+
+        return true;
+    }
+
+};
+
+
+
+};
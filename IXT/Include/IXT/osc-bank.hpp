@@ -0,0 +1,572 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/comms.hpp>
+#include <IXT/audio.hpp>
+#include <IXT/lock-free.hpp>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+enum OSC_SHAPE : BYTE {
+    OSC_SHAPE_SINE   = 1 << 0,
+    OSC_SHAPE_SAW    = 1 << 1,
+    OSC_SHAPE_SQUARE = 1 << 2
+};
+
+/* Seconds, but for the sustain level. Linear segments, the release runs from wherever the note is let go. */
+struct OscEnvelope {
+    double   attack    = 0.005;
+    double   decay     = 0.1;
+    double   sustain   = 0.7;
+    double   release   = 0.2;
+};
+
+enum OSC_COMMAND : BYTE {
+    OSC_COMMAND_NOTE_ON,
+    OSC_COMMAND_NOTE_OFF,
+    OSC_COMMAND_NOTE_OFF_ALL
+};
+
+struct OscCommand {
+    OSC_COMMAND   op      = OSC_COMMAND_NOTE_ON;
+    OSC_SHAPE     shape   = OSC_SHAPE_SINE;
+    uint32_t      key     = 0;
+    double        freq    = 0.0;
+    double        amp     = 0.0;
+    OscEnvelope   env     = {};
+};
+
+
+/*
+Bank of oscillators playing as one wave, LANES voices side by side in SIMD lanes. Every voice runs a 32 bit phase
+accumulator, which wraps on its own and never drifts, however long the session. Sines come off a polynomial, saws and
+squares are band-limited with polyBLEP, and every voice goes through its own ADSR envelope.
+Voices are kept packed at the front, so a block costs as many lane groups as there are voices playing. Notes are
+commands like Audio's, posted from any thread and taken in by the mixing thread at the start of the next block.
+Voices are named by a key of the caller's choosing, e.g. a MIDI note, and letting go of a key releases all its voices.
+*/
+class OscBank : public Wave {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "OscBank" );
+
+public:
+    inline static constexpr size_t   LANES              = 8;
+    inline static constexpr size_t   COMMAND_CAPACITY   = 4096;
+
+public:
+    OscBank() = default;
+
+    OscBank(
+        HVEC< Audio >   audio,
+        size_t          capacity   = 1024,
+        _ENGINE_COMMS_ECHO_ARG
+    )
+    : Wave{ std::move( audio ) },
+      _capacity{ ( capacity + LANES - 1 ) / LANES * LANES }
+    {
+        _lanes.reset( new float[ _LANE_COUNT * _capacity ] );
+        _phase.reset( new uint32_t[ _capacity ] );
+        _inc.reset( new int32_t[ _capacity ] );
+        _keys.reset( new uint32_t[ _capacity ] );
+        _shapes.reset( new BYTE[ _capacity ] );
+
+        if( !_lanes || !_phase || !_inc || !_keys || !_shapes ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Voices bad alloc.";
+            _capacity = 0;
+            return;
+        }
+
+        for( size_t idx = 0; idx < _capacity; ++idx )
+            this->_clear( idx );
+
+        echo( this, ECHO_LEVEL_OK ) << "Created, " << _capacity << " voices, " << LANES << " per lane group.";
+    }
+
+    OscBank( const OscBank& ) = delete;
+    OscBank( OscBank&& ) = delete;
+
+    ~OscBank() {
+        this->_unvoice_wait();
+    }
+
+_ENGINE_PROTECTED:
+    enum _LANE : size_t {
+        _LANE_CPS,
+        _LANE_DT,
+        _LANE_INV_DT,
+        _LANE_AMP,
+        _LANE_LEVEL,
+        _LANE_STAGE,
+        _LANE_ATTACK,
+        _LANE_DECAY,
+        _LANE_SUSTAIN,
+        _LANE_RELEASE,
+        _LANE_RELEASE_STEP,
+        _LANE_SINE,
+        _LANE_SAW,
+        _LANE_SQUARE,
+
+        _LANE_COUNT
+    };
+
+    /* As floats, so that the lanes compare them in place. */
+    inline static constexpr float   _STAGE_OFF       = 0.0f;
+    inline static constexpr float   _STAGE_ATTACK    = 1.0f;
+    inline static constexpr float   _STAGE_DECAY     = 2.0f;
+    inline static constexpr float   _STAGE_SUSTAIN   = 3.0f;
+    inline static constexpr float   _STAGE_RELEASE   = 4.0f;
+
+_ENGINE_PROTECTED:
+    size_t                    _capacity        = 0;
+    size_t                    _count           = 0;
+
+    UPtr< float[] >           _lanes           = nullptr;
+    UPtr< uint32_t[] >        _phase           = nullptr;
+    UPtr< int32_t[] >         _inc             = nullptr;
+    UPtr< uint32_t[] >        _keys            = nullptr;
+    UPtr< BYTE[] >            _shapes          = nullptr;
+
+    std::vector< float >      _acc             = {};
+    double                    _one             = 0.0;
+
+    MpscQueue< OscCommand >   _commands        = { COMMAND_CAPACITY };
+    std::atomic< size_t >     _active          = 0;
+    std::atomic< size_t >     _refused_count   = 0;
+    std::atomic< size_t >     _dropped_count   = 0;
+
+    bool                      _stopping        = false;
+
+_ENGINE_PROTECTED:
+    float* _lane( _LANE lane ) {
+        return _lanes.get() + lane * _capacity;
+    }
+
+    /* Lanes past the last voice stay silent and idle, the groups run them all the same. */
+    void _clear( size_t idx ) {
+        for( size_t lane = 0; lane < _LANE_COUNT; ++lane )
+            _lanes[ lane * _capacity + idx ] = 0.0f;
+
+        _phase[ idx ]  = 0;
+        _inc[ idx ]    = 0;
+        _keys[ idx ]   = 0;
+        _shapes[ idx ] = 0;
+    }
+
+    void _move( size_t to, size_t from ) {
+        for( size_t lane = 0; lane < _LANE_COUNT; ++lane )
+            _lanes[ lane * _capacity + to ] = _lanes[ lane * _capacity + from ];
+
+        _phase[ to ]  = _phase[ from ];
+        _inc[ to ]    = _inc[ from ];
+        _keys[ to ]   = _keys[ from ];
+        _shapes[ to ] = _shapes[ from ];
+    }
+
+    void _release( size_t idx ) {
+        float& stage = this->_lane( _LANE_STAGE )[ idx ];
+        if( stage == _STAGE_OFF || stage == _STAGE_RELEASE ) return;
+
+        const float level = this->_lane( _LANE_LEVEL )[ idx ];
+        const float secs  = this->_lane( _LANE_RELEASE )[ idx ];
+
+        stage = _STAGE_RELEASE;
+        this->_lane( _LANE_RELEASE_STEP )[ idx ] = secs > 0.0f ? level / ( secs * _audio->sample_rate() ) : level;
+    }
+
+    void _note_on( const OscCommand& cmd ) {
+        if( _count == _capacity ) {
+            _refused_count.fetch_add( 1, std::memory_order_relaxed );
+            return;
+        }
+
+        const size_t idx = _count++;
+        const double sr  = _audio->sample_rate();
+
+        auto step_of = [ sr ] ( double secs, double span ) -> float {
+            return secs > 0.0 ? span / ( secs * sr ) : span;
+        };
+
+        this->_lane( _LANE_CPS )[ idx ]     = cmd.freq / sr;
+        this->_lane( _LANE_AMP )[ idx ]     = cmd.amp;
+        this->_lane( _LANE_LEVEL )[ idx ]   = 0.0f;
+        this->_lane( _LANE_STAGE )[ idx ]   = _STAGE_ATTACK;
+        this->_lane( _LANE_ATTACK )[ idx ]  = step_of( cmd.env.attack, 1.0 );
+        this->_lane( _LANE_DECAY )[ idx ]   = step_of( cmd.env.decay, 1.0 - std::clamp( cmd.env.sustain, 0.0, 1.0 ) );
+        this->_lane( _LANE_SUSTAIN )[ idx ] = std::clamp( cmd.env.sustain, 0.0, 1.0 );
+        this->_lane( _LANE_RELEASE )[ idx ] = std::max( cmd.env.release, 0.0 );
+        this->_lane( _LANE_SINE )[ idx ]    = cmd.shape == OSC_SHAPE_SINE;
+        this->_lane( _LANE_SAW )[ idx ]     = cmd.shape == OSC_SHAPE_SAW;
+        this->_lane( _LANE_SQUARE )[ idx ]  = cmd.shape == OSC_SHAPE_SQUARE;
+
+        _phase[ idx ]  = 0;
+        _keys[ idx ]   = cmd.key;
+        _shapes[ idx ] = cmd.shape;
+    }
+
+    /* Mixing thread. */
+    void _run_commands() {
+        for( OscCommand cmd; _commands.pop( cmd ); ) {
+            switch( cmd.op ) {
+                case OSC_COMMAND_NOTE_ON: {
+                    this->_note_on( cmd );
+                break; }
+
+                case OSC_COMMAND_NOTE_OFF: {
+                    for( size_t idx = 0; idx < _count; ++idx )
+                        if( _keys[ idx ] == cmd.key ) this->_release( idx );
+                break; }
+
+                case OSC_COMMAND_NOTE_OFF_ALL: {
+                    for( size_t idx = 0; idx < _count; ++idx )
+                        this->_release( idx );
+                break; }
+            }
+        }
+    }
+
+    /* Phase steps for this block, the velocities scaling the pitch. Past Nyquist is clamped, it would alias anyway. */
+    void _prepare( double velocity ) {
+        float* cps    = this->_lane( _LANE_CPS );
+        float* dt     = this->_lane( _LANE_DT );
+        float* inv_dt = this->_lane( _LANE_INV_DT );
+
+        for( size_t idx = 0; idx < _count; ++idx ) {
+            const double inc = std::clamp( cps[ idx ] * velocity, -0.49, 0.49 );
+
+            _inc[ idx ]    = ( int32_t )std::lround( inc * 4294967296.0 );
+            dt[ idx ]      = std::abs( inc );
+            inv_dt[ idx ]  = dt[ idx ] > 0.0f ? 1.0f / dt[ idx ] : 0.0f;
+        }
+    }
+
+    /* Packs the voices that ran out to the back. Their order does not matter, they are named by key. */
+    void _sweep() {
+        const float* stage = this->_lane( _LANE_STAGE );
+
+        for( size_t idx = 0; idx < _count; ) {
+            if( stage[ idx ] != _STAGE_OFF ) { ++idx; continue; }
+
+            if( idx != --_count ) this->_move( idx, _count );
+            this->_clear( _count );
+        }
+    }
+
+_ENGINE_PROTECTED:
+    /* sin( 2pi * p ), p in [ 0, 1 ). Folded onto [ -1/4, 1/4 ] turns, then odd Taylor to the 9th, off by 4e-6 at most. */
+    static float _sine( float p ) {
+        float x = p - 0.5f;
+
+        if( x > 0.25f ) x = 0.5f - x;
+        else if( x < -0.25f ) x = -0.5f - x;
+
+        const float x2 = x * x;
+        return -x * ( 6.2831853f + x2 * ( -41.341702f + x2 * ( 81.605249f + x2 * ( -76.705859f + x2 * 42.058694f ) ) ) );
+    }
+
+    /* Residual of a unit step at phase 0, over one phase step each side. */
+    static float _blep( float t, float dt, float inv_dt ) {
+        if( t < dt ) { t *= inv_dt; return t + t - t * t - 1.0f; }
+        if( t > 1.0f - dt ) { t = ( t - 1.0f ) * inv_dt; return t * t + t + t + 1.0f; }
+        return 0.0f;
+    }
+
+    static float _frac( float p ) {
+        return p - ( int )p;
+    }
+
+    /* One lane group, frames in a row, each lane adding its samples into acc[ frame * LANES + lane ]. */
+    void _render_group( size_t base, float* acc, size_t frames, BYTE shapes ) {
+        for( size_t lane = 0; lane < LANES; ++lane ) {
+            const size_t idx = base + lane;
+
+            uint32_t phase = _phase[ idx ];
+            float    level = this->_lane( _LANE_LEVEL )[ idx ];
+            float    stage = this->_lane( _LANE_STAGE )[ idx ];
+
+            const int32_t inc      = _inc[ idx ];
+            const float   dt       = this->_lane( _LANE_DT )[ idx ];
+            const float   inv_dt   = this->_lane( _LANE_INV_DT )[ idx ];
+            const float   amp      = this->_lane( _LANE_AMP )[ idx ];
+            const float   attack   = this->_lane( _LANE_ATTACK )[ idx ];
+            const float   decay    = this->_lane( _LANE_DECAY )[ idx ];
+            const float   sustain  = this->_lane( _LANE_SUSTAIN )[ idx ];
+            const float   release  = this->_lane( _LANE_RELEASE_STEP )[ idx ];
+            const float   w_sine   = this->_lane( _LANE_SINE )[ idx ];
+            const float   w_saw    = this->_lane( _LANE_SAW )[ idx ];
+            const float   w_square = this->_lane( _LANE_SQUARE )[ idx ];
+
+            if( stage == _STAGE_OFF ) continue;
+
+            for( size_t frame = 0; frame < frames; ++frame ) {
+                const float p    = ( phase >> 8 ) * ( 1.0f / 16777216.0f );
+                float       wave = 0.0f;
+
+                if( shapes & OSC_SHAPE_SINE )
+                    wave += w_sine * _sine( p );
+
+                if( shapes & ( OSC_SHAPE_SAW | OSC_SHAPE_SQUARE ) ) {
+                    const float blep = _blep( p, dt, inv_dt );
+
+                    if( shapes & OSC_SHAPE_SAW )
+                        wave += w_saw * ( p + p - 1.0f - blep );
+
+                    if( shapes & OSC_SHAPE_SQUARE )
+                        wave += w_square * ( ( p < 0.5f ? 1.0f : -1.0f ) + blep - _blep( _frac( p + 0.5f ), dt, inv_dt ) );
+                }
+
+                if( stage == _STAGE_ATTACK ) {
+                    if( ( level += attack ) >= 1.0f ) { level = 1.0f; stage = _STAGE_DECAY; }
+                } else if( stage == _STAGE_DECAY ) {
+                    if( ( level -= decay ) <= sustain ) { level = sustain; stage = _STAGE_SUSTAIN; }
+                } else if( stage == _STAGE_RELEASE ) {
+                    if( ( level -= release ) <= 0.0f ) { level = 0.0f; stage = _STAGE_OFF; }
+                }
+
+                acc[ frame * LANES + lane ] += amp * level * wave;
+                phase += ( uint32_t )inc;
+            }
+
+            _phase[ idx ] = phase;
+            this->_lane( _LANE_LEVEL )[ idx ] = level;
+            this->_lane( _LANE_STAGE )[ idx ] = stage;
+        }
+    }
+
+#if defined( _ENGINE_AVX )
+    static __m256 _sine( __m256 p ) {
+        const __m256 quarter = _mm256_set1_ps( 0.25f );
+        const __m256 half    = _mm256_set1_ps( 0.5f );
+
+        __m256 x = _mm256_sub_ps( p, half );
+        x = _mm256_blendv_ps( x, _mm256_sub_ps( half, x ), _mm256_cmp_ps( x, quarter, _CMP_GT_OQ ) );
+        x = _mm256_blendv_ps( x, _mm256_sub_ps( _mm256_setzero_ps(), _mm256_add_ps( half, x ) ), _mm256_cmp_ps( x, _mm256_sub_ps( _mm256_setzero_ps(), quarter ), _CMP_LT_OQ ) );
+
+        const __m256 x2 = _mm256_mul_ps( x, x );
+
+        __m256 poly = _mm256_set1_ps( 42.058694f );
+        poly = _mm256_add_ps( _mm256_set1_ps( -76.705859f ), _mm256_mul_ps( x2, poly ) );
+        poly = _mm256_add_ps( _mm256_set1_ps( 81.605249f ), _mm256_mul_ps( x2, poly ) );
+        poly = _mm256_add_ps( _mm256_set1_ps( -41.341702f ), _mm256_mul_ps( x2, poly ) );
+        poly = _mm256_add_ps( _mm256_set1_ps( 6.2831853f ), _mm256_mul_ps( x2, poly ) );
+
+        return _mm256_mul_ps( _mm256_sub_ps( _mm256_setzero_ps(), x ), poly );
+    }
+
+    static __m256 _blep( __m256 t, __m256 dt, __m256 inv_dt ) {
+        const __m256 one = _mm256_set1_ps( 1.0f );
+
+        const __m256 u = _mm256_mul_ps( t, inv_dt );
+        const __m256 v = _mm256_mul_ps( _mm256_sub_ps( t, one ), inv_dt );
+
+        const __m256 rise = _mm256_sub_ps( _mm256_sub_ps( _mm256_add_ps( u, u ), _mm256_mul_ps( u, u ) ), one );
+        const __m256 fall = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( v, v ), _mm256_add_ps( v, v ) ), one );
+
+        __m256 r = _mm256_and_ps( fall, _mm256_cmp_ps( t, _mm256_sub_ps( one, dt ), _CMP_GT_OQ ) );
+        return _mm256_blendv_ps( r, rise, _mm256_cmp_ps( t, dt, _CMP_LT_OQ ) );
+    }
+
+    /* _render_group(), the lanes in one register each. */
+    void _render_group_avx( size_t base, float* acc, size_t frames, BYTE shapes ) {
+        auto lane_of = [ this, base ] ( _LANE lane ) -> __m256 { return _mm256_loadu_ps( this->_lane( lane ) + base ); };
+
+        __m256i phase = _mm256_loadu_si256( ( const __m256i* )( _phase.get() + base ) );
+        __m256  level = lane_of( _LANE_LEVEL );
+        __m256  stage = lane_of( _LANE_STAGE );
+
+        const __m256i inc      = _mm256_loadu_si256( ( const __m256i* )( _inc.get() + base ) );
+        const __m256  dt       = lane_of( _LANE_DT );
+        const __m256  inv_dt   = lane_of( _LANE_INV_DT );
+        const __m256  amp      = lane_of( _LANE_AMP );
+        const __m256  attack   = lane_of( _LANE_ATTACK );
+        const __m256  decay    = _mm256_sub_ps( _mm256_setzero_ps(), lane_of( _LANE_DECAY ) );
+        const __m256  sustain  = lane_of( _LANE_SUSTAIN );
+        const __m256  release  = _mm256_sub_ps( _mm256_setzero_ps(), lane_of( _LANE_RELEASE_STEP ) );
+        const __m256  w_sine   = lane_of( _LANE_SINE );
+        const __m256  w_saw    = lane_of( _LANE_SAW );
+        const __m256  w_square = lane_of( _LANE_SQUARE );
+
+        const __m256  zero     = _mm256_setzero_ps();
+        const __m256  one      = _mm256_set1_ps( 1.0f );
+        const __m256  half     = _mm256_set1_ps( 0.5f );
+        const __m256  to_unit  = _mm256_set1_ps( 1.0f / 16777216.0f );
+
+        const __m256  s_attack  = _mm256_set1_ps( _STAGE_ATTACK );
+        const __m256  s_decay   = _mm256_set1_ps( _STAGE_DECAY );
+        const __m256  s_sustain = _mm256_set1_ps( _STAGE_SUSTAIN );
+        const __m256  s_release = _mm256_set1_ps( _STAGE_RELEASE );
+
+        for( size_t frame = 0; frame < frames; ++frame ) {
+            const __m256 p    = _mm256_mul_ps( _mm256_cvtepi32_ps( _mm256_srli_epi32( phase, 8 ) ), to_unit );
+            __m256       wave = zero;
+
+            if( shapes & OSC_SHAPE_SINE )
+                wave = _mm256_add_ps( wave, _mm256_mul_ps( w_sine, _sine( p ) ) );
+
+            if( shapes & ( OSC_SHAPE_SAW | OSC_SHAPE_SQUARE ) ) {
+                const __m256 blep = _blep( p, dt, inv_dt );
+
+                if( shapes & OSC_SHAPE_SAW )
+                    wave = _mm256_add_ps( wave, _mm256_mul_ps( w_saw, _mm256_sub_ps( _mm256_sub_ps( _mm256_add_ps( p, p ), one ), blep ) ) );
+
+                if( shapes & OSC_SHAPE_SQUARE ) {
+                    __m256 q = _mm256_add_ps( p, half );
+                    q = _mm256_sub_ps( q, _mm256_and_ps( one, _mm256_cmp_ps( q, one, _CMP_GE_OQ ) ) );
+
+                    const __m256 edge = _mm256_blendv_ps( _mm256_sub_ps( zero, one ), one, _mm256_cmp_ps( p, half, _CMP_LT_OQ ) );
+                    wave = _mm256_add_ps( wave, _mm256_mul_ps( w_square, _mm256_sub_ps( _mm256_add_ps( edge, blep ), _blep( q, dt, inv_dt ) ) ) );
+                }
+            }
+
+            const __m256 in_attack  = _mm256_cmp_ps( stage, s_attack, _CMP_EQ_OQ );
+            const __m256 in_decay   = _mm256_cmp_ps( stage, s_decay, _CMP_EQ_OQ );
+            const __m256 in_release = _mm256_cmp_ps( stage, s_release, _CMP_EQ_OQ );
+
+            level = _mm256_add_ps( level, _mm256_or_ps(
+                _mm256_and_ps( in_attack, attack ),
+                _mm256_or_ps( _mm256_and_ps( in_decay, decay ), _mm256_and_ps( in_release, release ) )
+            ) );
+
+            const __m256 attack_done  = _mm256_and_ps( in_attack, _mm256_cmp_ps( level, one, _CMP_GE_OQ ) );
+            const __m256 decay_done   = _mm256_and_ps( in_decay, _mm256_cmp_ps( level, sustain, _CMP_LE_OQ ) );
+            const __m256 release_done = _mm256_and_ps( in_release, _mm256_cmp_ps( level, zero, _CMP_LE_OQ ) );
+
+            level = _mm256_blendv_ps( level, one, attack_done );
+            level = _mm256_blendv_ps( level, sustain, decay_done );
+            level = _mm256_blendv_ps( level, zero, release_done );
+
+            stage = _mm256_blendv_ps( stage, s_decay, attack_done );
+            stage = _mm256_blendv_ps( stage, s_sustain, decay_done );
+            stage = _mm256_blendv_ps( stage, zero, release_done );
+
+            float* at = acc + frame * LANES;
+            _mm256_storeu_ps( at, _mm256_add_ps( _mm256_loadu_ps( at ), _mm256_mul_ps( _mm256_mul_ps( amp, level ), wave ) ) );
+
+            phase = _mm256_add_epi32( phase, inc );
+        }
+
+        _mm256_storeu_si256( ( __m256i* )( _phase.get() + base ), phase );
+        _mm256_storeu_ps( this->_lane( _LANE_LEVEL ) + base, level );
+        _mm256_storeu_ps( this->_lane( _LANE_STAGE ) + base, stage );
+    }
+#endif
+
+    void _render( double* out, size_t frames, WORD tunnels ) {
+        _acc.assign( frames * LANES, 0.0f );
+
+        for( size_t base = 0; base < _count; base += LANES ) {
+            BYTE shapes = 0;
+            for( size_t idx = base; idx < base + LANES; ++idx ) shapes |= _shapes[ idx ];
+
+        #if defined( _ENGINE_AVX )
+            this->_render_group_avx( base, _acc.data(), frames, shapes );
+        #else
+            this->_render_group( base, _acc.data(), frames, shapes );
+        #endif
+        }
+
+        const double gain = _volume * !_muted;
+
+        for( size_t frame = 0; frame < frames; ++frame ) {
+            const float* at  = _acc.data() + frame * LANES;
+            float        sum = 0.0f;
+
+            for( size_t lane = 0; lane < LANES; ++lane ) sum += at[ lane ];
+
+            for( WORD tunnel = 0; tunnel < tunnels; ++tunnel )
+                *out++ += sum * gain;
+        }
+    }
+
+public:
+    virtual bool done() const override {
+        return _stopping && _count == 0;
+    }
+
+_ENGINE_PROTECTED:
+    virtual void _set() override {
+        _stopping = false;
+    }
+
+    /* Releases every voice, the bank is done once they ran out. */
+    virtual void _stop() override {
+        _stopping = true;
+
+        for( size_t idx = 0; idx < _count; ++idx )
+            this->_release( idx );
+    }
+
+public:
+    virtual void render_block( double* out, size_t frames, WORD tunnels, [[maybe_unused]] double t0 ) override {
+        this->_run_commands();
+
+        if( _paused || _count == 0 ) return;
+
+        this->_prepare( _velocity * _audio->velocity() );
+        this->_render( out, frames, tunnels );
+        this->_sweep();
+
+        _active.store( _count, std::memory_order_relaxed );
+    }
+
+_ENGINE_PROTECTED:
+    /* A frame per first tunnel, repeated over the others. The mixer goes through render_block() instead. */
+    virtual double _sample( double elapsed, WORD tunnel, bool tunnel_end ) override {
+        if( tunnel == 0 ) {
+            _one = 0.0;
+            this->render_block( &_one, 1, 1, elapsed );
+        }
+
+        return _one;
+    }
+
+public:
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    /* As of the last block. */
+    size_t active_count() const {
+        return _active.load( std::memory_order_relaxed );
+    }
+
+    /* Notes refused for lack of a free voice, so far. */
+    size_t refused_count() const {
+        return _refused_count.load( std::memory_order_relaxed );
+    }
+
+    /* Commands dropped on a full queue, so far. */
+    size_t dropped_count() const {
+        return _dropped_count.load( std::memory_order_relaxed );
+    }
+
+public:
+    /* Any thread. Lands at the start of the next block. */
+    OscBank& note_on( uint32_t key, OSC_SHAPE shape, double freq, double amp = 0.1, const OscEnvelope& env = {} ) {
+        return this->_post( OscCommand{ op: OSC_COMMAND_NOTE_ON, shape: shape, key: key, freq: freq, amp: amp, env: env } );
+    }
+
+    OscBank& note_off( uint32_t key ) {
+        return this->_post( OscCommand{ op: OSC_COMMAND_NOTE_OFF, key: key } );
+    }
+
+    OscBank& note_off_all() {
+        return this->_post( OscCommand{ op: OSC_COMMAND_NOTE_OFF_ALL } );
+    }
+
+_ENGINE_PROTECTED:
+    OscBank& _post( OscCommand&& cmd ) {
+        if( !_commands.push( std::move( cmd ) ) )
+            _dropped_count.fetch_add( 1, std::memory_order_relaxed );
+
+        return *this;
+    }
+
+};
+
+
+
+};
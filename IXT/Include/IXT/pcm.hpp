@@ -0,0 +1,285 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+enum PCM_FMT : BYTE {
+    PCM_FMT_U8  = 0,
+    PCM_FMT_S16 = 1,
+    PCM_FMT_S24 = 2,
+    PCM_FMT_S32 = 3,
+    PCM_FMT_F32 = 4,
+
+    _PCM_FMT_COUNT
+};
+
+inline constexpr BYTE PCM_FMT_BYTES[ _PCM_FMT_COUNT ] = { 1, 2, 3, 4, 4 };
+
+/*
+Bulk conversions between packed little endian PCM and float/double, normalized to [ -1, 1 ).
+Integer formats decode as sample / 2^( bits - 1 ) and encode with clamping to the format's range.
+With IXT_AVX the bodies run in 256 or 512 bit lanes and the tails fall through to the scalar loops.
+*/
+class Pcm {
+public:
+    static PCM_FMT fmt_of( uint16_t bits_per_sample, bool is_float ) {
+        if( is_float ) return PCM_FMT_F32;
+
+        switch( bits_per_sample ) {
+            case 8:  return PCM_FMT_U8;
+            case 16: return PCM_FMT_S16;
+            case 24: return PCM_FMT_S24;
+            default: return PCM_FMT_S32;
+        }
+    }
+
+    template< typename T >
+    static constexpr T scale_of( PCM_FMT fmt ) {
+        switch( fmt ) {
+            case PCM_FMT_U8:  return T{ 1 } / T{ 128 };
+            case PCM_FMT_S16: return T{ 1 } / T{ 32768 };
+            case PCM_FMT_S24: return T{ 1 } / T{ 8388608 };
+            case PCM_FMT_S32: return T{ 1 } / T{ 2147483648.0 };
+            default:          return T{ 1 };
+        }
+    }
+
+public:
+    /* Single sample decode, for on-the-fly readers. */
+    template< typename T > requires std::is_floating_point_v< T >
+    static T decode_one( const void* src, PCM_FMT fmt ) {
+        const ubyte_t* p = ( const ubyte_t* )src;
+
+        switch( fmt ) {
+            case PCM_FMT_U8:  return static_cast< T >( static_cast< int >( p[ 0 ] ) - 128 ) * scale_of< T >( fmt );
+            case PCM_FMT_S16: { int16_t v; memcpy( &v, p, 2 ); return static_cast< T >( v ) * scale_of< T >( fmt ); }
+            case PCM_FMT_S24: return static_cast< T >(
+                                  static_cast< int32_t >( ( udword_t )p[ 0 ] << 8 | ( udword_t )p[ 1 ] << 16 | ( udword_t )p[ 2 ] << 24 ) >> 8
+                              ) * scale_of< T >( fmt );
+            case PCM_FMT_S32: { int32_t v; memcpy( &v, p, 4 ); return static_cast< T >( v ) * scale_of< T >( fmt ); }
+            case PCM_FMT_F32: { float v; memcpy( &v, p, 4 ); return static_cast< T >( v ); }
+            default:          return T{ 0 };
+        }
+    }
+
+    template< typename T > requires std::is_floating_point_v< T >
+    static void decode( const void* src, T* dst, size_t count, PCM_FMT fmt ) {
+        const ubyte_t* p = ( const ubyte_t* )src;
+        size_t         n = _decode_simd( p, dst, count, fmt );
+
+        p += n * PCM_FMT_BYTES[ fmt ];
+
+        for( ; n < count; ++n, p += PCM_FMT_BYTES[ fmt ] )
+            dst[ n ] = decode_one< T >( p, fmt );
+    }
+
+    template< typename T > requires std::is_floating_point_v< T >
+    static void encode( const T* src, void* dst, size_t count, PCM_FMT fmt ) {
+        ubyte_t* p = ( ubyte_t* )dst;
+        size_t   n = _encode_simd( src, p, count, fmt );
+
+        p += n * PCM_FMT_BYTES[ fmt ];
+
+        for( ; n < count; ++n, p += PCM_FMT_BYTES[ fmt ] )
+            _encode_one( src[ n ], p, fmt );
+    }
+
+_ENGINE_PROTECTED:
+    template< typename T >
+    static void _encode_one( T x, ubyte_t* p, PCM_FMT fmt ) {
+        if( fmt == PCM_FMT_F32 ) {
+            float v = static_cast< float >( x ); memcpy( p, &v, 4 );
+            return;
+        }
+
+        const double max = 1.0 / scale_of< double >( fmt );
+        const double v   = std::clamp( std::nearbyint( static_cast< double >( x ) * max ), -max, max - 1.0 );
+        const int32_t q  = static_cast< int32_t >( v );
+
+        switch( fmt ) {
+            case PCM_FMT_U8:  p[ 0 ] = static_cast< ubyte_t >( q + 128 ); break;
+            case PCM_FMT_S16: { int16_t w = q; memcpy( p, &w, 2 ); break; }
+            case PCM_FMT_S24: p[ 0 ] = q & 0xFF; p[ 1 ] = ( q >> 8 ) & 0xFF; p[ 2 ] = ( q >> 16 ) & 0xFF; break;
+            case PCM_FMT_S32: memcpy( p, &q, 4 ); break;
+            default: break;
+        }
+    }
+
+#if defined( _ENGINE_AVX )
+_ENGINE_PROTECTED:
+    /* Eight sign extended ( or, for U8, unbiased ) integer samples. */
+    static __m256i _load_epi32x8( const ubyte_t* p, PCM_FMT fmt ) {
+        switch( fmt ) {
+            case PCM_FMT_U8:  return _mm256_sub_epi32( _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i* )p ) ), _mm256_set1_epi32( 128 ) );
+            case PCM_FMT_S16: return _mm256_cvtepi16_epi32( _mm_loadu_si128( ( const __m128i* )p ) );
+            case PCM_FMT_S24: {
+                const __m256i shf = _mm256_setr_epi8(
+                    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                    -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11
+                );
+                __m256i raw = _mm256_set_m128i( _mm_loadu_si128( ( const __m128i* )( p + 12 ) ), _mm_loadu_si128( ( const __m128i* )p ) );
+                return _mm256_srai_epi32( _mm256_shuffle_epi8( raw, shf ), 8 );
+            }
+            default:          return _mm256_loadu_si256( ( const __m256i* )p );
+        }
+    }
+
+    /* The 24 bit loader reads 4 bytes past the 8 samples it decodes. */
+    static size_t _simd_safe_count( size_t count, PCM_FMT fmt, size_t lanes ) {
+        if( fmt != PCM_FMT_S24 ) return count - count % lanes;
+
+        size_t safe = count > 2 ? count - 2 : 0;
+        return safe - safe % lanes;
+    }
+
+    template< typename T >
+    static size_t _decode_simd( const ubyte_t* p, T* dst, size_t count, PCM_FMT fmt ) {
+        const BYTE bps = PCM_FMT_BYTES[ fmt ];
+        size_t     n   = 0;
+
+    #if _ENGINE_AVX == 512
+        if( fmt != PCM_FMT_S24 ) {
+            const size_t end = count - count % 16;
+
+            for( ; n < end; n += 16, p += 16 * bps ) {
+                __m512i i32;
+
+                switch( fmt ) {
+                    case PCM_FMT_U8:  i32 = _mm512_sub_epi32( _mm512_cvtepu8_epi32( _mm_loadu_si128( ( const __m128i* )p ) ), _mm512_set1_epi32( 128 ) ); break;
+                    case PCM_FMT_S16: i32 = _mm512_cvtepi16_epi32( _mm256_loadu_si256( ( const __m256i* )p ) ); break;
+                    default:          i32 = _mm512_loadu_si512( p ); break;
+                }
+
+                if constexpr( std::is_same_v< T, float > ) {
+                    __m512 v = fmt == PCM_FMT_F32
+                               ? _mm512_castsi512_ps( i32 )
+                               : _mm512_mul_ps( _mm512_cvtepi32_ps( i32 ), _mm512_set1_ps( scale_of< float >( fmt ) ) );
+                    _mm512_storeu_ps( dst + n, v );
+                } else {
+                    if( fmt == PCM_FMT_F32 ) {
+                        _mm512_storeu_pd( dst + n,     _mm512_cvtps_pd( _mm512_castps512_ps256( _mm512_castsi512_ps( i32 ) ) ) );
+                        _mm512_storeu_pd( dst + n + 8, _mm512_cvtps_pd( _mm256_castsi256_ps( _mm512_extracti64x4_epi64( i32, 1 ) ) ) );
+                    } else {
+                        const __m512d scale = _mm512_set1_pd( scale_of< double >( fmt ) );
+                        _mm512_storeu_pd( dst + n,     _mm512_mul_pd( _mm512_cvtepi32_pd( _mm512_castsi512_si256( i32 ) ), scale ) );
+                        _mm512_storeu_pd( dst + n + 8, _mm512_mul_pd( _mm512_cvtepi32_pd( _mm512_extracti64x4_epi64( i32, 1 ) ), scale ) );
+                    }
+                }
+            }
+
+            return n;
+        }
+    #endif
+
+        const size_t end = _simd_safe_count( count, fmt, 8 );
+
+        for( ; n < end; n += 8, p += 8 * bps ) {
+            if constexpr( std::is_same_v< T, float > ) {
+                __m256 v = fmt == PCM_FMT_F32
+                           ? _mm256_loadu_ps( ( const float* )p )
+                           : _mm256_mul_ps( _mm256_cvtepi32_ps( _load_epi32x8( p, fmt ) ), _mm256_set1_ps( scale_of< float >( fmt ) ) );
+                _mm256_storeu_ps( dst + n, v );
+            } else {
+                if( fmt == PCM_FMT_F32 ) {
+                    __m256 v = _mm256_loadu_ps( ( const float* )p );
+                    _mm256_storeu_pd( dst + n,     _mm256_cvtps_pd( _mm256_castps256_ps128( v ) ) );
+                    _mm256_storeu_pd( dst + n + 4, _mm256_cvtps_pd( _mm256_extractf128_ps( v, 1 ) ) );
+                } else {
+                    const __m256d scale = _mm256_set1_pd( scale_of< double >( fmt ) );
+                    __m256i       i32   = _load_epi32x8( p, fmt );
+                    _mm256_storeu_pd( dst + n,     _mm256_mul_pd( _mm256_cvtepi32_pd( _mm256_castsi256_si128( i32 ) ), scale ) );
+                    _mm256_storeu_pd( dst + n + 4, _mm256_mul_pd( _mm256_cvtepi32_pd( _mm256_extracti128_si256( i32, 1 ) ), scale ) );
+                }
+            }
+        }
+
+        return n;
+    }
+
+    /* Eight rounded, clamped integer samples of fmt's range. */
+    template< typename T >
+    static __m256i _quantize_epi32x8( const T* src, PCM_FMT fmt ) {
+        const double max = 1.0 / scale_of< double >( fmt );
+
+        if constexpr( std::is_same_v< T, float > ) {
+            /* S32 cannot be reached exactly in float, clamp under 2^31 instead. */
+            const __m256 hi = _mm256_set1_ps( fmt == PCM_FMT_S32 ? 2147483520.0f : static_cast< float >( max - 1.0 ) );
+            const __m256 lo = _mm256_set1_ps( static_cast< float >( -max ) );
+            __m256 v = _mm256_mul_ps( _mm256_loadu_ps( src ), _mm256_set1_ps( static_cast< float >( max ) ) );
+            return _mm256_cvtps_epi32( _mm256_min_ps( _mm256_max_ps( v, lo ), hi ) );
+        } else {
+            const __m256d hi = _mm256_set1_pd( max - 1.0 );
+            const __m256d lo = _mm256_set1_pd( -max );
+            const __m256d m  = _mm256_set1_pd( max );
+            __m128i a = _mm256_cvtpd_epi32( _mm256_min_pd( _mm256_max_pd( _mm256_mul_pd( _mm256_loadu_pd( src ), m ), lo ), hi ) );
+            __m128i b = _mm256_cvtpd_epi32( _mm256_min_pd( _mm256_max_pd( _mm256_mul_pd( _mm256_loadu_pd( src + 4 ), m ), lo ), hi ) );
+            return _mm256_set_m128i( b, a );
+        }
+    }
+
+    template< typename T >
+    static size_t _encode_simd( const T* src, ubyte_t* p, size_t count, PCM_FMT fmt ) {
+        const BYTE   bps = PCM_FMT_BYTES[ fmt ];
+        const size_t end = count - count % 8;
+        size_t       n   = 0;
+
+        for( ; n < end; n += 8, p += 8 * bps ) {
+            if( fmt == PCM_FMT_F32 ) {
+                if constexpr( std::is_same_v< T, float > )
+                    _mm256_storeu_ps( ( float* )p, _mm256_loadu_ps( src + n ) );
+                else
+                    _mm256_storeu_ps( ( float* )p, _mm256_set_m128( _mm256_cvtpd_ps( _mm256_loadu_pd( src + n + 4 ) ), _mm256_cvtpd_ps( _mm256_loadu_pd( src + n ) ) ) );
+                continue;
+            }
+
+            __m256i i32 = _quantize_epi32x8( src + n, fmt );
+
+            switch( fmt ) {
+                case PCM_FMT_U8: {
+                    __m128i w = _mm_packs_epi32( _mm256_castsi256_si128( i32 ), _mm256_extracti128_si256( i32, 1 ) );
+                    w = _mm_add_epi16( w, _mm_set1_epi16( 128 ) );
+                    _mm_storel_epi64( ( __m128i* )p, _mm_packus_epi16( w, w ) );
+                break; }
+
+                case PCM_FMT_S16:
+                    _mm_storeu_si128( ( __m128i* )p, _mm_packs_epi32( _mm256_castsi256_si128( i32 ), _mm256_extracti128_si256( i32, 1 ) ) );
+                break;
+
+                case PCM_FMT_S24: {
+                    const __m256i shf = _mm256_setr_epi8(
+                        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1
+                    );
+                    alignas( 32 ) ubyte_t packed[ 32 ];
+                    _mm256_store_si256( ( __m256i* )packed, _mm256_shuffle_epi8( i32, shf ) );
+                    memcpy( p, packed, 12 );
+                    memcpy( p + 12, packed + 16, 12 );
+                break; }
+
+                default:
+                    _mm256_storeu_si256( ( __m256i* )p, i32 );
+                break;
+            }
+        }
+
+        return n;
+    }
+#else
+_ENGINE_PROTECTED:
+    template< typename T >
+    static size_t _decode_simd( const ubyte_t*, T*, size_t, PCM_FMT ) { return 0; }
+
+    template< typename T >
+    static size_t _encode_simd( const T*, ubyte_t*, size_t, PCM_FMT ) { return 0; }
+#endif
+
+};
+
+
+
+};
@@ -0,0 +1,353 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/comms.hpp>
+#include <IXT/lock-free.hpp>
+#include <IXT/tempo.hpp>
+
+
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+/* Nanoseconds since the profiler came up. Children land before their parents, as zones close inside out. */
+struct ProfileZoneEvent {
+    const char*   name    = nullptr;
+    uint64_t      begin   = 0;
+    uint64_t      end     = 0;
+    uint32_t      depth   = 0;
+    uint32_t      tid     = 0;
+};
+
+/* Microseconds. */
+struct ProfileZoneStats {
+    std::string   name    = {};
+    size_t        count   = 0;
+    double        total   = 0.0;
+    double        min     = 0.0;
+    double        avg     = 0.0;
+    double        p99     = 0.0;
+    double        max     = 0.0;
+};
+
+
+/*
+Scoped zone profiler. Every thread closing a zone owns a ring the zone lands in, so recording is a clock read
+and a ring push, no locks. A collector thread drains the rings every COLLECT_PERIOD into per zone durations and
+into the trace. When a ring is full the zone is dropped and counted, rather than stalling the thread.
+Zones are meant to be placed through IXT_ZONE, which compiles away unless built with IXT_PROFILE.
+*/
+class Profiler : public Descriptor {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "Profiler" );
+
+public:
+    inline static constexpr size_t                      RING_CAPACITY    = 1 << 14;
+    inline static constexpr size_t                      TRACE_CAPACITY   = 1 << 20;
+    inline static constexpr std::chrono::milliseconds   COLLECT_PERIOD   = std::chrono::milliseconds{ 20 };
+
+_ENGINE_PROTECTED:
+    struct _ThreadLog {
+        _ThreadLog( uint32_t tid ) : ring{ RING_CAPACITY }, tid{ tid } {}
+
+        SpscRing< ProfileZoneEvent >   ring      ;
+        uint32_t                       tid       = 0;
+        uint32_t                       depth     = 0;
+        std::atomic< size_t >          dropped   = { 0 };
+        std::atomic< bool >            retired   = { false };
+    };
+
+    /* Flags the log once its thread is gone, the collector drains and drops it. */
+    struct _LogHandle {
+        SPtr< _ThreadLog >   log   = nullptr;
+
+        ~_LogHandle() { if( log ) log->retired.store( true, std::memory_order_release ); }
+    };
+
+_ENGINE_PROTECTED:
+    Profiler()
+    : _epoch{ TscClock::now() }
+    {}
+
+public:
+    Profiler( const Profiler& ) = delete;
+    Profiler( Profiler&& ) = delete;
+
+    ~Profiler() {
+        {
+            std::unique_lock< std::mutex > lock{ _collect_mtx };
+            _stop = true;
+        }
+        _collect_cnd.notify_all();
+
+        if( _collector.joinable() ) _collector.join();
+    }
+
+_ENGINE_PROTECTED:
+    TscClock::time_point                                         _epoch         = {};
+
+    std::mutex                                                   _logs_mtx      = {};
+    std::vector< SPtr< _ThreadLog > >                            _logs          = {};
+    uint32_t                                                     _next_tid      = 0;
+
+    std::mutex                                                   _collect_mtx   = {};
+    std::condition_variable                                      _collect_cnd   = {};
+    std::thread                                                  _collector     = {};
+    bool                                                         _stop          = false;
+
+    std::map< std::string, std::vector< uint64_t >, std::less<> > _durations    = {};
+    std::vector< ProfileZoneEvent >                              _trace         = {};
+    size_t                                                       _dropped       = 0;
+
+_ENGINE_PROTECTED:
+    _ThreadLog& _this_thread_log() {
+        thread_local _LogHandle handle{ this->_register() };
+        return *handle.log;
+    }
+
+    SPtr< _ThreadLog > _register() {
+        std::unique_lock< std::mutex > lock{ _logs_mtx };
+
+        auto log = std::make_shared< _ThreadLog >( _next_tid++ );
+        _logs.push_back( log );
+
+        if( !_collector.joinable() )
+            _collector = std::thread{ &Profiler::_collect_loop, this };
+
+        return log;
+    }
+
+    void _collect_loop() {
+        std::unique_lock< std::mutex > lock{ _collect_mtx };
+
+        while( !_collect_cnd.wait_for( lock, COLLECT_PERIOD, [ this ] () -> bool { return _stop; } ) ) {
+            lock.unlock();
+            this->collect();
+            lock.lock();
+        }
+    }
+
+    /* Under _logs_mtx. */
+    void _drain( _ThreadLog& log ) {
+        for( auto span = log.ring.read_span(); !span.empty(); span = log.ring.read_span() ) {
+            for( const ProfileZoneEvent& event : span ) {
+                auto at = _durations.find( std::string_view{ event.name } );
+                if( at == _durations.end() ) at = _durations.emplace( event.name, std::vector< uint64_t >{} ).first;
+
+                at->second.push_back( event.end - event.begin );
+
+                if( _trace.size() < TRACE_CAPACITY ) _trace.push_back( event );
+                else ++_dropped;
+            }
+
+            log.ring.release( span.size() );
+        }
+
+        _dropped += log.dropped.exchange( 0, std::memory_order_relaxed );
+    }
+
+public:
+    static Profiler& global() {
+        static Profiler profiler{};
+        return profiler;
+    }
+
+public:
+    uint64_t now() const {
+        return ( TscClock::now() - _epoch ).count();
+    }
+
+    /* Zones lost to full rings or to a full trace, so far. */
+    size_t dropped_count() {
+        std::unique_lock< std::mutex > lock{ _logs_mtx };
+        return _dropped;
+    }
+
+public:
+    /* Records a closed zone of the calling thread. Lock free. */
+    void record( const char* name, uint64_t begin, uint64_t end, uint32_t depth ) {
+        _ThreadLog& log = this->_this_thread_log();
+
+        if( !log.ring.push( ProfileZoneEvent{ name: name, begin: begin, end: end, depth: depth, tid: log.tid } ) )
+            log.dropped.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    /* Nesting depth of the calling thread, for ProfileZone. */
+    uint32_t& depth() {
+        return this->_this_thread_log().depth;
+    }
+
+public:
+    /* Drains every ring now, instead of waiting on the collector. */
+    Profiler& collect() {
+        std::unique_lock< std::mutex > lock{ _logs_mtx };
+
+        for( auto& log : _logs ) this->_drain( *log );
+
+        std::erase_if( _logs, [] ( const SPtr< _ThreadLog >& log ) -> bool {
+            return log->retired.load( std::memory_order_acquire ) && log->ring.empty();
+        } );
+
+        return *this;
+    }
+
+    Profiler& reset() {
+        this->collect();
+
+        std::unique_lock< std::mutex > lock{ _logs_mtx };
+
+        _durations.clear();
+        _trace.clear();
+        _dropped = 0;
+
+        return *this;
+    }
+
+    /* Per zone, sorted by total time spent in it. */
+    std::vector< ProfileZoneStats > stats() {
+        this->collect();
+
+        std::unique_lock< std::mutex > lock{ _logs_mtx };
+
+        std::vector< ProfileZoneStats > result;
+        result.reserve( _durations.size() );
+
+        for( auto& [ name, durations ] : _durations ) {
+            if( durations.empty() ) continue;
+
+            std::vector< uint64_t > sorted = durations;
+            const size_t            p99_at = ( sorted.size() * 99 + 99 ) / 100 - 1;
+
+            std::nth_element( sorted.begin(), sorted.begin() + p99_at, sorted.end() );
+
+            uint64_t total = 0;
+            for( uint64_t d : sorted ) total += d;
+
+            auto [ min, max ] = std::minmax_element( sorted.begin(), sorted.end() );
+
+            result.push_back( ProfileZoneStats{
+                name:  name,
+                count: sorted.size(),
+                total: total / 1e3,
+                min:   *min / 1e3,
+                avg:   total / 1e3 / sorted.size(),
+                p99:   sorted[ p99_at ] / 1e3,
+                max:   *max / 1e3
+            } );
+        }
+
+        std::sort( result.begin(), result.end(), [] ( const auto& lhs, const auto& rhs ) -> bool {
+            return lhs.total > rhs.total;
+        } );
+
+        return result;
+    }
+
+    void report( std::ostream& out = std::cout ) {
+        auto table = this->stats();
+
+        out << std::left << std::setw( 32 ) << "zone" << std::right
+            << std::setw( 10 ) << "count" << std::setw( 14 ) << "total ms"
+            << std::setw( 12 ) << "min us" << std::setw( 12 ) << "avg us"
+            << std::setw( 12 ) << "p99 us" << std::setw( 12 ) << "max us" << '\n';
+
+        for( auto& zone : table ) {
+            out << std::left << std::setw( 32 ) << zone.name << std::right << std::fixed << std::setprecision( 2 )
+                << std::setw( 10 ) << zone.count << std::setw( 14 ) << zone.total / 1e3
+                << std::setw( 12 ) << zone.min << std::setw( 12 ) << zone.avg
+                << std::setw( 12 ) << zone.p99 << std::setw( 12 ) << zone.max << '\n';
+        }
+
+        out << std::defaultfloat;
+
+        if( size_t dropped = this->dropped_count(); dropped != 0 )
+            out << dropped << " zones dropped.\n";
+    }
+
+    /* Chrome trace event JSON, for chrome://tracing or ui.perfetto.dev. */
+    bool write_trace( const std::filesystem::path& path, _ENGINE_COMMS_ECHO_ARG ) {
+        this->collect();
+
+        std::ofstream file{ path, std::ios_base::binary };
+
+        if( !file ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open: \"" << path.string() << "\".";
+            return false;
+        }
+
+        std::unique_lock< std::mutex > lock{ _logs_mtx };
+
+        file << "{\"traceEvents\":[";
+
+        for( size_t idx = 0; idx < _trace.size(); ++idx ) {
+            const ProfileZoneEvent& event = _trace[ idx ];
+
+            file << ( idx == 0 ? "\n" : ",\n" ) << "{\"name\":\"";
+
+            for( const char* c = event.name; *c != '\0'; ++c ) {
+                if( *c == '"' || *c == '\\' ) file << '\\';
+                file << *c;
+            }
+
+            file << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.tid
+                 << ",\"ts\":" << event.begin / 1000 << '.' << std::setw( 3 ) << std::setfill( '0' ) << event.begin % 1000
+                 << ",\"dur\":" << ( event.end - event.begin ) / 1000 << '.' << std::setw( 3 ) << ( event.end - event.begin ) % 1000
+                 << std::setfill( ' ' ) << ",\"args\":{\"depth\":" << event.depth << "}}";
+        }
+
+        file << "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+        echo( this, ECHO_LEVEL_OK ) << "Wrote " << _trace.size() << " zones to: \"" << path.string() << "\".";
+
+        return true;
+    }
+
+};
+
+
+/* Times its own scope into Profiler::global(). */
+class ProfileZone {
+public:
+    ProfileZone( const char* name )
+    : _name{ name }, _depth{ Profiler::global().depth()++ }, _begin{ Profiler::global().now() }
+    {}
+
+    ProfileZone( const ProfileZone& ) = delete;
+    ProfileZone( ProfileZone&& ) = delete;
+
+    ~ProfileZone() {
+        Profiler& profiler = Profiler::global();
+
+        profiler.record( _name, _begin, profiler.now(), _depth );
+        --profiler.depth();
+    }
+
+_ENGINE_PROTECTED:
+    const char*   _name    = nullptr;
+    uint32_t      _depth   = 0;
+    uint64_t      _begin   = 0;
+
+};
+
+
+
+};
+
+
+
+#define _ENGINE_PROFILE_CAT_( a, b ) a##b
+#define _ENGINE_PROFILE_CAT( a, b ) _ENGINE_PROFILE_CAT_( a, b )
+
+#if defined( _ENGINE_PROFILE )
+    /* Times the rest of the enclosing scope as zone name. name shall outlive the profiler, string literals do. */
+    #define IXT_ZONE( name ) ::_ENGINE_NAMESPACE::ProfileZone _ENGINE_PROFILE_CAT( _ixt_zone_, __LINE__ ){ name }
+
+    /* Prints the zone table and writes the Chrome trace to path. */
+    #define IXT_ZONE_DUMP( path ) ( ::_ENGINE_NAMESPACE::Profiler::global().report(), ::_ENGINE_NAMESPACE::Profiler::global().write_trace( path ) )
+#else
+    #define IXT_ZONE( name ) ( ( void )0 )
+    #define IXT_ZONE_DUMP( path ) ( ( void )0 )
+#endif
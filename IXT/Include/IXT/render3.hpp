@@ -4,7 +4,10 @@
 
 #include <IXT/descriptor.hpp>
 #include <IXT/surface.hpp>
+#include <IXT/async-file-loader.hpp>
+#include <IXT/file-manip.hpp>
 #include <IXT/hyper-vector.hpp>
+#include <IXT/profiler.hpp>
 
 #if defined( _ENGINE_GL_OPEN_GL )
 
@@ -69,19 +72,23 @@ public:
 
     Shader3( const std::filesystem::path& path, SHADER3_PHASE phase, _ENGINE_COMMS_ECHO_ARG ) {
         std::string source;
-        std::string line;
         DWORD       status = 0;
 
         std::function< void( const std::filesystem::path& ) > accumulate_glsl = [ & ] ( const std::filesystem::path& path ) -> void {
-            std::ifstream file{ path, std::ios_base::binary };
+            File::Map map{ path, FILE_MAP_MODE_READ, FILE_MAP_HINT_SEQUENTIAL, echo };
 
-            if( !file ) {
+            if( !map ) {
                 echo( this, ECHO_LEVEL_ERROR ) << "Could NOT open file: \"" << path.string().c_str() << "\".";
                 status = -1;
                 return;
             }
 
-            while( std::getline( file, line ) ) {
+            for( std::string_view text = map.view(); !text.empty(); ) {
+                const size_t     eol  = text.find( '\n' );
+                std::string_view line = text.substr( 0, eol );
+
+                text.remove_prefix( eol == std::string_view::npos ? text.size() : eol + 1 );
+
                 struct _Directive {
                     const char*   str;
                     void*         lbl;
@@ -104,7 +111,7 @@ public:
                         return;
                     }
                     
-                    arg = std::string{ line.c_str() + q1 + 1, q2 - q1 - 1 };
+                    arg = std::string{ line.substr( q1 + 1, q2 - q1 - 1 ) };
                     goto *d.lbl;
                 }
                 goto l_code_line;
@@ -615,6 +622,34 @@ public:
 
 		echo( this, ECHO_LEVEL_OK ) << "Compiled " << materials.size() << " materials over " << meshes.size() << " meshes."; 
 
+        /* Every texture is read and decoded off this thread, all at once. Only the uploads below wait on them. */
+        _TexFutures tex_futures;
+        {
+            auto prefetch = [ & ] ( const std::filesystem::path& path ) -> void {
+                if( tex_futures.contains( path ) ) return;
+
+                tex_futures.emplace( path, AsyncFileLoader::shared().load( path, [] ( AsyncFileLoader::Loaded& file ) -> _TexData {
+                    _TexData tex;
+                    int      n;
+
+                    if( file )
+                        tex.pixels.reset( stbi_load_from_memory( file.bytes.get(), ( int )file.size, &tex.x, &tex.y, &n, 4 ), stbi_image_free );
+
+                    return tex;
+                } ).share() );
+            };
+
+            for( tinyobj::material_t& mtl : materials ) {
+                for( std::string* name : { &mtl.ambient_texname, &mtl.diffuse_texname, &mtl.specular_texname, &mtl.specular_highlight_texname } )
+                    if( !name->empty() ) prefetch( root_dir / *name );
+
+                for( auto& [ key, value ] : mtl.unknown_parameter )
+                    if( key.starts_with( "IXT" ) && key.find( "map" ) != std::string::npos ) prefetch( root_dir / value );
+            }
+
+            AsyncFileLoader::shared().submit();
+        }
+
         _mtls.reserve( materials.size() );
         for( tinyobj::material_t& mtl_base : materials ) { 
             _Mtl& mtl = _mtls.emplace_back(); 
@@ -636,7 +671,7 @@ public:
             for( auto& [ key, name ] : general_texs ) {
                 if( name->empty() ) continue;
 
-                if( this->_push_tex( root_dir / *name, key, tex_unit, echo ) != 0 ) continue;
+                if( this->_push_tex( root_dir / *name, tex_futures, key, tex_unit, echo ) != 0 ) continue;
 
                 mtl.tex_idxs.push_back( _texs.size() - 1 );
                 ++tex_unit;
@@ -650,7 +685,7 @@ public:
 
                 bool resolved = false;
 
-                if( key.find( "map" ) != std::string::npos && this->_push_tex( root_dir / value, key, tex_unit, echo ) == 0 ) {
+                if( key.find( "map" ) != std::string::npos && this->_push_tex( root_dir / value, tex_futures, key, tex_unit, echo ) == 0 ) {
                     mtl.tex_idxs.push_back( _texs.size() - 1 );
                     ++tex_unit;
                     resolved = true;
@@ -793,6 +828,12 @@ _ENGINE_PROTECTED:
         Uniform3< glm::u32 >   ufrm;
     };
     std::vector< _Tex >       _texs;
+    struct _TexData {
+        SPtr< UBYTE >          pixels   = nullptr;
+        int                    x        = 0;
+        int                    y        = 0;
+    };
+    using _TexFutures = std::map< std::filesystem::path, std::shared_future< _TexData > >;
 
 public:
     Uniform3< glm::mat4 >     model;
@@ -802,14 +843,17 @@ public:
 _ENGINE_PROTECTED:
     DWORD _push_tex( 
         const std::filesystem::path& path, 
+        _TexFutures&                 tex_futures,
         std::string_view             name, 
         GLuint                       pipe_unit,  
         _ENGINE_COMMS_ECHO_ARG 
     ) {
         GLuint tex_glidx;
 
-        int x, y, n;
-        UBYTE* img_buf = stbi_load( path.string().c_str(), &x, &y, &n, 4 );
+        const _TexData& tex     = tex_futures.at( path ).get();
+        UBYTE*          img_buf = tex.pixels.get();
+        int             x       = tex.x;
+        int             y       = tex.y;
 
         if( img_buf == nullptr ) {
             echo( this, ECHO_LEVEL_ERROR ) << "Failed to load texture data from: \"" << path.string().c_str() << "\".";
@@ -836,7 +880,6 @@ _ENGINE_PROTECTED:
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 
         glBindTexture( GL_TEXTURE_2D, 0 );
-        stbi_image_free( img_buf );
 
         _texs.emplace_back( _Tex{
             glidx: tex_glidx,
@@ -871,6 +914,8 @@ public:
     }
 
     Mesh3& splash( ShadingPipe3& pipe ) {
+        IXT_ZONE( "Mesh3::splash" );
+
         pipe.uplink();
 
         for( _SubMesh& sub : _sub_meshes ) {
@@ -4,6 +4,11 @@
 
 #include <IXT/descriptor.hpp>
 
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+    #include <immintrin.h>
+    #define _ENGINE_TEMPO_TSC
+#endif
+
 namespace _ENGINE_NAMESPACE {
 
 
@@ -27,48 +32,51 @@ struct ticker_lap_epoch_init_t{};
 class Ticker {
 public:
     Ticker()
-    : _create{ std::chrono::high_resolution_clock::now() },
-      _last_lap{ std::chrono::high_resolution_clock::now() }
+    : _create{ std::chrono::steady_clock::now() },
+      _last_lap{ std::chrono::steady_clock::now() }
     {}
 
     Ticker( [[maybe_unused]]ticker_lap_epoch_init_t )
-    : _create{ std::chrono::high_resolution_clock::now() },
+    : _create{ std::chrono::steady_clock::now() },
       _last_lap{}
     {}
 
 _ENGINE_PROTECTED:
-    std::chrono::high_resolution_clock::time_point   _create     = {};
-    std::chrono::high_resolution_clock::time_point   _last_lap   = {};
+    std::chrono::steady_clock::time_point   _create     = {};
+    std::chrono::steady_clock::time_point   _last_lap   = {};
 
 public:
     template< TICK unit = TICK_SECS >
     double up_time() const {
         using namespace std::chrono;
 
-        return duration< double >( high_resolution_clock::now() - _create ).count() * TICK_MULS[ unit ];
+        return duration< double >( steady_clock::now() - _create ).count() * TICK_MULS[ unit ];
     }
 
     template< TICK unit = TICK_SECS >
     double peek_lap() const {
         using namespace std::chrono; 
 
-        return duration< double >( high_resolution_clock::now() - _last_lap ).count() * TICK_MULS[ unit ];
+        return duration< double >( steady_clock::now() - _last_lap ).count() * TICK_MULS[ unit ];
     }
 
     template< TICK unit = TICK_SECS >
     double lap() {
         using namespace std::chrono;
 
-        auto now = high_resolution_clock::now();
+        auto now = steady_clock::now();
 
         return duration< double >( now - std::exchange( _last_lap, now ) ).count() * TICK_MULS[ unit ];
     }
 
+    /* Laps only if at least floating units went by since the last lap. Returns whether it lapped. */
     template< TICK unit = TICK_SECS >
-    double cmpxchg_lap( double floating ) {
+    bool cmpxchg_lap( double floating ) {
         if( this->peek_lap< unit >() < floating )
             return false;
-        return this->lap();
+
+        this->lap< unit >();
+        return true;
     }
 
 _ENGINE_PROTECTED:
@@ -97,4 +105,208 @@ public:
 
 
 
+/*
+Time stamp counter reads, scaled to nanoseconds on the steady_clock timeline, so its readings mix with steady_clock's.
+The scale is measured against steady_clock once, on first use, which blocks for CALIBRATION. Assumes an invariant
+counter, as every x86 of the last decade has. Off x86, it is steady_clock.
+*/
+class TscClock {
+public:
+    typedef std::chrono::nanoseconds              duration;
+    typedef duration::rep                         rep;
+    typedef duration::period                      period;
+    typedef std::chrono::time_point< TscClock >   time_point;
+
+    inline static constexpr bool                        is_steady     = true;
+    inline static constexpr std::chrono::milliseconds   CALIBRATION   = std::chrono::milliseconds{ 20 };
+
+_ENGINE_PROTECTED:
+    struct _Scale {
+        uint64_t   tsc      = 0;
+        int64_t    nanos    = 0;
+        double     factor   = 1.0;
+    };
+
+    static int64_t _steady_nanos() {
+        using namespace std::chrono;
+
+        return duration_cast< nanoseconds >( steady_clock::now().time_since_epoch() ).count();
+    }
+
+    /* A steady_clock read between two counter reads, the tightest of a few, paired with the counter midway. */
+    static _Scale _sample() {
+        _Scale   best  = {};
+        uint64_t width = ~uint64_t{ 0 };
+
+        for( int n = 0; n < 8; ++n ) {
+            const uint64_t lo    = TscClock::ticks();
+            const int64_t  nanos = _steady_nanos();
+            const uint64_t hi    = TscClock::ticks();
+
+            if( hi - lo < width ) {
+                width = hi - lo;
+                best  = _Scale{ tsc: lo + width / 2, nanos: nanos };
+            }
+        }
+
+        return best;
+    }
+
+    static _Scale _calibrate() {
+        _Scale scale = _sample();
+
+        std::this_thread::sleep_for( CALIBRATION );
+
+        const _Scale last = _sample();
+
+        if( last.tsc > scale.tsc ) scale.factor = ( double )( last.nanos - scale.nanos ) / ( last.tsc - scale.tsc );
+
+        return scale;
+    }
+
+    static const _Scale& _scale() {
+        static const _Scale scale = _calibrate();
+        return scale;
+    }
+
+public:
+    /* Raw counter. Only differences mean anything. */
+    static uint64_t ticks() {
+    #if defined( _ENGINE_TEMPO_TSC )
+        return __rdtsc();
+    #else
+        return _steady_nanos();
+    #endif
+    }
+
+    static time_point now() {
+    #if defined( _ENGINE_TEMPO_TSC )
+        const _Scale& scale = _scale();
+
+        return time_point{ duration{ scale.nanos + ( int64_t )( ( int64_t )( ticks() - scale.tsc ) * scale.factor ) } };
+    #else
+        return time_point{ duration{ _steady_nanos() } };
+    #endif
+    }
+
+    /* Nanoseconds per tick. Forces the calibration, for whoever would rather pay for it up front. */
+    static double nanos_per_tick() {
+    #if defined( _ENGINE_TEMPO_TSC )
+        return _scale().factor;
+    #else
+        return 1.0;
+    #endif
+    }
+
+    static std::chrono::steady_clock::time_point to_steady( time_point at ) {
+        return std::chrono::steady_clock::time_point{ std::chrono::duration_cast< std::chrono::steady_clock::duration >( at.time_since_epoch() ) };
+    }
+
+};
+
+
+
+struct FramePacerStats {
+    uint64_t                   frame_count    = 0;
+    uint64_t                   missed_count   = 0;
+    std::chrono::nanoseconds   worst_late     = {};
+    std::chrono::nanoseconds   total_late     = {};
+};
+
+/*
+Paces a loop at a fixed rate. Deadlines step by exactly one period off the first, so the rate does not drift with
+how late each wake up lands. wait() sleeps most of the way, then spins the rest, the spin sized off how far the
+sleeps overshoot, up to max_spin. Past its deadline, a frame counts as missed. A whole period behind, the backlog
+is dropped and the deadlines restart from now, instead of running frames back to back to catch up.
+*/
+class FramePacer {
+public:
+    inline static constexpr std::chrono::nanoseconds   MIN_SPIN   = std::chrono::microseconds{ 100 };
+
+public:
+    FramePacer( double hz )
+    : FramePacer{ hz, std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::duration< double >{ 0.5 / hz } ) }
+    {}
+
+    FramePacer( double hz, std::chrono::nanoseconds max_spin )
+    : _period{ std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::duration< double >{ 1.0 / hz } ) },
+      _max_spin{ max_spin },
+      _spin{ std::min( max_spin, std::chrono::nanoseconds{ std::chrono::milliseconds{ 1 } } ) }
+    {
+        this->reset();
+    }
+
+_ENGINE_PROTECTED:
+    std::chrono::nanoseconds   _period     = {};
+    std::chrono::nanoseconds   _max_spin   = {};
+    std::chrono::nanoseconds   _spin       = {};
+
+    TscClock::time_point       _next       = {};
+    TscClock::time_point       _last       = {};
+
+    FramePacerStats            _stats      = {};
+
+public:
+    /* Fixed timestep, in seconds. */
+    double period() const {
+        return std::chrono::duration< double >{ _period }.count();
+    }
+
+    const FramePacerStats& stats() const {
+        return _stats;
+    }
+
+    /* Restarts the deadlines from now, after the loop was held up on purpose. */
+    FramePacer& reset() {
+        _last = TscClock::now();
+        _next = _last + _period;
+        return *this;
+    }
+
+public:
+    /* Blocks until the next deadline. Returns the seconds since the previous wait() returned. */
+    double wait() {
+        using namespace std::chrono;
+
+        TscClock::time_point now = TscClock::now();
+
+        if( now < _next ) {
+            if( _next - now > _spin ) {
+                const TscClock::time_point wake = _next - _spin;
+
+                std::this_thread::sleep_for( wake - now );
+                now = TscClock::now();
+
+                const nanoseconds over = now > wake ? now - wake : nanoseconds{ 0 };
+                _spin = std::clamp( std::max( over + over / 4, _spin - _spin / 16 ), std::min( MIN_SPIN, _max_spin ), _max_spin );
+            }
+
+            for(; now < _next; now = TscClock::now() ) {
+            #if defined( _ENGINE_TEMPO_TSC )
+                _mm_pause();
+            #else
+                std::this_thread::yield();
+            #endif
+            }
+
+            _next += _period;
+        } else {
+            const nanoseconds late = now - _next;
+
+            ++_stats.missed_count;
+            _stats.worst_late  = std::max( _stats.worst_late, late );
+            _stats.total_late += late;
+
+            _next = late >= _period ? now + _period : _next + _period;
+        }
+
+        ++_stats.frame_count;
+
+        return duration< double >{ now - std::exchange( _last, now ) }.count();
+    }
+
+};
+
+
+
 };
@@ -0,0 +1,188 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/comms.hpp>
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+/*
+Fixed set of workers over one task queue. parallel_for() splits a range into chunks and the calling thread
+works alongside the pool, so it may be called from inside a task without starving the workers.
+*/
+class ThreadPool : public Descriptor {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "ThreadPool" );
+
+public:
+    ThreadPool( size_t thread_count = 0, _ENGINE_COMMS_ECHO_ARG ) {
+        if( thread_count == 0 )
+            thread_count = std::max( std::thread::hardware_concurrency(), 1u );
+
+        _threads.reserve( thread_count );
+
+        for( size_t n = 0; n < thread_count; ++n )
+            _threads.emplace_back( &ThreadPool::_main, this );
+
+        echo( this, ECHO_LEVEL_OK ) << "Created with " << thread_count << " workers.";
+    }
+
+    ThreadPool( const ThreadPool& ) = delete;
+    ThreadPool( ThreadPool&& ) = delete;
+
+    ~ThreadPool() {
+        {
+            std::unique_lock< std::mutex > lock{ _mtx };
+            _powered = false;
+        }
+        _cnd_var.notify_all();
+
+        for( auto& thread : _threads )
+            if( thread.joinable() )
+                thread.join();
+    }
+
+_ENGINE_PROTECTED:
+    template< typename Op >
+    struct _ForState {
+        Op*                      op       = nullptr;
+        int64_t                  begin    = 0;
+        int64_t                  end      = 0;
+        int64_t                  chunk    = 0;
+        int64_t                  chunks   = 0;
+        std::atomic< int64_t >   next     = { 0 };
+        std::atomic< int64_t >   left     = { 0 };
+    };
+
+_ENGINE_PROTECTED:
+    std::vector< std::thread >                _threads   = {};
+    std::deque< std::function< void() > >     _tasks     = {};
+    std::mutex                                _mtx       = {};
+    std::condition_variable                   _cnd_var   = {};
+    bool                                      _powered   = true;
+
+_ENGINE_PROTECTED:
+    void _main() {
+        for(;;) {
+            std::function< void() > task = {};
+
+            {
+                std::unique_lock< std::mutex > lock{ _mtx };
+                _cnd_var.wait( lock, [ this ] () -> bool { return !_powered || !_tasks.empty(); } );
+
+                if( _tasks.empty() ) return;
+
+                task = std::move( _tasks.front() );
+                _tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+
+    /*
+    Chunks are claimed through next. Late helpers may still claim past the end after the caller returned,
+    which is why the state is shared and op is only touched for valid chunks.
+    */
+    template< typename Op >
+    static void _for_run( _ForState< Op >& state ) {
+        for( int64_t at = state.next.fetch_add( 1, std::memory_order_relaxed ); at < state.chunks; at = state.next.fetch_add( 1, std::memory_order_relaxed ) ) {
+            int64_t lo = state.begin + at * state.chunk;
+
+            std::invoke( *state.op, lo, std::min( lo + state.chunk, state.end ) );
+
+            if( state.left.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+                state.left.notify_all();
+        }
+    }
+
+public:
+    static ThreadPool& shared() {
+        static ThreadPool pool{};
+        return pool;
+    }
+
+public:
+    size_t thread_count() const {
+        return _threads.size();
+    }
+
+    size_t pending_count() {
+        std::unique_lock< std::mutex > lock{ _mtx };
+        return _tasks.size();
+    }
+
+public:
+    template< typename Task >
+    auto submit( Task&& task ) -> std::future< std::invoke_result_t< Task > > {
+        using R = std::invoke_result_t< Task >;
+
+        auto packaged = std::make_shared< std::packaged_task< R() > >( std::forward< Task >( task ) );
+        auto future   = packaged->get_future();
+
+        {
+            std::unique_lock< std::mutex > lock{ _mtx };
+            _tasks.emplace_back( [ packaged ] () -> void { ( *packaged )(); } );
+        }
+        _cnd_var.notify_one();
+
+        return future;
+    }
+
+    /* Fire and forget. */
+    template< typename Task >
+    void post( Task&& task ) {
+        {
+            std::unique_lock< std::mutex > lock{ _mtx };
+            _tasks.emplace_back( std::forward< Task >( task ) );
+        }
+        _cnd_var.notify_one();
+    }
+
+    /* Runs op( lo, hi ) over [ begin, end ), in chunks of at least grain. Blocks until every chunk is done. */
+    template< typename Op >
+    void parallel_for( int64_t begin, int64_t end, int64_t grain, Op&& op ) {
+        const int64_t count = end - begin;
+        if( count <= 0 ) return;
+
+        grain = std::max< int64_t >( grain, 1 );
+
+        const int64_t chunks = std::min< int64_t >( ( count + grain - 1 ) / grain, ( this->thread_count() + 1 ) * 4 );
+
+        if( chunks <= 1 || this->thread_count() == 0 ) {
+            std::invoke( op, begin, end );
+            return;
+        }
+
+        using Opr = std::remove_reference_t< Op >;
+
+        auto state = std::make_shared< _ForState< Opr > >();
+        state->op     = &op;
+        state->begin  = begin;
+        state->end    = end;
+        state->chunk  = ( count + chunks - 1 ) / chunks;
+        state->chunks = ( count + state->chunk - 1 ) / state->chunk;
+        state->left.store( state->chunks, std::memory_order_relaxed );
+
+        const int64_t helper_count = std::min< int64_t >( state->chunks - 1, this->thread_count() );
+        {
+            std::unique_lock< std::mutex > lock{ _mtx };
+            for( int64_t n = 0; n < helper_count; ++n )
+                _tasks.emplace_back( [ state ] () -> void { _for_run( *state ); } );
+        }
+        _cnd_var.notify_all();
+
+        _for_run( *state );
+
+        for( int64_t left = state->left.load( std::memory_order_acquire ); left != 0; left = state->left.load( std::memory_order_acquire ) )
+            state->left.wait( left, std::memory_order_acquire );
+    }
+
+};
+
+
+
+};
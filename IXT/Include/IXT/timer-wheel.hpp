@@ -0,0 +1,350 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/comms.hpp>
+#include <IXT/tempo.hpp>
+#include <IXT/thread-pool.hpp>
+
+
+
+namespace _ENGINE_NAMESPACE {
+
+
+
+/* Callbacks posted from elsewhere, ran by whoever drains it. E.g. the render thread, once per frame. */
+class TimerMailbox {
+public:
+    TimerMailbox() = default;
+
+    TimerMailbox( const TimerMailbox& ) = delete;
+    TimerMailbox( TimerMailbox&& ) = delete;
+
+_ENGINE_PROTECTED:
+    std::mutex                               _mtx     = {};
+    std::vector< std::function< void() > >   _queue   = {};
+    std::vector< std::function< void() > >   _ready   = {};
+
+public:
+    void post( std::function< void() > fn ) {
+        std::unique_lock< std::mutex > lock{ _mtx };
+        _queue.emplace_back( std::move( fn ) );
+    }
+
+    /* Runs everything posted so far. Returns how many ran. */
+    size_t drain() {
+        {
+            std::unique_lock< std::mutex > lock{ _mtx };
+            if( _queue.empty() ) return 0;
+
+            _ready.swap( _queue );
+        }
+
+        for( auto& fn : _ready ) fn();
+
+        const size_t count = _ready.size();
+        _ready.clear();
+
+        return count;
+    }
+
+};
+
+/* Where a timer callback runs. Defaults to the wheel thread itself, keep those short. */
+struct TimerTarget {
+    TimerTarget() = default;
+    TimerTarget( ThreadPool& pool ) : pool{ &pool } {}
+    TimerTarget( TimerMailbox& mailbox ) : mailbox{ &mailbox } {}
+
+    ThreadPool*     pool      = nullptr;
+    TimerMailbox*   mailbox   = nullptr;
+};
+
+struct TimerId {
+    uint32_t   idx   = ~uint32_t{ 0 };
+    uint32_t   gen   = 0;
+
+    explicit operator bool () const { return idx != ~uint32_t{ 0 }; }
+};
+
+
+/*
+Hierarchical timer wheel, LEVELS wheels of SLOTS slots each, the first turning once per resolution tick and each
+next one once per full turn of the previous. A timer hangs in the slot of the coarsest wheel it has to wait a turn
+of, and drops a wheel every time that slot comes up, so arming and canceling are O( 1 ) list splices and a tick
+only touches the timers due on it. Timers live in a pool and are named by TimerId, a slot index plus a generation,
+so stale ids cancel nothing.
+Due timers are handed to their target from the wheel thread, periodic ones re-arm first, off their previous due
+tick, so they do not drift. A timer canceled once its callback went to a pool or a mailbox may still run once.
+*/
+class TimerWheel : public Descriptor {
+public:
+    _ENGINE_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "TimerWheel" );
+
+public:
+    inline static constexpr uint32_t   LEVELS       = 4;
+    inline static constexpr uint32_t   SLOT_BITS    = 8;
+    inline static constexpr uint32_t   SLOTS        = 1 << SLOT_BITS;
+
+public:
+    TimerWheel(
+        std::chrono::nanoseconds   resolution   = std::chrono::milliseconds{ 1 },
+        _ENGINE_COMMS_ECHO_ARG
+    )
+    : _resolution{ std::max( resolution, std::chrono::nanoseconds{ std::chrono::microseconds{ 50 } } ) },
+      _start{ TscClock::now() }
+    {
+        for( auto& level : _heads ) std::fill( std::begin( level ), std::end( level ), _NIL );
+
+        _thread = std::thread{ &TimerWheel::_main, this };
+
+        echo( this, ECHO_LEVEL_OK ) << "Created, ticking every " << _resolution.count() << "ns.";
+    }
+
+    TimerWheel( const TimerWheel& ) = delete;
+    TimerWheel( TimerWheel&& ) = delete;
+
+    ~TimerWheel() {
+        {
+            std::unique_lock< std::mutex > lock{ _mtx };
+            _stop = true;
+        }
+        _cnd.notify_all();
+
+        _thread.join();
+    }
+
+_ENGINE_PROTECTED:
+    inline static constexpr uint32_t   _NIL   = ~uint32_t{ 0 };
+
+    struct _Node {
+        uint64_t                   due       = 0;
+        uint64_t                   period    = 0;
+        uint32_t                   prev      = _NIL;
+        uint32_t                   next      = _NIL;
+        uint32_t                   gen       = 0;
+        uint32_t                   slot      = _NIL;
+        std::function< void() >    fn        = {};
+        TimerTarget                target    = {};
+    };
+
+_ENGINE_PROTECTED:
+    std::chrono::nanoseconds                 _resolution              = {};
+    TscClock::time_point                     _start                   = {};
+
+    std::mutex                               _mtx                     = {};
+    std::condition_variable                  _cnd                     = {};
+    std::thread                              _thread                  = {};
+    bool                                     _stop                    = false;
+
+    std::vector< _Node >                     _nodes                   = {};
+    uint32_t                                 _free                    = _NIL;
+    size_t                                   _active                  = 0;
+
+    uint64_t                                 _tick                    = 0;
+    uint32_t                                 _heads[ LEVELS ][ SLOTS ] = {};
+
+    std::vector< std::function< void() > >   _inline                  = {};
+
+_ENGINE_PROTECTED:
+    uint64_t _clock_tick() const {
+        return ( TscClock::now() - _start ) / _resolution;
+    }
+
+    void _link( uint32_t idx ) {
+        _Node&         node  = _nodes[ idx ];
+        const uint64_t delta = std::min( node.due - std::min( node.due, _tick ), ( uint64_t{ 1 } << ( LEVELS * SLOT_BITS ) ) - 1 );
+        const uint64_t due   = _tick + delta;
+
+        uint32_t level = 0;
+        while( level < LEVELS - 1 && ( delta >> ( ( level + 1 ) * SLOT_BITS ) ) != 0 ) ++level;
+
+        node.slot = level * SLOTS + ( ( due >> ( level * SLOT_BITS ) ) & ( SLOTS - 1 ) );
+        node.prev = _NIL;
+        node.next = _heads[ level ][ node.slot % SLOTS ];
+
+        if( node.next != _NIL ) _nodes[ node.next ].prev = idx;
+        _heads[ level ][ node.slot % SLOTS ] = idx;
+    }
+
+    void _unlink( uint32_t idx ) {
+        _Node& node = _nodes[ idx ];
+
+        if( node.prev != _NIL ) _nodes[ node.prev ].next = node.next;
+        else _heads[ node.slot / SLOTS ][ node.slot % SLOTS ] = node.next;
+
+        if( node.next != _NIL ) _nodes[ node.next ].prev = node.prev;
+
+        node.slot = _NIL;
+    }
+
+    void _release( uint32_t idx ) {
+        _Node& node = _nodes[ idx ];
+
+        node.fn     = nullptr;
+        node.target = {};
+        node.next   = _free;
+        ++node.gen;
+
+        _free = idx;
+        --_active;
+    }
+
+    /* Takes the whole list of a slot. */
+    uint32_t _take( uint32_t level, uint32_t slot ) {
+        return std::exchange( _heads[ level ][ slot ], _NIL );
+    }
+
+    void _fire( uint32_t idx ) {
+        _Node& node = _nodes[ idx ];
+
+        std::function< void() > fn = node.period != 0 ? node.fn : std::move( node.fn );
+        TimerTarget             to = node.target;
+
+        if( node.period != 0 ) {
+            node.due += node.period;
+            if( node.due <= _tick ) node.due = _tick + 1;
+            this->_link( idx );
+        } else {
+            node.slot = _NIL;
+            this->_release( idx );
+        }
+
+        if( to.pool != nullptr ) to.pool->post( std::move( fn ) );
+        else if( to.mailbox != nullptr ) to.mailbox->post( std::move( fn ) );
+        else _inline.emplace_back( std::move( fn ) );
+    }
+
+    /* One tick. The coarser wheels whose turn came up drop their slot first, coarsest first. */
+    void _advance() {
+        ++_tick;
+
+        for( uint32_t level = LEVELS - 1; level > 0; --level ) {
+            if( ( _tick & ( ( uint64_t{ 1 } << ( level * SLOT_BITS ) ) - 1 ) ) != 0 ) continue;
+
+            for( uint32_t idx = this->_take( level, ( _tick >> ( level * SLOT_BITS ) ) & ( SLOTS - 1 ) ); idx != _NIL; ) {
+                const uint32_t next = _nodes[ idx ].next;
+                this->_link( idx );
+                idx = next;
+            }
+        }
+
+        for( uint32_t idx = this->_take( 0, _tick & ( SLOTS - 1 ) ); idx != _NIL; ) {
+            const uint32_t next = _nodes[ idx ].next;
+            this->_fire( idx );
+            idx = next;
+        }
+    }
+
+    void _main() {
+        std::vector< std::function< void() > > batch;
+
+        std::unique_lock< std::mutex > lock{ _mtx };
+
+        while( !_stop ) {
+            if( _active == 0 ) {
+                _tick = std::max( _tick, this->_clock_tick() );
+                _cnd.wait( lock );
+                continue;
+            }
+
+            for( uint64_t now = this->_clock_tick(); _tick < now && _active != 0; ) this->_advance();
+
+            if( !_inline.empty() ) {
+                batch.swap( _inline );
+
+                lock.unlock();
+                for( auto& fn : batch ) fn();
+                batch.clear();
+                lock.lock();
+
+                continue;
+            }
+
+            _cnd.wait_until( lock, TscClock::to_steady( _start + _resolution * ( _tick + 1 ) ) );
+        }
+    }
+
+    TimerId _arm( std::chrono::nanoseconds delay, std::chrono::nanoseconds period, std::function< void() > fn, TimerTarget target ) {
+        const auto     since = TscClock::now() - _start + std::max( delay, std::chrono::nanoseconds{ 0 } );
+        const uint64_t due   = ( since.count() + _resolution.count() - 1 ) / _resolution.count();
+
+        std::unique_lock< std::mutex > lock{ _mtx };
+
+        if( _free == _NIL ) {
+            _free = ( uint32_t )_nodes.size();
+            _nodes.emplace_back();
+        }
+
+        const uint32_t idx  = _free;
+        _Node&         node = _nodes[ idx ];
+
+        _free = node.next;
+
+        node.due    = std::max( due, _tick + 1 );
+        node.period = period.count() > 0 ? std::max< uint64_t >( 1, period / _resolution ) : 0;
+        node.fn     = std::move( fn );
+        node.target = target;
+
+        this->_link( idx );
+
+        if( _active++ == 0 ) _cnd.notify_one();
+
+        return TimerId{ idx: idx, gen: node.gen };
+    }
+
+public:
+    static TimerWheel& shared() {
+        static TimerWheel wheel{};
+        return wheel;
+    }
+
+public:
+    std::chrono::nanoseconds resolution() const {
+        return _resolution;
+    }
+
+    size_t active_count() {
+        std::unique_lock< std::mutex > lock{ _mtx };
+        return _active;
+    }
+
+    /* Room for count timers, so that arming them does not grow the pool. */
+    TimerWheel& reserve( size_t count ) {
+        std::unique_lock< std::mutex > lock{ _mtx };
+        _nodes.reserve( count );
+        return *this;
+    }
+
+public:
+    /* Runs fn once, delay from now, rounded up to the next tick. */
+    TimerId after( std::chrono::nanoseconds delay, std::function< void() > fn, TimerTarget target = {} ) {
+        return this->_arm( delay, std::chrono::nanoseconds{ 0 }, std::move( fn ), target );
+    }
+
+    /* Runs fn every period, the first time a period from now. */
+    TimerId every( std::chrono::nanoseconds period, std::function< void() > fn, TimerTarget target = {} ) {
+        return this->_arm( period, period, std::move( fn ), target );
+    }
+
+    /* Returns whether the timer was still armed. */
+    bool cancel( TimerId id ) {
+        std::unique_lock< std::mutex > lock{ _mtx };
+
+        if( id.idx >= _nodes.size() ) return false;
+
+        _Node& node = _nodes[ id.idx ];
+        if( node.gen != id.gen || node.slot == _NIL ) return false;
+
+        this->_unlink( id.idx );
+        this->_release( id.idx );
+
+        return true;
+    }
+
+};
+
+
+
+};
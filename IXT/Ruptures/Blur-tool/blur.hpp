@@ -0,0 +1,323 @@
+#pragma once
+/*
+*/
+
+#include <IXT/descriptor.hpp>
+#include <IXT/aritm.hpp>
+#include <IXT/image.hpp>
+#include <IXT/thread-pool.hpp>
+#include <IXT/profiler.hpp>
+using namespace IXT;
+
+
+
+/* The value is the number of box passes. Three box passes land close to a gaussian. */
+enum BLUR_KIND : BYTE {
+    BLUR_KIND_BOX   = 1,
+    BLUR_KIND_GAUSS = 3
+};
+
+
+
+/*
+One byte per pixel, set where any of the regions contains the pixel. Built once, in parallel,
+probing contains() only inside each region's bounding box.
+*/
+struct BlurMask {
+    std::vector< ubyte_t >   bits     = {};
+    int32_t                  width    = 0;
+    int32_t                  height   = 0;
+
+    int32_t                  x0       = 0;
+    int32_t                  y0       = 0;
+    int32_t                  x1       = 0;
+    int32_t                  y1       = 0;
+
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+
+    bool operator () ( int32_t x, int32_t y ) const { return bits[ ( size_t )y * width + x ]; }
+
+    static BlurMask full( int32_t width, int32_t height ) {
+        return BlurMask{
+            .bits   = std::vector< ubyte_t >( ( size_t )width * height, 1 ),
+            .width  = width, .height = height,
+            .x0     = 0, .y0 = 0, .x1 = width, .y1 = height
+        };
+    }
+
+    template< typename Regions >
+    static BlurMask of( int32_t width, int32_t height, const Regions& regions, ThreadPool& pool = ThreadPool::shared() ) {
+        IXT_ZONE( "BlurMask::of" );
+
+        struct Box { int32_t x0, y0, x1, y1; };
+
+        std::vector< Box > boxes;
+
+        for( auto& reg : regions ) {
+            Box box{ 0, 0, width, height };
+
+            if constexpr( requires{ reg.vrtx_count(); reg( size_t{ 0 } ); } ) {
+                if( reg.vrtx_count() == 0 ) { boxes.push_back( Box{ 0, 0, 0, 0 } ); continue; }
+
+                ggfloat_t lx = std::numeric_limits< ggfloat_t >::max(), hx = -lx;
+                ggfloat_t ly = lx,                                        hy = -lx;
+
+                for( size_t idx = 0; idx < reg.vrtx_count(); ++idx ) {
+                    Vec2 v = reg( idx );
+                    lx = std::min( lx, v.x ); hx = std::max( hx, v.x );
+                    ly = std::min( ly, v.y ); hy = std::max( hy, v.y );
+                }
+
+                box = Box{
+                    std::clamp( ( int32_t )std::floor( lx ), 0, width ),
+                    std::clamp( ( int32_t )std::floor( ly ), 0, height ),
+                    std::clamp( ( int32_t )std::ceil( hx ) + 1, 0, width ),
+                    std::clamp( ( int32_t )std::ceil( hy ) + 1, 0, height )
+                };
+            }
+
+            boxes.push_back( box );
+        }
+
+        BlurMask mask{ .bits = std::vector< ubyte_t >( ( size_t )width * height, 0 ), .width = width, .height = height };
+
+        std::vector< std::pair< int32_t, int32_t > > row_spans( height, { width, 0 } );
+
+        pool.parallel_for( 0, height, 16, [ & ] ( int64_t lo, int64_t hi ) -> void {
+            for( int32_t y = lo; y < hi; ++y ) {
+                ubyte_t* row = mask.bits.data() + ( size_t )y * width;
+                auto&    span = row_spans[ y ];
+
+                size_t r = 0;
+                for( auto& reg : regions ) {
+                    const Box& box = boxes[ r++ ];
+                    if( y < box.y0 || y >= box.y1 ) continue;
+
+                    for( int32_t x = box.x0; x < box.x1; ++x ) {
+                        if( row[ x ] || !reg.contains( Vec2{ ( ggfloat_t )x, ( ggfloat_t )y } ) ) continue;
+
+                        row[ x ] = 1;
+                        span.first  = std::min( span.first, x );
+                        span.second = std::max( span.second, x + 1 );
+                    }
+                }
+            }
+        } );
+
+        mask.x0 = width; mask.y0 = height;
+        for( int32_t y = 0; y < height; ++y ) {
+            if( row_spans[ y ].first >= row_spans[ y ].second ) continue;
+
+            mask.x0 = std::min( mask.x0, row_spans[ y ].first );
+            mask.x1 = std::max( mask.x1, row_spans[ y ].second );
+            mask.y0 = std::min( mask.y0, y );
+            mask.y1 = y + 1;
+        }
+
+        return mask;
+    }
+};
+
+
+
+/*
+Separable box blur over running sums, O( 1 ) per pixel whatever the radius. The window is 2 * radius + 1 wide
+and is cut at the image edges, the divisor following the cut. Rows are split across the pool for the
+horizontal pass, column bands for the vertical one. Only the mask's bounding box, grown by the reach of
+all passes, is ever touched.
+*/
+class BlurEngine {
+public:
+    BlurEngine( int32_t radius, BLUR_KIND kind = BLUR_KIND_BOX, ThreadPool& pool = ThreadPool::shared() )
+    : _radius{ std::max( radius, 0 ) }, _kind{ kind }, _pool{ &pool }
+    {
+        /* Division by the window size, as a 8.24 fixed point multiply. The sums never reach 2^8 times the size. */
+        _mul.resize( 2 * _radius + 2 );
+        for( size_t n = 1; n < _mul.size(); ++n )
+            _mul[ n ] = ( uint32_t )std::lround( ( double )( 1u << 24 ) / n );
+    }
+
+_ENGINE_PROTECTED:
+    int32_t                  _radius    = 0;
+    BLUR_KIND                _kind      = BLUR_KIND_BOX;
+    ThreadPool*              _pool      = nullptr;
+
+    std::vector< uint32_t >  _mul       = {};
+    std::vector< ubyte_t >   _scratch   = {};
+
+_ENGINE_PROTECTED:
+    template< int C >
+    void _box_h_row( const ubyte_t* src, ubyte_t* dst, int32_t width ) const {
+        const int32_t r        = _radius;
+        uint32_t      acc[ C ] = {};
+
+        auto emit = [ & ] ( int32_t x, uint32_t mul ) -> void {
+            for( int c = 0; c < C; ++c )
+                dst[ x * C + c ] = ( ubyte_t )( ( acc[ c ] * mul + ( 1u << 23 ) ) >> 24 );
+        };
+        auto add = [ & ] ( int32_t x ) -> void {
+            for( int c = 0; c < C; ++c ) acc[ c ] += src[ x * C + c ];
+        };
+        auto sub = [ & ] ( int32_t x ) -> void {
+            for( int c = 0; c < C; ++c ) acc[ c ] -= src[ x * C + c ];
+        };
+
+        for( int32_t x = 0; x <= std::min( r, width - 1 ); ++x )
+            add( x );
+
+        /* Branchy edges, a straight run in between, where the window is whole. */
+        const int32_t mid_lo = std::min( r + 1, width );
+        const int32_t mid_hi = std::max( width - r - 1, mid_lo );
+
+        int32_t x = 0;
+        for( ; x < mid_lo; ++x ) {
+            emit( x, _mul[ std::min( x + r, width - 1 ) - std::max( x - r, 0 ) + 1 ] );
+            if( x + r + 1 < width ) add( x + r + 1 );
+            if( x - r >= 0 )        sub( x - r );
+        }
+
+        const uint32_t mul = _mul[ 2 * r + 1 ];
+        for( ; x < mid_hi; ++x ) {
+            emit( x, mul );
+            add( x + r + 1 );
+            sub( x - r );
+        }
+
+        for( ; x < width; ++x ) {
+            emit( x, _mul[ std::min( x + r, width - 1 ) - std::max( x - r, 0 ) + 1 ] );
+            if( x + r + 1 < width ) add( x + r + 1 );
+            if( x - r >= 0 )        sub( x - r );
+        }
+    }
+
+    void _box_h( const ImageView& src, const ImageView& dst ) const {
+        src.parallel_for_rows( [ & ] ( int32_t lo, int32_t hi ) -> void {
+            for( int32_t y = lo; y < hi; ++y ) {
+                switch( src.channels ) {
+                    case 1:  this->_box_h_row< 1 >( src.row( y ), dst.row( y ), src.width ); break;
+                    case 2:  this->_box_h_row< 2 >( src.row( y ), dst.row( y ), src.width ); break;
+                    case 3:  this->_box_h_row< 3 >( src.row( y ), dst.row( y ), src.width ); break;
+                    default: this->_box_h_row< 4 >( src.row( y ), dst.row( y ), src.width ); break;
+                }
+            }
+        }, 8, *_pool );
+    }
+
+    static void _acc_add( int32_t* acc, const ubyte_t* row, size_t n ) {
+        size_t at = 0;
+    #if defined( _ENGINE_AVX )
+        for( ; at + 8 <= n; at += 8 ) {
+            __m256i a = _mm256_loadu_si256( ( const __m256i* )( acc + at ) );
+            a = _mm256_add_epi32( a, _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i* )( row + at ) ) ) );
+            _mm256_storeu_si256( ( __m256i* )( acc + at ), a );
+        }
+    #endif
+        for( ; at < n; ++at ) acc[ at ] += row[ at ];
+    }
+
+    static void _acc_sub( int32_t* acc, const ubyte_t* row, size_t n ) {
+        size_t at = 0;
+    #if defined( _ENGINE_AVX )
+        for( ; at + 8 <= n; at += 8 ) {
+            __m256i a = _mm256_loadu_si256( ( const __m256i* )( acc + at ) );
+            a = _mm256_sub_epi32( a, _mm256_cvtepu8_epi32( _mm_loadl_epi64( ( const __m128i* )( row + at ) ) ) );
+            _mm256_storeu_si256( ( __m256i* )( acc + at ), a );
+        }
+    #endif
+        for( ; at < n; ++at ) acc[ at ] -= row[ at ];
+    }
+
+    static void _acc_emit( const int32_t* acc, ubyte_t* row, size_t n, uint32_t mul ) {
+        size_t at = 0;
+    #if defined( _ENGINE_AVX )
+        const __m256i vmul  = _mm256_set1_epi32( mul );
+        const __m256i vhalf = _mm256_set1_epi32( 1 << 23 );
+
+        for( ; at + 8 <= n; at += 8 ) {
+            __m256i q = _mm256_loadu_si256( ( const __m256i* )( acc + at ) );
+            q = _mm256_srli_epi32( _mm256_add_epi32( _mm256_mullo_epi32( q, vmul ), vhalf ), 24 );
+
+            __m128i w = _mm_packus_epi32( _mm256_castsi256_si128( q ), _mm256_extracti128_si256( q, 1 ) );
+            _mm_storel_epi64( ( __m128i* )( row + at ), _mm_packus_epi16( w, w ) );
+        }
+    #endif
+        for( ; at < n; ++at ) row[ at ] = ( ubyte_t )( ( ( uint32_t )acc[ at ] * mul + ( 1u << 23 ) ) >> 24 );
+    }
+
+    void _box_v( const ImageView& src, const ImageView& dst ) const {
+        const int32_t r      = _radius;
+        const int32_t height = src.height;
+
+        _pool->parallel_for( 0, src.row_size(), 512, [ & ] ( int64_t lo, int64_t hi ) -> void {
+            const size_t                n   = hi - lo;
+            std::vector< int32_t >      acc( n, 0 );
+
+            for( int32_t y = 0; y <= std::min( r, height - 1 ); ++y )
+                _acc_add( acc.data(), src.row( y ) + lo, n );
+
+            for( int32_t y = 0; y < height; ++y ) {
+                _acc_emit( acc.data(), dst.row( y ) + lo, n, _mul[ std::min( y + r, height - 1 ) - std::max( y - r, 0 ) + 1 ] );
+
+                if( y + r + 1 < height ) _acc_add( acc.data(), src.row( y + r + 1 ) + lo, n );
+                if( y - r >= 0 )         _acc_sub( acc.data(), src.row( y - r ) + lo, n );
+            }
+        } );
+    }
+
+public:
+    int32_t radius() const { return _radius; }
+
+    BLUR_KIND kind() const { return _kind; }
+
+    /* How far, in pixels, the value of one pixel spreads. */
+    int32_t reach() const { return _radius * _kind; }
+
+public:
+    /* Blurs the whole image, in place. */
+    BlurEngine& operator () ( const ImageView& img ) {
+        return this->operator()( img, BlurMask::full( img.width, img.height ) );
+    }
+
+    /* Blurs the pixels under the mask, in place. The rest of the image feeds the window but stays as is. */
+    BlurEngine& operator () ( const ImageView& img, const BlurMask& mask ) {
+        if( !img || mask.empty() || _radius == 0 ) return *this;
+
+        IXT_ZONE( "BlurEngine::blur" );
+
+        const int32_t   reach = this->reach();
+        const int32_t   rx0   = std::max( mask.x0 - reach, 0 );
+        const int32_t   ry0   = std::max( mask.y0 - reach, 0 );
+        const ImageView roi   = img.sub( rx0, ry0, std::min( mask.x1 + reach, img.width ) - rx0, std::min( mask.y1 + reach, img.height ) - ry0 );
+
+        const size_t plane = roi.row_size() * roi.height;
+        _scratch.resize( 2 * plane );
+
+        const ImageView a{ .base = _scratch.data(),         .stride = ( ptrdiff_t )roi.row_size(), .width = roi.width, .height = roi.height, .channels = roi.channels };
+        const ImageView b{ .base = _scratch.data() + plane, .stride = ( ptrdiff_t )roi.row_size(), .width = roi.width, .height = roi.height, .channels = roi.channels };
+
+        this->_box_h( roi, a );
+        this->_box_v( a, b );
+
+        for( int pass = 1; pass < _kind; ++pass ) {
+            this->_box_h( b, a );
+            this->_box_v( a, b );
+        }
+
+        const size_t C = img.channels;
+
+        img.sub( mask.x0, mask.y0, mask.x1 - mask.x0, mask.y1 - mask.y0 ).parallel_for_rows( [ & ] ( int32_t lo, int32_t hi ) -> void {
+            for( int32_t y = lo; y < hi; ++y ) {
+                const int32_t  gy  = mask.y0 + y;
+                ubyte_t*       out = img.row( gy );
+                const ubyte_t* in  = b.row( gy - ry0 );
+
+                for( int32_t gx = mask.x0; gx < mask.x1; ++gx )
+                    if( mask( gx, gy ) )
+                        std::memcpy( out + gx * C, in + ( gx - rx0 ) * C, C );
+            }
+        }, 16, *_pool );
+
+        return *this;
+    }
+
+};
@@ -6,63 +6,265 @@ using namespace IXT;
 
 #include <deque>
 
+#include "blur.hpp"
+
 
 enum BLUR_BMP_RESULT {
     BLUR_BMP_RESULT_OK
 };
 
-dword_t blur_bmp_main_proc( Endec::Bmp& bmp, const auto& range ) {
-    int      tmp_buf_sz = ( bmp.width * bmp.bytes_ps + bmp.padding ) * bmp.height;
-    ubyte_t* tmp_buf    = ( ubyte_t* )malloc( tmp_buf_sz );
+dword_t blur_bmp_main_proc( Endec::Bmp& bmp, const auto& range, int32_t radius = 7, BLUR_KIND kind = BLUR_KIND_BOX ) {
+    IXT_ZONE( "Blur-tool::blur_bmp" );
 
-    memcpy( ( void* )tmp_buf, bmp.buffer + bmp.data_ofs, tmp_buf_sz );
+    ImageView view = bmp.view();
+    BlurMask  mask = BlurMask::of( view.width, view.height, range );
 
-    struct RCOff {
-        int r; int c;
-    };
-    std::deque< RCOff > shfs;
+    BlurEngine{ radius, kind }( view, mask );
+
+    return BLUR_BMP_RESULT_OK;
+}
 
-    int w_sz = 15;
 
-    for( int n = 0; n < w_sz; ++n )
-        for( int m = 0; m < w_sz; ++m )
-            shfs.emplace_back( RCOff{ r: w_sz / 2 - n, c: w_sz / 2 - m } );
+struct CmdArgs : Descriptor {
+    IXT_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "CmdArgs" );
+
+    CmdArgs( int argc, char* argv[], IXT::DWORD* result, IXT_COMMS_ECHO_ARG ) {
+        static const struct Opt {
+            enum C {
+                C_NULL    = 0,
+                C_IN      = 1,
+                C_REGIONS = 2,
+                C_RADIUS  = 3,
+                C_OUT     = 4,
+                C_THREADS = 5,
+                C_GAUSS   = 6
+            };
+
+            const char*   name;
+            int           c;
+            bool          arg;
+        } opts[] = {
+            { name: "--in", c: Opt::C_IN, arg: true },
+            { name: "--regions", c: Opt::C_REGIONS, arg: true },
+            { name: "--radius", c: Opt::C_RADIUS, arg: true },
+            { name: "--out", c: Opt::C_OUT, arg: true },
+            { name: "--threads", c: Opt::C_THREADS, arg: true },
+            { name: "--gauss", c: Opt::C_GAUSS, arg: false },
+            { name: "", c: Opt::C_NULL, arg: false }
+        };
+
+        *result = 1;
+
+        for( int arg_idx = 1; arg_idx < argc; ++arg_idx ) {
+            bool known = false;
 
-    for( int row = 0; row < bmp.height; ++row ) {
-        for( int col = 0; col < bmp.width; ++col ) {
-            for( int ch = 0; ch < 3; ++ch ) {
-                bool caged = false;
+            for( auto& opt : opts ) {
+                if( strcmp( argv[ arg_idx ], opt.name ) != 0 )
+                    continue;
 
-                for( auto& reg : range )
-                    caged |= reg.contains( Vec2{ ( ggfloat_t )col, ( ggfloat_t )row } );
-                
-                if( !caged ) continue;
+                known = true;
+
+                if( arg_idx + opt.arg == argc ) {
+                    echo( this, ECHO_LEVEL_ERROR ) << "No arg: " << opt.name << ".";
+                    return;
+                }
 
-                uint32_t acc = 0.0;
+                switch( opt.c ) {
+                    case Opt::C_IN: {
+                        in = argv[ arg_idx + 1 ];
+                        echo( this, ECHO_LEVEL_OK ) << "Detected input: \"" << in << "\".";
+                    break; }
+
+                    case Opt::C_REGIONS: {
+                        /* Every argument up to the next option is a region file. */
+                        for( ; arg_idx + 1 < argc && !std::string_view{ argv[ arg_idx + 1 ] }.starts_with( "--" ); ++arg_idx ) {
+                            regions.emplace_back( argv[ arg_idx + 1 ] );
+                            echo( this, ECHO_LEVEL_OK ) << "Detected region: \"" << regions.back() << "\".";
+                        }
+                        --arg_idx;
+                    break; }
+
+                    case Opt::C_RADIUS: {
+                        radius = strtol( argv[ arg_idx + 1 ], nullptr, 0xA );
+                        echo( this, ECHO_LEVEL_OK ) << "Detected radius: " << radius << ".";
+                    break; }
+
+                    case Opt::C_OUT: {
+                        out = argv[ arg_idx + 1 ];
+                        echo( this, ECHO_LEVEL_OK ) << "Detected output: \"" << out << "\".";
+                    break; }
+
+                    case Opt::C_THREADS: {
+                        threads = strtol( argv[ arg_idx + 1 ], nullptr, 0xA );
+                        echo( this, ECHO_LEVEL_OK ) << "Detected thread count: " << threads << ".";
+                    break; }
 
-                for( auto shf : shfs ) {
-                    int fr = row + shf.r; if( fr < 0 || fr >= bmp.height ) continue;
-                    int fc = col + shf.c; if( fc < 0 || fc >= bmp.width ) continue;
+                    case Opt::C_GAUSS: {
+                        kind = BLUR_KIND_GAUSS;
+                        echo( this, ECHO_LEVEL_OK ) << "Detected gaussian request.";
+                    break; }
+                }
 
-                    acc += bmp[ fr ][ bmp.bytes_ps * fc + ch ];
-                } 
+                arg_idx += opt.arg;
 
-                ptrdiff_t ofs = &bmp[ row ][ bmp.bytes_ps * col + ch ] - ( ubyte_t* )bmp.buffer - bmp.data_ofs;
+                break;
+            }
 
-                *( tmp_buf + ofs ) = acc / shfs.size();
+            if( !known ) {
+                echo( this, ECHO_LEVEL_ERROR ) << "Unknown arg: \"" << argv[ arg_idx ] << "\".";
+                return;
             }
         }
+
+        if( IXT::UBYTE sit = ( in.empty() << 1 ) | out.empty(); sit != 0b00 ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "No " << ( ( ( sit >> 1 ) & 1 ) ? "input." : "output." );
+            return;
+        }
+
+        if( regions.empty() ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "No regions.";
+            return;
+        }
+
+        if( radius <= 0 || threads < 0 ) {
+            echo( this, ECHO_LEVEL_ERROR ) << "Ill-formed radius ( " << radius << " ) or thread count ( " << threads << " ).";
+            return;
+        }
+
+        *result = 0;
     }
 
-    memcpy( bmp.buffer + bmp.data_ofs, ( void* )tmp_buf, tmp_buf_sz );
+    std::string                 in        = {};
+    std::string                 out       = {};
+    std::deque< std::string >   regions   = {};
+    int32_t                     radius    = 7;
+    int32_t                     threads   = 0;
+    BLUR_KIND                   kind      = BLUR_KIND_BOX;
+};
 
-    free( tmp_buf );
 
-    return BLUR_BMP_RESULT_OK;
+/*
+Headless mode. Images go through a read -> blur -> write pipeline: the next image loads and the previous
+one saves while the current one blurs.
+*/
+int blur_cli_main( int argc, char* argv[] ) {
+    IXT::DWORD result = 0;
+
+    CmdArgs cmd_args{ argc, argv, &result };
+    
+    if( result != 0 ) {
+        comms( ECHO_LEVEL_ERROR ) << "Cmd line args ill-formed. Aborted.\n";
+        return 1;
+    }
+
+    struct Job {
+        std::string   in;
+        std::string   out;
+    };
+
+    std::vector< Job > jobs = {};
+
+    if( std::filesystem::is_directory( cmd_args.in ) ) {
+        std::filesystem::create_directories( cmd_args.out );
+
+        File::for_each_in_dir_matching( cmd_args.in.c_str(), "\\.bmp$", [ & ] ( std::string_view mch ) -> IXT::DWORD {
+            jobs.emplace_back( Job{ in: cmd_args.in + '/' + mch.data(), out: cmd_args.out + '/' + mch.data() } );
+            return FILE_FEIDM_RESULT_ITR_CONTINUE;
+        } );
+    } else {
+        jobs.emplace_back( Job{ in: cmd_args.in, out: cmd_args.out } );
+    }
+
+    if( jobs.empty() ) {
+        comms( ECHO_LEVEL_WARNING ) << "No images under: \"" << cmd_args.in << "\".\n";
+        return 0;
+    }
+
+    std::deque< Clust2 > regz = {};
+    for( auto& path : cmd_args.regions )
+        regz.emplace_back( path.c_str() );
+
+    UPtr< ThreadPool > own_pool = cmd_args.threads > 0 ? std::make_unique< ThreadPool >( cmd_args.threads ) : nullptr;
+    ThreadPool&        pool     = own_pool ? *own_pool : ThreadPool::shared();
+
+    BlurEngine blur{ cmd_args.radius, cmd_args.kind, pool };
+
+    auto read = [] ( std::string path ) -> std::pair< UPtr< Endec::Bmp >, double > {
+        IXT_ZONE( "Blur-tool::read" );
+
+        Ticker tick{};
+        auto bmp = std::make_unique< Endec::Bmp >( path );
+        return { std::move( bmp ), tick.lap< TICK_MILLIS >() };
+    };
+
+    auto write = [] ( UPtr< Endec::Bmp > bmp, std::string path ) -> double {
+        IXT_ZONE( "Blur-tool::write" );
+
+        Ticker tick{};
+        bmp->write_file( path );
+        return tick.lap< TICK_MILLIS >();
+    };
+
+    struct Timing {
+        size_t   idx        = 0;
+        double   read_ms    = 0.0;
+        double   mask_ms    = 0.0;
+        double   blur_ms    = 0.0;
+    };
+
+    auto report = [ & ] ( const Timing& t, double write_ms ) -> void {
+        comms() << "[ " << t.idx + 1 << "/" << jobs.size() << " ] \"" << jobs[ t.idx ].in << "\" | "
+                << "read " << t.read_ms << "ms | mask " << t.mask_ms << "ms | blur " << t.blur_ms << "ms | write " << write_ms << "ms.\n";
+    };
+
+    auto   next_read  = std::async( std::launch::async, read, jobs[ 0 ].in );
+    auto   last_write = std::future< double >{};
+    Timing last       = {};
+    Ticker total      = {};
+
+    for( size_t idx = 0; idx < jobs.size(); ++idx ) {
+        auto [ bmp, read_ms ] = next_read.get();
+
+        if( idx + 1 < jobs.size() )
+            next_read = std::async( std::launch::async, read, jobs[ idx + 1 ].in );
+
+        if( bmp->buffer == nullptr ) {
+            comms( ECHO_LEVEL_WARNING ) << "Could NOT read: \"" << jobs[ idx ].in << "\". Proceeding.\n";
+            continue;
+        }
+
+        Timing timing{ idx: idx, read_ms: read_ms };
+        Ticker tick{};
+
+        ImageView view = bmp->view();
+        BlurMask  mask = BlurMask::of( view.width, view.height, regz, pool );
+        timing.mask_ms = tick.lap< TICK_MILLIS >();
+
+        blur( view, mask );
+        timing.blur_ms = tick.lap< TICK_MILLIS >();
+
+        if( last_write.valid() ) 
+            report( last, last_write.get() );
+
+        last_write = std::async( std::launch::async, write, std::move( bmp ), jobs[ idx ].out );
+        last       = timing;
+    }
+
+    if( last_write.valid() )
+        report( last, last_write.get() );
+
+    comms() << "Done " << jobs.size() << " images in " << total.lap() << "s.\n";
+
+    IXT_ZONE_DUMP( "blur-tool.trace.json" );
+
+    return 0;
 }
 
 
 int main( int argc, char* argv[] ) {
+    if( argc > 1 ) 
+        return blur_cli_main( argc, argv );
+
     Surface surf{ "Blur-tool", { .0, .0 }, { std::min( Env::w<2.>(), Env::h<2.>() ) }, SURFACE_THREAD_ACROSS, SURFACE_STYLE_LIQUID };
 
     Endec::Bmp           bmp  = {};
@@ -177,9 +379,12 @@ l_end:
         }
     } };
 
-    while( !surf.down( SurfKey::ESC ) ) {
-        std::this_thread::sleep_for( std::chrono::milliseconds{ 1000 } );
-    }
+    FramePacer pacer{ 20.0, std::chrono::nanoseconds{ 0 } };
+
+    while( !surf.down( SurfKey::ESC ) )
+        pacer.wait();
 
     render_th.join();
+
+    IXT_ZONE_DUMP( "blur-tool.trace.json" );
 }
\ No newline at end of file
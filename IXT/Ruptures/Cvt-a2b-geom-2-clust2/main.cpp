@@ -115,15 +115,26 @@ IXT::DWORD cvt_path(
     bool               norm,
     const std::string& rel 
 ) {
-    File::for_each_in_dir_matching( src_dir.c_str(), rel.c_str(), [ & ] ( std::string_view mch ) -> IXT::DWORD {
-        auto abs_path = src_dir + '/' + mch.data();
+    static struct _Invoker : Descriptor {
+        IXT_DESCRIPTOR_STRUCT_NAME_OVERRIDE( "cvt_path" );
+    } invoker;
+
+    /* 
+    Every match is converted on its own, so they are spread over the pool. Each gathers its lines in an echo of its
+    own, which goes out whole, under the comms lock, once the match is done.
+    */
+    File::scan( src_dir, File::Pattern::regex( rel ), [ & ] ( const std::filesystem::path& match_path ) -> IXT::DWORD {
+        Echo             echo     = {};
+        std::string      match    = match_path.filename().string();
+        std::string_view mch      = match;
+        auto             abs_path = match_path.string();
         
-        comms( ECHO_LEVEL_PENDING ) << "Matched: \"" << abs_path.c_str() << "\".";
+        echo( invoker, ECHO_LEVEL_PENDING ) << "Matched: \"" << abs_path.c_str() << "\".";
 
         std::ifstream in_file{ abs_path };
 
         if( !in_file ) {
-            comms( ECHO_LEVEL_WARNING ) << "Fault opening for read. Proceeding.";
+            echo( invoker, ECHO_LEVEL_WARNING ) << "Fault opening for read. Proceeding.";
             goto l_end;
         }
     {
@@ -144,7 +155,7 @@ IXT::DWORD cvt_path(
         in_file.close();
 
         if( vrtxs.size() & 0x1 ) {
-            comms( ECHO_LEVEL_WARNING ) << "Odd vertex count in source ( " << vrtxs.size() << " ). Check the file. Proceeding.";
+            echo( invoker, ECHO_LEVEL_WARNING ) << "Odd vertex count in source ( " << vrtxs.size() << " ). Check the file. Proceeding.";
             goto l_end;
         }
 
@@ -164,7 +175,7 @@ IXT::DWORD cvt_path(
         std::ofstream out_file{ abs_path.c_str() };
 
         if( !out_file ) {
-            comms( ECHO_LEVEL_WARNING ) << "Fault opening for write: \"" << abs_path.c_str() << "\". Proceeding";
+            echo( invoker, ECHO_LEVEL_WARNING ) << "Fault opening for write: \"" << abs_path.c_str() << "\". Proceeding";
             goto l_end;
         }
 
@@ -184,7 +195,7 @@ IXT::DWORD cvt_path(
 
         out_file.close();
 
-        comms() << "Match cvt done: " << abs_path.c_str() << ".\n";
+        echo( invoker, ECHO_LEVEL_INTEL ) << "Match cvt done: " << abs_path.c_str() << ".";
     }
     l_end:
         return FILE_FEIDM_RESULT_ITR_CONTINUE;
@@ -2,6 +2,7 @@
 */
 
 #include <IXT/ring-0.hpp>
+#include <IXT/compositor.hpp>
 using namespace IXT;
 
 
@@ -11,39 +12,52 @@ int main( int argc, char* argv[] ) {
         return -1;
     }
 
-    Endec::Bmp r{ argv[ 1 ] };
-    int32_t w = r.width;
-    int32_t h = r.height;
+    /* Bands of rows are streamed through, none of the bitmaps is ever held whole. */
+    constexpr int32_t BAND_ROWS = 256;
 
-    Endec::Bmp g{ argv[ 2 ] };
-    if( g.width != w || g.height != h ) {
+    Endec::BmpReader r{ argv[ 1 ], BAND_ROWS };
+    Endec::BmpReader g{ argv[ 2 ], BAND_ROWS };
+    Endec::BmpReader b{ argv[ 3 ], BAND_ROWS };
+
+    if( !r || !g || !b ) return -1;
+
+    int32_t w = r.width();
+    int32_t h = r.height();
+
+    if( g.width() != w || g.height() != h ) {
         comms( ECHO_LEVEL_ERROR ) << "Bitmaps ( R, G ) widths and heights don't match.";
         return -1;
     }
 
-    Endec::Bmp b{ argv[ 3 ] };
-    if( b.width != w || b.height != h ) {
+    if( b.width() != w || b.height() != h ) {
         comms( ECHO_LEVEL_ERROR ) << "Bitmaps ( R, B ) widths and heights don't match.";
         return -1;
     }
 
-    for( int32_t y = 0; y < h; ++y ) {
-        for( int32_t x = 0; x < w; ++x ) {
-            ubyte_t& rr = *( r[ y ] + r.bytes_ps * x + 2 );
-            ubyte_t  rg = *( r[ y ] + r.bytes_ps * x + 1 );
-            ubyte_t  rb = *( r[ y ] + r.bytes_ps * x + 0 );
+    Endec::BmpWriter out{ argv[ 4 ], w, h, r.bytes_ps(), r.top_down() };
+    if( !out ) return -1;
+
+    /* B from b, G from g, R set where r's own B and G both differ from them. Written back into r's band. */
+    Compositor compositor{ r.bytes_ps() };
+    compositor
+    .copy( 0, 2, 0 )
+    .copy( 1, 1, 1 )
+    .diff_mask( 2, {
+        CompositeTerm{ lhs_src: 0, lhs_ch: 0, rhs_src: 2, rhs_ch: 0 },
+        CompositeTerm{ lhs_src: 0, lhs_ch: 1, rhs_src: 1, rhs_ch: 1 }
+    } );
+
+    while( r.rows_left() > 0 ) {
+        const ImageView inputs[] = { r.next(), g.next(), b.next() };
+
+        if( !inputs[ 0 ] || !inputs[ 1 ] || !inputs[ 2 ] ) return -1;
 
-            ubyte_t bv = ( *( r[ y ] + r.bytes_ps * x + 0 ) = *( b[ y ] + b.bytes_ps * x + 0 ) );
-            ubyte_t gv = ( *( r[ y ] + r.bytes_ps * x + 1 ) = *( g[ y ] + g.bytes_ps * x + 1 ) );
+        if( !compositor.run( inputs, inputs[ 0 ] ) ) return -1;
 
-            if( abs( rb - bv ) > 0.1 && abs( rg - gv ) > 0.1)
-                rr = 255;
-            else
-                rr = 0;
-        }
+        out.push( inputs[ 0 ] );
     }
 
-    r.write_file( argv[ 4 ] );
+    out.close();
 
     comms( ECHO_LEVEL_OK ) << "Done.";
 
@@ -60,6 +60,8 @@ struct _IMM : Descriptor {
     Ticker   cinematic_tick   = {};
     float    cinematic_wy     = 0.24;
 
+    TimerMailbox   timers   = {};
+
     struct _UFRM {
         _UFRM()
         : view{ "view", PIMM->lens.view() },
@@ -83,9 +85,15 @@ struct _IMM : Descriptor {
         : pos{ "sun_pos", glm::vec3{ 0.0, 0.0, 180.0 } }
         {
             this->_load_rt_pos();
+
+            timer = TimerWheel::shared().every( std::chrono::seconds{ 60 }, [ this ] () -> void { this->_load_rt_pos(); }, PIMM->timers );
+        }
+
+        ~_SUN() {
+            TimerWheel::shared().cancel( timer );
         }
 
-        Ticker                  tick;
+        TimerId                 timer;
         Uniform3< glm::vec3 >   pos;
 
         void _load_rt_pos() {
@@ -93,14 +101,6 @@ struct _IMM : Descriptor {
             pos.uplink_bv( glm::vec3{ astro::nrm_from_lat_long( ll ) * 180.0f } );
         }
 
-        _SUN& refresh( float elapsed ) {
-            if( tick.cmpxchg_lap( 60.0 ) ) {
-                this->_load_rt_pos();
-            }
-
-            return *this;
-        }
-
     } sun;
 
     struct _EARTH {
@@ -157,9 +157,16 @@ struct _IMM : Descriptor {
             for( auto& s : noaa ) {
                 s.mesh.pipe->pull( PIMM_UFRM->sat_high );
             }
+
+            timer = TimerWheel::shared().every( std::chrono::seconds{ 1 }, [ this ] () -> void { this->advance_poss(); }, PIMM->timers );
+        }
+
+        ~_SATS() {
+            TimerWheel::shared().cancel( timer );
         }
 
         Ticker            tick;
+        TimerId           timer;
         std::thread       hth_update;
         std::atomic_int   required_update_count   = 0;
 
@@ -292,28 +299,24 @@ struct _IMM : Descriptor {
             hth_update.join();
         }
         
-        _SATS& refresh( float elapsed ) {
-            if( tick.cmpxchg_lap( 1.0 ) ) {
-                for( int idx = 0; idx < 3; ++idx ) {
-                    _SAT_NOAA& s = noaa[ idx ];
-
-                    std::unique_lock lock{ s.pos_cnt_mtx, std::defer_lock_t{} };
-
-                    if( !lock.try_lock() ) continue;
-
-                    if( s.pos_cnt.empty() ) {
-                        s.pos_cnt_update_required.store( true, std::memory_order_seq_cst );
-                        required_update_count.fetch_add( 1, std::memory_order_seq_cst );
-                        required_update_count.notify_one();
-                    } else {
-                        s.advance_pos();
-                        PIMM->earth.sat_poss.get()[ idx ] = s.pos; /* ( &s - noaa ) / sizeof( _SAT_NOAA ) - always 0, why Ahri? */
-                    }
+        void advance_poss() {
+            for( int idx = 0; idx < 3; ++idx ) {
+                _SAT_NOAA& s = noaa[ idx ];
+
+                std::unique_lock lock{ s.pos_cnt_mtx, std::defer_lock_t{} };
+
+                if( !lock.try_lock() ) continue;
+
+                if( s.pos_cnt.empty() ) {
+                    s.pos_cnt_update_required.store( true, std::memory_order_seq_cst );
+                    required_update_count.fetch_add( 1, std::memory_order_seq_cst );
+                    required_update_count.notify_one();
+                } else {
+                    s.advance_pos();
+                    PIMM->earth.sat_poss.get()[ idx ] = s.pos; /* ( &s - noaa ) / sizeof( _SAT_NOAA ) - always 0, why Ahri? */
                 }
-                PIMM->earth.sat_poss.uplink_b();
             }
-
-            return *this;
+            PIMM->earth.sat_poss.uplink_b();
         }
 
         _SATS& splash( float elapsed ) {
@@ -864,6 +867,8 @@ struct _IMM : Descriptor {
 
 
     _IMM& refresh( float elapsed ) {
+        IXT_ZONE( "EARTH::refresh" );
+
         if( cinematic == 1 ) {
             lens.spin_ul( { cinematic_wy * elapsed, cos( cinematic_tick.peek_lap() / 2.2 ) * 0.001 }, { -82.0, 82.0 } );
         } else if( cinematic == 2 ) {
@@ -871,8 +876,7 @@ struct _IMM : Descriptor {
         }
 
 
-        sun.refresh( elapsed );
-        sats.refresh( elapsed );
+        timers.drain();
 
         for( int idx = 0; idx < 3; ++idx ) {
             auto& s = sats.noaa[ idx ];
@@ -904,6 +908,8 @@ struct _IMM : Descriptor {
     }
 
     _IMM& splash( float elapsed ) {            
+        IXT_ZONE( "EARTH::splash" );
+
         rend.downlink_face_culling();
         galaxy.mesh.splash();
         rend.uplink_face_culling();
@@ -952,6 +958,8 @@ int EARTH::main( int argc, char* argv[] ) {
     Ticker tick;
    
     while( !imm.surf.down( SurfKey::ESC ) ) {
+        IXT_ZONE( "EARTH::frame" );
+
         float elapsed = tick.lap();
         
         imm.rend.clear( glm::vec4{ 0.0, 0.0, 0.0, 1.0 } );
@@ -963,6 +971,8 @@ int EARTH::main( int argc, char* argv[] ) {
     imm.sats.join_th_update();
     imm.surf.downlink();
 
+    IXT_ZONE_DUMP( "earth.trace.json" );
+
     _impl_earth = nullptr;
 
     return 0;
@@ -18,21 +18,17 @@ int _N2YO::burn_api_key( const char* key, const char* process ) {
     int key_len = strlen( key );
     WARC_ASSERT_RT( key_len <= API_KEY_ASH_LEN - API_KEY_ASH_SIG_LEN, "Key too long to burn.", key_len, -1 );
 
-    std::ifstream file_read{ process, std::ios_base::binary };
-    WARC_ASSERT_RT( file_read, "Could not open process file for read.", -1, -1 );
+    WARC_ASSERT_RT( IXT::File::byte_count( process ) != 0, "The process' file where to burn the key has a size of 0 bytes.", -1, -1 );
 
-    auto sz = IXT::File::byte_count( file_read );
-    WARC_ASSERT_RT( sz != 0, "The process' file where to burn the key has a size of 0 bytes.", -1, -1 );
+    IXT::File::Map mirror{ process, IXT::FILE_MAP_MODE_COPY_ON_WRITE };
+    WARC_ASSERT_RT( mirror, "Could not map process file for read.", -1, -1 );
 
-    IXT::UPtr< char[] > buffer{ ( char* )malloc( sz ) };
-    WARC_ASSERT_RT( buffer, "Could not allocate for the process file read.", -1, -1 );
-
-    file_read.read( buffer.get(), sz );
-    file_read.close();
+    char*  buffer = ( char* )mirror.mutable_data();
+    size_t sz     = mirror.size();
 
     WARC_ECHO_RT_INTEL << "Process file mirrored.";
 
-    std::string_view  buf_view{ buffer.get(), sz };
+    std::string_view  buf_view{ buffer, sz };
     std::string       cmp{ API_KEY_ASH, API_KEY_ASH_SIG_LEN }; 
 
     auto pos = buf_view.find( cmp.c_str() );
@@ -46,8 +42,8 @@ int _N2YO::burn_api_key( const char* key, const char* process ) {
 
     WARC_ECHO_RT_INTEL << "Burning into process file mirror.";
 
-    char* ash_begin = buffer.get() + pos + API_KEY_ASH_SIG_LEN;
-    char* ash_end   = buffer.get() + pos + API_KEY_ASH_LEN;
+    char* ash_begin = buffer + pos + API_KEY_ASH_SIG_LEN;
+    char* ash_end   = buffer + pos + API_KEY_ASH_LEN;
     {
     int idx = 0;
     for( ; ( ash_begin + idx < ash_end ) && ( idx < strlen( key ) ); ++idx )
@@ -67,7 +63,7 @@ int _N2YO::burn_api_key( const char* key, const char* process ) {
         return -1;
     }
 
-    file_write.write( buffer.get(), sz );
+    file_write.write( buffer, sz );
     file_write.close();
 
     WARC_ECHO_RT_OK << "Burnt key into \"" << mirror_process << "\".";
@@ -82,21 +78,15 @@ std::string _N2YO::extract_api_key( const char* process ) {
 
     WARC_ECHO_RT_INTEL << "Extracting key from \"" << process << "\".";
 
-    std::ifstream file_read{ process, std::ios_base::binary };
-    WARC_ASSERT_RT( file_read, "Could not open process file.", -1, "" );
+    IXT::File::Map file{ process };
+    WARC_ASSERT_RT( file, "Could not map process file.", -1, "" );
 
-    auto sz = IXT::File::byte_count( file_read );
+    auto sz = file.size();
     WARC_ASSERT_RT( sz > API_KEY_ASH_LEN, "Cannot extract key from a file smaller than the key itself.", sz, "" );
 
-    IXT::UPtr< char[] > buffer{ ( char* )malloc( sz ) };
-    WARC_ASSERT_RT( buffer, "Could not allocate for the process file read.", -1, "" );
-
-    file_read.read( buffer.get(), sz );
-    file_read.close();
-
-    WARC_ECHO_RT_INTEL << "Process file read.";
+    WARC_ECHO_RT_INTEL << "Process file mapped.";
 
-    std::string_view  buf_view{ buffer.get(), sz };
+    std::string_view  buf_view = file.view();
     std::string       cmp{ API_KEY_ASH, API_KEY_ASH_SIG_LEN }; 
 
     auto pos = buf_view.find( cmp.c_str() );
@@ -110,8 +100,8 @@ std::string _N2YO::extract_api_key( const char* process ) {
 
     std::string key; key.reserve( API_KEY_ASH_LEN - API_KEY_ASH_SIG_LEN );
 
-    for( int idx = 0; ( buffer[ pos + idx ] != '\0' ) && ( idx < API_KEY_ASH_LEN - API_KEY_ASH_SIG_LEN ); ++idx )
-        key += buffer[ pos + API_KEY_ASH_SIG_LEN + idx ];
+    for( int idx = 0; ( buf_view[ pos + idx ] != '\0' ) && ( idx < API_KEY_ASH_LEN - API_KEY_ASH_SIG_LEN ); ++idx )
+        key += buf_view[ pos + API_KEY_ASH_SIG_LEN + idx ];
 
     WARC_ECHO_RT_OK << "Extracted key.";
 
@@ -6,6 +6,7 @@
 
 #include <IXT/render3.hpp>
 #include <IXT/tempo.hpp>
+#include <IXT/timer-wheel.hpp>
 
 namespace warc { namespace imm {
 
@@ -21,6 +21,49 @@ void Wave::play( HVEC< Wave > self ) {
     _audio->play( std::move( self ) );
 }
 
+void Wave::stop() {
+    _audio->stop( *this );
+}
+
+Wave& Wave::filter_with( Filter flt ) {
+    return this->_meta( AudioCommand{ op: AUDIO_COMMAND_FILTER, filter: std::move( flt ) } );
+}
+
+Wave& Wave::block_filter_with( SPtr< AudioFilter > flt ) {
+    return this->_meta( AudioCommand{ op: AUDIO_COMMAND_BLOCK_FILTER, block_filter: std::move( flt ) } );
+}
+
+Wave& Wave::_meta( AudioCommand&& cmd ) {
+    if( !_audio ) {
+        Audio::_apply_meta( *this, cmd );
+        return *this;
+    }
+
+    cmd.wave = HVEC< Wave >{ *this };
+    _audio->_post( std::move( cmd ) );
+    return *this;
+}
+
+Wave& Wave::_meta_value( AUDIO_COMMAND op, double value, double ( *tweak )( double, double ) ) {
+    return this->_meta( AudioCommand{ op: op, value: value, tweak: tweak } );
+}
+
+Wave& Wave::_meta_switch( AUDIO_COMMAND op, AUDIO_SWITCH flip ) {
+    return this->_meta( AudioCommand{ op: op, flip: flip } );
+}
+
+void Wave::_unvoice_wait() {
+    if( _audio ) _audio->_unvoice_wait( *this );
+}
+
+void Wave::render_block( double* out, size_t frames, WORD tunnels, double t0 ) {
+    const double step = _audio->time_step();
+
+    for( size_t frame = 0; frame < frames; ++frame, t0 += step )
+        for( WORD tunnel = 0; tunnel < tunnels; ++tunnel )
+            *out++ += this->_sample( t0, tunnel, tunnel == tunnels - 1 );
+}
+
 
 
 };
\ No newline at end of file